@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/xochip-bench.dir/bench.c.o"
+  "CMakeFiles/xochip-bench.dir/bench.c.o.d"
+  "xochip-bench"
+  "xochip-bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/xochip-bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
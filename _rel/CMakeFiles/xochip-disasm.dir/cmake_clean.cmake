@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/xochip-disasm.dir/disasm.c.o"
+  "CMakeFiles/xochip-disasm.dir/disasm.c.o.d"
+  "xochip-disasm"
+  "xochip-disasm.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/xochip-disasm.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/xochip-fuzz.dir/fuzz.c.o"
+  "CMakeFiles/xochip-fuzz.dir/fuzz.c.o.d"
+  "xochip-fuzz"
+  "xochip-fuzz.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/xochip-fuzz.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/xochip-replay.dir/replay.c.o"
+  "CMakeFiles/xochip-replay.dir/replay.c.o.d"
+  "xochip-replay"
+  "xochip-replay.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/xochip-replay.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
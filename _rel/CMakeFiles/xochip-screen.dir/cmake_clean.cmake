@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/xochip-screen.dir/screen.c.o"
+  "CMakeFiles/xochip-screen.dir/screen.c.o.d"
+  "xochip-screen"
+  "xochip-screen.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/xochip-screen.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
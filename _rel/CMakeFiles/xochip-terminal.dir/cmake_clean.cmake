@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/xochip-terminal.dir/terminal.c.o"
+  "CMakeFiles/xochip-terminal.dir/terminal.c.o.d"
+  "xochip-terminal"
+  "xochip-terminal.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/xochip-terminal.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
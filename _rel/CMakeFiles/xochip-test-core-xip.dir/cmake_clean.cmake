@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/xochip-test-core-xip.dir/tests/core.c.o"
+  "CMakeFiles/xochip-test-core-xip.dir/tests/core.c.o.d"
+  "xochip-test-core-xip"
+  "xochip-test-core-xip.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/xochip-test-core-xip.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/xochip-test-core.dir/tests/core.c.o"
+  "CMakeFiles/xochip-test-core.dir/tests/core.c.o.d"
+  "xochip-test-core"
+  "xochip-test-core.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/xochip-test-core.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
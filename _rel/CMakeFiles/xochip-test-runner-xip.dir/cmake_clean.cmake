@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/xochip-test-runner-xip.dir/tests/runner.c.o"
+  "CMakeFiles/xochip-test-runner-xip.dir/tests/runner.c.o.d"
+  "xochip-test-runner-xip"
+  "xochip-test-runner-xip.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/xochip-test-runner-xip.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
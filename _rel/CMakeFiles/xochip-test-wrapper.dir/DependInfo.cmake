@@ -0,0 +1,20 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/tests/wrapper_impl.c" "CMakeFiles/xochip-test-wrapper.dir/tests/wrapper_impl.c.o" "gcc" "CMakeFiles/xochip-test-wrapper.dir/tests/wrapper_impl.c.o.d"
+  "/root/repo/tests/wrapper.cpp" "CMakeFiles/xochip-test-wrapper.dir/tests/wrapper.cpp.o" "gcc" "CMakeFiles/xochip-test-wrapper.dir/tests/wrapper.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
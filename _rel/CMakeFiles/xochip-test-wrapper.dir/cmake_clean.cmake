@@ -0,0 +1,13 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/xochip-test-wrapper.dir/tests/wrapper.cpp.o"
+  "CMakeFiles/xochip-test-wrapper.dir/tests/wrapper.cpp.o.d"
+  "CMakeFiles/xochip-test-wrapper.dir/tests/wrapper_impl.c.o"
+  "CMakeFiles/xochip-test-wrapper.dir/tests/wrapper_impl.c.o.d"
+  "xochip-test-wrapper"
+  "xochip-test-wrapper.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C CXX)
+  include(CMakeFiles/xochip-test-wrapper.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
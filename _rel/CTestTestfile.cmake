@@ -0,0 +1,132 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo
+# Build directory: /root/repo/_rel
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
+add_test(core "/root/repo/_rel/xochip-test-core")
+set_tests_properties(core PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;43;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(core-xip "/root/repo/_rel/xochip-test-core-xip")
+set_tests_properties(core-xip PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;47;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(chip8-logo "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--expect" "cf572fe3a6c2c04d" "/root/repo/tests/1-chip8-logo.ch8")
+set_tests_properties(chip8-logo PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;64;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(chip8-logo-xip "/root/repo/_rel/xochip-test-runner-xip" "--frames" "60" "--expect" "cf572fe3a6c2c04d" "/root/repo/tests/1-chip8-logo.ch8")
+set_tests_properties(chip8-logo-xip PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;67;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(chip8-logo-decode "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--expect" "cf572fe3a6c2c04d" "--attach" "decode" "--check" "/root/repo/tests/1-chip8-logo.ch8")
+set_tests_properties(chip8-logo-decode PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;71;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(chip8-logo-sprite "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--expect" "cf572fe3a6c2c04d" "--attach" "sprite" "--check" "/root/repo/tests/1-chip8-logo.ch8")
+set_tests_properties(chip8-logo-sprite PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;74;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(chip8-logo-hash "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--expect" "cf572fe3a6c2c04d" "--attach" "hash" "--check" "/root/repo/tests/1-chip8-logo.ch8")
+set_tests_properties(chip8-logo-hash PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;77;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(chip8-logo-memo "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--expect" "cf572fe3a6c2c04d" "--memo" "64" "--check" "/root/repo/tests/1-chip8-logo.ch8")
+set_tests_properties(chip8-logo-memo PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;80;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(ibm-logo "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--expect" "5b3bdbde7da41799" "/root/repo/tests/2-ibm-logo.ch8")
+set_tests_properties(ibm-logo PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;64;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(ibm-logo-xip "/root/repo/_rel/xochip-test-runner-xip" "--frames" "60" "--expect" "5b3bdbde7da41799" "/root/repo/tests/2-ibm-logo.ch8")
+set_tests_properties(ibm-logo-xip PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;67;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(ibm-logo-decode "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--expect" "5b3bdbde7da41799" "--attach" "decode" "--check" "/root/repo/tests/2-ibm-logo.ch8")
+set_tests_properties(ibm-logo-decode PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;71;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(ibm-logo-sprite "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--expect" "5b3bdbde7da41799" "--attach" "sprite" "--check" "/root/repo/tests/2-ibm-logo.ch8")
+set_tests_properties(ibm-logo-sprite PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;74;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(ibm-logo-hash "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--expect" "5b3bdbde7da41799" "--attach" "hash" "--check" "/root/repo/tests/2-ibm-logo.ch8")
+set_tests_properties(ibm-logo-hash PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;77;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(ibm-logo-memo "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--expect" "5b3bdbde7da41799" "--memo" "64" "--check" "/root/repo/tests/2-ibm-logo.ch8")
+set_tests_properties(ibm-logo-memo PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;80;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(corax-plus "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--expect" "9d1e3586dac3cd79" "/root/repo/tests/3-corax+.ch8")
+set_tests_properties(corax-plus PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;64;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(corax-plus-xip "/root/repo/_rel/xochip-test-runner-xip" "--frames" "60" "--expect" "9d1e3586dac3cd79" "/root/repo/tests/3-corax+.ch8")
+set_tests_properties(corax-plus-xip PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;67;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(corax-plus-decode "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--expect" "9d1e3586dac3cd79" "--attach" "decode" "--check" "/root/repo/tests/3-corax+.ch8")
+set_tests_properties(corax-plus-decode PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;71;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(corax-plus-sprite "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--expect" "9d1e3586dac3cd79" "--attach" "sprite" "--check" "/root/repo/tests/3-corax+.ch8")
+set_tests_properties(corax-plus-sprite PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;74;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(corax-plus-hash "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--expect" "9d1e3586dac3cd79" "--attach" "hash" "--check" "/root/repo/tests/3-corax+.ch8")
+set_tests_properties(corax-plus-hash PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;77;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(corax-plus-memo "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--expect" "9d1e3586dac3cd79" "--memo" "64" "--check" "/root/repo/tests/3-corax+.ch8")
+set_tests_properties(corax-plus-memo PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;80;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(flags "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--expect" "4af47f7856b50229" "/root/repo/tests/4-flags.ch8")
+set_tests_properties(flags PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;64;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(flags-xip "/root/repo/_rel/xochip-test-runner-xip" "--frames" "60" "--expect" "4af47f7856b50229" "/root/repo/tests/4-flags.ch8")
+set_tests_properties(flags-xip PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;67;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(flags-decode "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--expect" "4af47f7856b50229" "--attach" "decode" "--check" "/root/repo/tests/4-flags.ch8")
+set_tests_properties(flags-decode PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;71;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(flags-sprite "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--expect" "4af47f7856b50229" "--attach" "sprite" "--check" "/root/repo/tests/4-flags.ch8")
+set_tests_properties(flags-sprite PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;74;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(flags-hash "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--expect" "4af47f7856b50229" "--attach" "hash" "--check" "/root/repo/tests/4-flags.ch8")
+set_tests_properties(flags-hash PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;77;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(flags-memo "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--expect" "4af47f7856b50229" "--memo" "64" "--check" "/root/repo/tests/4-flags.ch8")
+set_tests_properties(flags-memo PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;80;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(quirks-xochip "/root/repo/_rel/xochip-test-runner" "--frames" "300" "--keys" "5+3,8-3" "--expect" "01d9ee73b2a543d9" "/root/repo/tests/5-quirks.ch8")
+set_tests_properties(quirks-xochip PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;64;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(quirks-xochip-xip "/root/repo/_rel/xochip-test-runner-xip" "--frames" "300" "--keys" "5+3,8-3" "--expect" "01d9ee73b2a543d9" "/root/repo/tests/5-quirks.ch8")
+set_tests_properties(quirks-xochip-xip PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;67;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(quirks-xochip-decode "/root/repo/_rel/xochip-test-runner" "--frames" "300" "--keys" "5+3,8-3" "--expect" "01d9ee73b2a543d9" "--attach" "decode" "--check" "/root/repo/tests/5-quirks.ch8")
+set_tests_properties(quirks-xochip-decode PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;71;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(quirks-xochip-sprite "/root/repo/_rel/xochip-test-runner" "--frames" "300" "--keys" "5+3,8-3" "--expect" "01d9ee73b2a543d9" "--attach" "sprite" "--check" "/root/repo/tests/5-quirks.ch8")
+set_tests_properties(quirks-xochip-sprite PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;74;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(quirks-xochip-hash "/root/repo/_rel/xochip-test-runner" "--frames" "300" "--keys" "5+3,8-3" "--expect" "01d9ee73b2a543d9" "--attach" "hash" "--check" "/root/repo/tests/5-quirks.ch8")
+set_tests_properties(quirks-xochip-hash PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;77;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(quirks-xochip-memo "/root/repo/_rel/xochip-test-runner" "--frames" "300" "--keys" "5+3,8-3" "--expect" "01d9ee73b2a543d9" "--memo" "64" "--check" "/root/repo/tests/5-quirks.ch8")
+set_tests_properties(quirks-xochip-memo PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;80;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(keypad-ex9e "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--keys" "5+1,8-1,30+5" "--expect" "a580806dda46f04d" "/root/repo/tests/6-keypad.ch8")
+set_tests_properties(keypad-ex9e PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;64;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(keypad-ex9e-xip "/root/repo/_rel/xochip-test-runner-xip" "--frames" "60" "--keys" "5+1,8-1,30+5" "--expect" "a580806dda46f04d" "/root/repo/tests/6-keypad.ch8")
+set_tests_properties(keypad-ex9e-xip PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;67;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(keypad-ex9e-decode "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--keys" "5+1,8-1,30+5" "--expect" "a580806dda46f04d" "--attach" "decode" "--check" "/root/repo/tests/6-keypad.ch8")
+set_tests_properties(keypad-ex9e-decode PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;71;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(keypad-ex9e-sprite "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--keys" "5+1,8-1,30+5" "--expect" "a580806dda46f04d" "--attach" "sprite" "--check" "/root/repo/tests/6-keypad.ch8")
+set_tests_properties(keypad-ex9e-sprite PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;74;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(keypad-ex9e-hash "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--keys" "5+1,8-1,30+5" "--expect" "a580806dda46f04d" "--attach" "hash" "--check" "/root/repo/tests/6-keypad.ch8")
+set_tests_properties(keypad-ex9e-hash PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;77;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(keypad-ex9e-memo "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--keys" "5+1,8-1,30+5" "--expect" "a580806dda46f04d" "--memo" "64" "--check" "/root/repo/tests/6-keypad.ch8")
+set_tests_properties(keypad-ex9e-memo PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;80;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(keypad-fx0a "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--keys" "5+3,8-3,30+a,40-a" "--expect" "29d12f76b46152e5" "/root/repo/tests/6-keypad.ch8")
+set_tests_properties(keypad-fx0a PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;64;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(keypad-fx0a-xip "/root/repo/_rel/xochip-test-runner-xip" "--frames" "60" "--keys" "5+3,8-3,30+a,40-a" "--expect" "29d12f76b46152e5" "/root/repo/tests/6-keypad.ch8")
+set_tests_properties(keypad-fx0a-xip PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;67;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(keypad-fx0a-decode "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--keys" "5+3,8-3,30+a,40-a" "--expect" "29d12f76b46152e5" "--attach" "decode" "--check" "/root/repo/tests/6-keypad.ch8")
+set_tests_properties(keypad-fx0a-decode PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;71;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(keypad-fx0a-sprite "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--keys" "5+3,8-3,30+a,40-a" "--expect" "29d12f76b46152e5" "--attach" "sprite" "--check" "/root/repo/tests/6-keypad.ch8")
+set_tests_properties(keypad-fx0a-sprite PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;74;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(keypad-fx0a-hash "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--keys" "5+3,8-3,30+a,40-a" "--expect" "29d12f76b46152e5" "--attach" "hash" "--check" "/root/repo/tests/6-keypad.ch8")
+set_tests_properties(keypad-fx0a-hash PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;77;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(keypad-fx0a-memo "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--keys" "5+3,8-3,30+a,40-a" "--expect" "29d12f76b46152e5" "--memo" "64" "--check" "/root/repo/tests/6-keypad.ch8")
+set_tests_properties(keypad-fx0a-memo PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;80;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(beep "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--expect" "28c31cf8df2ec325" "/root/repo/tests/7-beep.ch8")
+set_tests_properties(beep PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;64;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(beep-xip "/root/repo/_rel/xochip-test-runner-xip" "--frames" "60" "--expect" "28c31cf8df2ec325" "/root/repo/tests/7-beep.ch8")
+set_tests_properties(beep-xip PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;67;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(beep-decode "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--expect" "28c31cf8df2ec325" "--attach" "decode" "--check" "/root/repo/tests/7-beep.ch8")
+set_tests_properties(beep-decode PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;71;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(beep-sprite "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--expect" "28c31cf8df2ec325" "--attach" "sprite" "--check" "/root/repo/tests/7-beep.ch8")
+set_tests_properties(beep-sprite PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;74;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(beep-hash "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--expect" "28c31cf8df2ec325" "--attach" "hash" "--check" "/root/repo/tests/7-beep.ch8")
+set_tests_properties(beep-hash PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;77;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(beep-memo "/root/repo/_rel/xochip-test-runner" "--frames" "60" "--expect" "28c31cf8df2ec325" "--memo" "64" "--check" "/root/repo/tests/7-beep.ch8")
+set_tests_properties(beep-memo PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;80;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(scrolling-xochip "/root/repo/_rel/xochip-test-runner" "--frames" "300" "--keys" "5+2,8-2,20+2,23-2" "--expect" "04c3bc59698f70b7" "/root/repo/tests/8-scrolling.ch8")
+set_tests_properties(scrolling-xochip PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;64;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(scrolling-xochip-xip "/root/repo/_rel/xochip-test-runner-xip" "--frames" "300" "--keys" "5+2,8-2,20+2,23-2" "--expect" "04c3bc59698f70b7" "/root/repo/tests/8-scrolling.ch8")
+set_tests_properties(scrolling-xochip-xip PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;67;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(scrolling-xochip-decode "/root/repo/_rel/xochip-test-runner" "--frames" "300" "--keys" "5+2,8-2,20+2,23-2" "--expect" "04c3bc59698f70b7" "--attach" "decode" "--check" "/root/repo/tests/8-scrolling.ch8")
+set_tests_properties(scrolling-xochip-decode PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;71;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(scrolling-xochip-sprite "/root/repo/_rel/xochip-test-runner" "--frames" "300" "--keys" "5+2,8-2,20+2,23-2" "--expect" "04c3bc59698f70b7" "--attach" "sprite" "--check" "/root/repo/tests/8-scrolling.ch8")
+set_tests_properties(scrolling-xochip-sprite PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;74;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(scrolling-xochip-hash "/root/repo/_rel/xochip-test-runner" "--frames" "300" "--keys" "5+2,8-2,20+2,23-2" "--expect" "04c3bc59698f70b7" "--attach" "hash" "--check" "/root/repo/tests/8-scrolling.ch8")
+set_tests_properties(scrolling-xochip-hash PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;77;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(scrolling-xochip-memo "/root/repo/_rel/xochip-test-runner" "--frames" "300" "--keys" "5+2,8-2,20+2,23-2" "--expect" "04c3bc59698f70b7" "--memo" "64" "--check" "/root/repo/tests/8-scrolling.ch8")
+set_tests_properties(scrolling-xochip-memo PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;80;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(scrolling-xochip-lores "/root/repo/_rel/xochip-test-runner" "--frames" "300" "--keys" "5+2,8-2,20+1,23-1" "--expect" "6acace58a2ba952d" "/root/repo/tests/8-scrolling.ch8")
+set_tests_properties(scrolling-xochip-lores PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;64;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(scrolling-xochip-lores-xip "/root/repo/_rel/xochip-test-runner-xip" "--frames" "300" "--keys" "5+2,8-2,20+1,23-1" "--expect" "6acace58a2ba952d" "/root/repo/tests/8-scrolling.ch8")
+set_tests_properties(scrolling-xochip-lores-xip PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;67;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(scrolling-xochip-lores-decode "/root/repo/_rel/xochip-test-runner" "--frames" "300" "--keys" "5+2,8-2,20+1,23-1" "--expect" "6acace58a2ba952d" "--attach" "decode" "--check" "/root/repo/tests/8-scrolling.ch8")
+set_tests_properties(scrolling-xochip-lores-decode PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;71;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(scrolling-xochip-lores-sprite "/root/repo/_rel/xochip-test-runner" "--frames" "300" "--keys" "5+2,8-2,20+1,23-1" "--expect" "6acace58a2ba952d" "--attach" "sprite" "--check" "/root/repo/tests/8-scrolling.ch8")
+set_tests_properties(scrolling-xochip-lores-sprite PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;74;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(scrolling-xochip-lores-hash "/root/repo/_rel/xochip-test-runner" "--frames" "300" "--keys" "5+2,8-2,20+1,23-1" "--expect" "6acace58a2ba952d" "--attach" "hash" "--check" "/root/repo/tests/8-scrolling.ch8")
+set_tests_properties(scrolling-xochip-lores-hash PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;77;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(scrolling-xochip-lores-memo "/root/repo/_rel/xochip-test-runner" "--frames" "300" "--keys" "5+2,8-2,20+1,23-1" "--expect" "6acace58a2ba952d" "--memo" "64" "--check" "/root/repo/tests/8-scrolling.ch8")
+set_tests_properties(scrolling-xochip-lores-memo PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;80;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(cpp-wrapper "/root/repo/_rel/xochip-test-wrapper" "/root/repo/tests/1-chip8-logo.ch8" "/root/repo/tests/2-ibm-logo.ch8" "/root/repo/tests/3-corax+.ch8" "/root/repo/tests/4-flags.ch8" "/root/repo/tests/5-quirks.ch8" "/root/repo/tests/6-keypad.ch8" "/root/repo/tests/7-beep.ch8" "/root/repo/tests/8-scrolling.ch8")
+set_tests_properties(cpp-wrapper PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;94;add_test;/root/repo/CMakeLists.txt;0;")
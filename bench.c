@@ -0,0 +1,313 @@
+//
+// Host benchmark for the execution core. Runs each ROM for the same number of frames three ways and reports the cost
+// per instruction:
+// - cycle:  xochip_cycle in a loop with xochip_tick every frame, the reference
+// - budget: xochip_run_budget in superloop-sized slices, like an MCU host would
+// - cached: the same with a decode cache and sprite cache attached
+// All three have to end in the same state, otherwise the ROM is reported as a mismatch.
+//
+// With --env, each ROM also runs as a batch of that many xochip_env.h instances, stepped 4 frames at a time with
+// random keys, and reports environment steps per second.
+//
+//     xochip-bench [--frames <n>] [--ipf <n>] [--slice <n>] [--env <instances>] <rom>...
+//
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define XOCHIP_IMPLEMENTATION
+#include "xochip.h"
+#include "xochip_env.h"
+#include "xochip_file.h"
+
+// Too big for the stack
+static xochip_t reference;
+static xochip_t emulator;
+static xochip_decode_cache_t decode_cache;
+static xochip_sprite_cache_t sprite_cache;
+
+typedef struct bench_options
+{
+    uint32_t frames;
+    uint32_t cycles_per_frame;
+    uint32_t slice;
+    uint32_t instances; // 0 skips the environment benchmark
+} bench_options_t;
+
+typedef struct bench_result
+{
+    double seconds;
+    uint64_t cycles;
+    uint64_t yields[3]; // indexed by xochip_yield_t
+    xochip_result_t result;
+} bench_result_t;
+
+static double elapsed(const clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static bench_result_t bench_cycle(xochip_t *machine, const bench_options_t *options)
+{
+    bench_result_t result = {0};
+    const clock_t start = clock();
+
+    for (uint32_t frame = 0; frame < options->frames && result.result == XOCHIP_SUCCESS; ++frame)
+    {
+        for (uint32_t cycle = 0; cycle < options->cycles_per_frame; ++cycle)
+        {
+            result.result = xochip_cycle(machine);
+            if (result.result != XOCHIP_SUCCESS)
+            {
+                break;
+            }
+            result.cycles++;
+        }
+
+        // present like a host would, which is what a XOCHIP_YIELD_FRAME does too
+        if (result.result == XOCHIP_SUCCESS)
+        {
+            xochip_tick(machine);
+            machine->display.updated = false;
+        }
+    }
+
+    result.seconds = elapsed(start);
+    return result;
+}
+
+static bench_result_t bench_budget(xochip_t *machine, const bench_options_t *options)
+{
+    bench_result_t result = {0};
+    xochip_scheduler_t scheduler;
+    result.result = xochip_scheduler_init(&scheduler, options->cycles_per_frame, options->cycles_per_frame / 4);
+    if (result.result != XOCHIP_SUCCESS)
+    {
+        return result;
+    }
+
+    const uint64_t total = (uint64_t)options->frames * options->cycles_per_frame;
+    const clock_t start = clock();
+
+    while (scheduler.cycles < total && result.result == XOCHIP_SUCCESS)
+    {
+        const uint64_t left = total - scheduler.cycles;
+        const uint32_t budget = left < options->slice ? (uint32_t)left : options->slice;
+
+        xochip_yield_t reason = XOCHIP_YIELD_BUDGET;
+        result.result = xochip_run_budget(machine, &scheduler, budget, NULL, &reason);
+        result.yields[reason]++;
+    }
+
+    result.cycles = scheduler.cycles;
+    result.seconds = elapsed(start);
+    return result;
+}
+
+// Frames per environment step, the usual frame skip
+#define BENCH_ENV_FRAME_SKIP 4
+
+static void bench_env(const char *path, const bench_options_t *options)
+{
+    static xochip_env_t env;
+    static xochip_env_config_t config;
+    static uint8_t rom[XOCHIP_ROM_SIZE_MAX];
+
+    FILE *file = fopen(path, "rb");
+    if (!file)
+    {
+        return;
+    }
+    config.rom = rom;
+    config.rom_size = fread(rom, 1, sizeof(rom), file);
+    fclose(file);
+
+    // no keys, then every key on its own
+    config.cycles_per_frame = options->cycles_per_frame;
+    config.action_count = XOCHIP_KEYCOUNT + 1;
+    for (uint8_t key = 0; key < XOCHIP_KEYCOUNT; ++key)
+    {
+        config.actions[key + 1] = XOCHIP_KEY(key);
+    }
+
+    xochip_env_instance_t *instances = malloc(sizeof(*instances) * options->instances);
+    uint8_t *actions = malloc(options->instances);
+    float *rewards = malloc(sizeof(*rewards) * options->instances);
+    uint8_t *dones = malloc(options->instances);
+    uint8_t *observations = malloc(xochip_env_observation_size(&config.observation) * options->instances);
+
+    xochip_result_t result = XOCHIP_ERR_NULL_POINTER;
+    if (instances && actions && rewards && dones && observations)
+    {
+        result = xochip_env_init(&env, &config, instances, options->instances);
+    }
+
+    uint64_t steps = 0;
+    uint64_t episodes = 0;
+    uint32_t random = XOCHIP_RANDOM_SEED;
+    const clock_t start = clock();
+
+    for (uint32_t step = 0; result == XOCHIP_SUCCESS && step < options->frames / BENCH_ENV_FRAME_SKIP; ++step)
+    {
+        for (uint32_t index = 0; index < options->instances; ++index)
+        {
+            random ^= random << 13;
+            random ^= random >> 17;
+            random ^= random << 5;
+            actions[index] = (uint8_t)(random % config.action_count);
+        }
+
+        result = xochip_env_step(&env, actions, BENCH_ENV_FRAME_SKIP, rewards, dones, observations);
+        steps += options->instances;
+        for (uint32_t index = 0; index < options->instances; ++index)
+        {
+            episodes += dones[index] != XOCHIP_ENV_RUNNING;
+        }
+    }
+
+    const double seconds = elapsed(start);
+    printf("    env     %10llu steps  %8.0f steps/s, %u instances, %u frames per step, %llu episodes ended",
+           (unsigned long long)steps, seconds > 0.0 ? (double)steps / seconds : 0.0, (unsigned)options->instances,
+           (unsigned)BENCH_ENV_FRAME_SKIP, (unsigned long long)episodes);
+    if (result != XOCHIP_SUCCESS)
+    {
+        printf("  stopped: %s", xochip_strerror(result));
+    }
+    printf("\n");
+
+    free(instances);
+    free(actions);
+    free(rewards);
+    free(dones);
+    free(observations);
+}
+
+static void report(const char *mode, const bench_result_t *result)
+{
+    const double ns = result->cycles ? result->seconds * 1e9 / (double)result->cycles : 0.0;
+    printf("    %-7s %10llu cycles %8.2f ns/cycle %9.1f MIPS", mode, (unsigned long long)result->cycles, ns,
+           ns > 0.0 ? 1e3 / ns : 0.0);
+
+    if (result->yields[XOCHIP_YIELD_BUDGET] || result->yields[XOCHIP_YIELD_FRAME] || result->yields[XOCHIP_YIELD_AUDIO])
+    {
+        printf("  yields: %llu budget, %llu frame, %llu audio", (unsigned long long)result->yields[XOCHIP_YIELD_BUDGET],
+               (unsigned long long)result->yields[XOCHIP_YIELD_FRAME],
+               (unsigned long long)result->yields[XOCHIP_YIELD_AUDIO]);
+    }
+
+    if (result->result != XOCHIP_SUCCESS)
+    {
+        printf("  stopped: %s", xochip_strerror(result->result));
+    }
+    printf("\n");
+}
+
+// Machines compare equal when everything up to the attachments does
+static bool same_machine(const xochip_t *a, const xochip_t *b)
+{
+    return memcmp(a, b, offsetof(xochip_t, debugger)) == 0;
+}
+
+static bool bench_rom(const char *path, const bench_options_t *options)
+{
+    xochip_init(&reference);
+    const xochip_result_t load_result = xochip_load_rom_file(&reference, path);
+    if (load_result != XOCHIP_SUCCESS)
+    {
+        fprintf(stderr, "Failed to load ROM %s: %s\n", path, xochip_strerror(load_result));
+        return false;
+    }
+
+    printf("%s\n", path);
+
+    // every mode starts from the same booted machine
+    static xochip_state_t boot;
+    xochip_save_state(&reference, &boot);
+
+    const bench_result_t cycle = bench_cycle(&reference, options);
+    report("cycle", &cycle);
+
+    xochip_init(&emulator);
+    xochip_load_state(&emulator, &boot);
+    const bench_result_t budget = bench_budget(&emulator, options);
+    report("budget", &budget);
+    bool same = same_machine(&reference, &emulator);
+
+    xochip_init(&emulator);
+    xochip_attach_decode_cache(&emulator, &decode_cache);
+    xochip_attach_sprite_cache(&emulator, &sprite_cache);
+    xochip_load_state(&emulator, &boot);
+    const bench_result_t cached = bench_budget(&emulator, options);
+    report("cached", &cached);
+    same = same && same_machine(&reference, &emulator);
+
+    if (!same)
+    {
+        printf("    MISMATCH: the modes ended in different states\n");
+    }
+
+    if (options->instances)
+    {
+        bench_env(path, options);
+    }
+    return same;
+}
+
+int main(int argc, char **argv)
+{
+    bench_options_t options = {3600, 1000, 128, 0};
+    int first_rom = 0;
+
+    for (int arg = 1; arg < argc; ++arg)
+    {
+        uint32_t *option = NULL;
+        if (strcmp(argv[arg], "--frames") == 0)
+        {
+            option = &options.frames;
+        }
+        else if (strcmp(argv[arg], "--ipf") == 0)
+        {
+            option = &options.cycles_per_frame;
+        }
+        else if (strcmp(argv[arg], "--slice") == 0)
+        {
+            option = &options.slice;
+        }
+        else if (strcmp(argv[arg], "--env") == 0)
+        {
+            option = &options.instances;
+        }
+        else
+        {
+            first_rom = arg;
+            break;
+        }
+
+        if (++arg >= argc || (*option = (uint32_t)strtoul(argv[arg], NULL, 10)) == 0)
+        {
+            fprintf(stderr, "%s needs a number above 0\n", argv[arg - 1]);
+            return 1;
+        }
+    }
+
+    if (!first_rom)
+    {
+        fprintf(stderr, "usage: %s [--frames <n>] [--ipf <n>] [--slice <n>] [--env <instances>] <rom>...\n",
+                argv[0]);
+        return 1;
+    }
+
+    printf("%u frames, %u instructions per frame, budget slices of %u\n", (unsigned)options.frames,
+           (unsigned)options.cycles_per_frame, (unsigned)options.slice);
+
+    bool same = true;
+    for (int arg = first_rom; arg < argc; ++arg)
+    {
+        same = bench_rom(argv[arg], &options) && same;
+    }
+
+    return same ? 0 : 1;
+}
@@ -0,0 +1,204 @@
+//
+// Command line front end for xochip_disasm.h. Prints an annotated listing of a ROM by default, the basic blocks with
+// --blocks, or the control-flow graph in Graphviz format with --dot.
+//
+//     xochip-disasm [--blocks | --dot] <rom>
+//
+
+#include <stdio.h>
+#include <string.h>
+
+#define XOCHIP_IMPLEMENTATION
+#include "xochip.h"
+#include "xochip_disasm.h"
+#include "xochip_file.h"
+
+// Too big for the stack
+static xochip_cfg_t cfg;
+
+static void print_listing(const uint8_t *rom, const size_t size)
+{
+    const uint32_t end = XOCHIP_ADDRESS_SPACE_START + (uint32_t)size;
+    uint32_t address = XOCHIP_ADDRESS_SPACE_START;
+
+    while (address < end)
+    {
+        xochip_instruction_t instruction;
+
+        if (XOCHIP_BITMAP_TEST(cfg.instructions, address) &&
+            xochip_disasm_decode(rom, size, (xochip_address_t)address, &instruction))
+        {
+            if (XOCHIP_BITMAP_TEST(cfg.leaders, address))
+            {
+                const bool called = XOCHIP_BITMAP_TEST(cfg.call_targets, address) != 0;
+                printf("\n%s_%04X:\n", called ? "sub" : "block", (unsigned)address);
+            }
+
+            char text[32];
+            xochip_disasm_format(&instruction, text, sizeof(text));
+            printf("    %04X  %04X  %s\n", (unsigned)address, instruction.opcode, text);
+            address += instruction.size;
+            continue;
+        }
+
+        // everything unreachable is data, printed 8 bytes to a line
+        printf("    %04X        DB", (unsigned)address);
+        for (int count = 0; count < 8 && address < end && !XOCHIP_BITMAP_TEST(cfg.instructions, address); ++count)
+        {
+            printf("%s0x%02X", count ? ", " : " ", rom[address - XOCHIP_ADDRESS_SPACE_START]);
+            address++;
+        }
+        printf("\n");
+    }
+}
+
+static void print_blocks(void)
+{
+    for (size_t index = 0; index < cfg.block_count; ++index)
+    {
+        const xochip_block_t *block = &cfg.blocks[index];
+        printf("%04X-%04X %3u instructions ->", block->start, block->last, block->instruction_count);
+
+        for (uint8_t successor = 0; successor < block->successor_count; ++successor)
+        {
+            printf(" %04X", block->successors[successor]);
+        }
+
+        if (block->flags & XOCHIP_BLOCK_ENTRY)
+        {
+            printf(" [entry]");
+        }
+        if (block->flags & XOCHIP_BLOCK_CALL_TARGET)
+        {
+            printf(" [called]");
+        }
+        if (block->flags & XOCHIP_BLOCK_CALL)
+        {
+            printf(" [call]");
+        }
+        if (block->flags & XOCHIP_BLOCK_RETURN)
+        {
+            printf(" [return]");
+        }
+        if (block->flags & XOCHIP_BLOCK_EXIT)
+        {
+            printf(" [exit]");
+        }
+        if (block->flags & XOCHIP_BLOCK_INDIRECT)
+        {
+            printf(" [indirect]");
+        }
+        if (block->flags & XOCHIP_BLOCK_INVALID)
+        {
+            printf(" [invalid]");
+        }
+        printf("\n");
+    }
+}
+
+static void print_dot(const uint8_t *rom, const size_t size)
+{
+    printf("digraph rom {\n    node [shape=box fontname=monospace];\n");
+
+    for (size_t index = 0; index < cfg.block_count; ++index)
+    {
+        const xochip_block_t *block = &cfg.blocks[index];
+        printf("    b%04X [label=\"", block->start);
+
+        xochip_address_t address = block->start;
+        for (uint16_t count = 0; count < block->instruction_count; ++count)
+        {
+            // an instruction that runs off the end of the ROM ends the block, with nothing to print
+            xochip_instruction_t instruction;
+            if (!xochip_disasm_decode(rom, size, address, &instruction))
+            {
+                break;
+            }
+
+            char text[32];
+            xochip_disasm_format(&instruction, text, sizeof(text));
+            printf("%04X  %s\\l", address, text);
+            address = (xochip_address_t)(address + instruction.size);
+        }
+        printf("\"];\n");
+
+        for (uint8_t successor = 0; successor < block->successor_count; ++successor)
+        {
+            const bool returns = (block->flags & XOCHIP_BLOCK_CALL) && successor == 1;
+            printf("    b%04X -> b%04X%s;\n", block->start, block->successors[successor],
+                   returns ? " [style=dashed]" : "");
+        }
+    }
+
+    printf("}\n");
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = NULL;
+    bool blocks = false;
+    bool dot = false;
+
+    for (int arg = 1; arg < argc; ++arg)
+    {
+        if (strcmp(argv[arg], "--blocks") == 0)
+        {
+            blocks = true;
+        }
+        else if (strcmp(argv[arg], "--dot") == 0)
+        {
+            dot = true;
+        }
+        else
+        {
+            path = argv[arg];
+        }
+    }
+
+    if (!path || (blocks && dot))
+    {
+        fprintf(stderr, "usage: %s [--blocks | --dot] <rom>\n", argv[0]);
+        return 1;
+    }
+
+    xochip_rom_file_t rom;
+    xochip_result_t result = xochip_map_rom_file(path, &rom);
+    if (result != XOCHIP_SUCCESS)
+    {
+        fprintf(stderr, "Failed to load ROM %s: %s\n", path, xochip_strerror(result));
+        return 1;
+    }
+
+    // an empty file maps to NULL, but it's still a valid (empty) image
+    static const uint8_t empty[1];
+    const uint8_t *data = rom.data ? rom.data : empty;
+
+    result = xochip_cfg_build(&cfg, data, rom.size);
+    if (result != XOCHIP_SUCCESS)
+    {
+        fprintf(stderr, "Failed to analyze ROM %s: %s\n", path, xochip_strerror(result));
+        xochip_unmap_rom_file(&rom);
+        return 1;
+    }
+
+    if (cfg.truncated)
+    {
+        fprintf(stderr, "Warning: too many blocks, the graph is incomplete\n");
+    }
+
+    if (blocks)
+    {
+        print_blocks();
+    }
+    else if (dot)
+    {
+        print_dot(data, rom.size);
+    }
+    else
+    {
+        print_listing(data, rom.size);
+    }
+
+    xochip_unmap_rom_file(&rom);
+    return 0;
+}
@@ -2,6 +2,26 @@
 // This is an example implementation targeting the desktop, using SDL3. For your own project, you can simply copy and
 // paste xochip.h into a header file. This file is just for demonstration.
 //
+//     xochip-emulator [--threaded] [--run-ahead <frames>] [--ipf <n>] [--costs vip|schip|xochip] [--record <file>]
+//                     <rom>
+//
+// By default everything runs on the SDL main thread. With --threaded the emulator gets a thread of its own and hands
+// finished frames to the main thread through a lock-free triple buffer, so vsync or a slow present never stalls it.
+// Either way, key events only set bits in an atomic mask, and the emulator side feeds the changes to the core.
+//
+// With --run-ahead, every frame the real state is saved, the emulator runs that many frames further with the current
+// keys, shows the result and rolls back. Games that only react to input a frame or two later respond immediately.
+//
+// By default the emulator finds out how many instructions per frame the game needs with xochip_calibrate, from how
+// much of each frame it spends waiting for the delay timer or a key, and runs that many plus a margin. With --ipf it
+// runs a fixed number instead.
+//
+// With --costs, the emulator paces by the cycle cost of each instruction on the chosen machine instead of running a
+// fixed number of instructions per frame, so games written for a slow machine run at the speed they were written for.
+//
+// With --record, every frame the real machine runs is recorded to the file with xochip_record.h, so a session can be
+// attached to a bug report and looked at frame by frame with xochip-replay.
+//
 
 #define SDL_MAIN_USE_CALLBACKS
 #include "SDL3/SDL.h"
@@ -9,6 +29,9 @@
 
 #define XOCHIP_IMPLEMENTATION
 #include "xochip.h"
+#include "xochip_file.h"
+#include "xochip_pixels.h"
+#include "xochip_record.h"
 
 // XOCHIP 128x64 display times 10
 #define WINDOW_WIDTH 1280
@@ -17,36 +40,312 @@
 // Timing stuff
 #define TICK_TIME 16666667ULL
 #define CYCLE_TIME 2000000ULL
+#define CYCLES_PER_FRAME (TICK_TIME / CYCLE_TIME)
+
+// What the calibrator may pick, the most is far beyond any game but still well within a frame on the desktop
+#define MIN_CALIBRATED_CYCLES 2
+#define MAX_CALIBRATED_CYCLES 100000
+
+// How many late frames the emulator catches up on before it gives up and resynchronizes
+#define MAX_CATCH_UP_FRAMES 4
+
+// More than a few frames of run-ahead means visibly mispredicting everything
+#define MAX_RUN_AHEAD_FRAMES 8
+
+// Set in the triple buffer's shared index when that slot holds a frame the reader hasn't seen yet
+#define FRAME_FRESH 0x4
+
+/**
+ * Single producer, single consumer triple buffer. The writer and reader each own a slot, and the third one is
+ * exchanged through an atomic index. Neither side ever waits for the other, the reader just gets the newest frame.
+ */
+typedef struct frame_buffer
+{
+    xochip_display_t slots[3]; // only the planes and the resolution are copied
+    SDL_AtomicInt shared; // index of the exchanged slot, plus FRAME_FRESH
+    int writing;          // owned by the emulator
+    int reading;          // owned by the renderer
+} frame_buffer_t;
 
 typedef struct emulator_app
 {
     SDL_Window *window;
     SDL_Renderer *renderer;
+    SDL_Texture *texture;
     xochip_t *emulator;
 
-    uint64_t next_tick;  // for emulator timers that tick down at 60 Hz
-    uint64_t next_cycle; // for emulator instruction execution, ~500 Hz but configurable for specific games
+    uint64_t next_frame;          // the emulator runs a frame worth of cycles, then ticks the timers at 60 Hz
+    xochip_scheduler_t scheduler; // what a frame worth of cycles is
+
+    bool calibrating;               // a frame worth of cycles is picked by the calibrator, not fixed
+    xochip_frame_stats_t stats;     // what the real machine did during the current frame
+    xochip_calibrator_t calibrator; // and what that says about the next one
 
     // Maps SDL scancodes to emulator keys (I know, I was lazy here okay)
     xochip_keys_t keymap[SDL_SCANCODE_COUNT];
+
+    SDL_AtomicU32 keys; // bit n is set while key n is held, written by the event thread
+    uint32_t applied_keys; // what the emulator has been told so far, owned by the emulator side
+
+    frame_buffer_t frames;
+    xochip_pixels_t pixels;
+    uint8_t rgba[XOCHIP_DISPLAY_PIXELS * 4];
+
+    uint32_t run_ahead;                // frames to run ahead, 0 for off
+    xochip_state_t real_state;         // the machine as it really is while running ahead
+    xochip_scheduler_t real_scheduler; // and its pacing
+
+    SDL_IOStream *record;       // NULL when not recording
+    xochip_recorder_t recorder; // owned by the emulator side
+
+    bool threaded;
+    SDL_Thread *thread;
+    SDL_AtomicInt running;
 } emulator_app_t;
 
+static void publish_frame(frame_buffer_t *frames, const xochip_display_t *display)
+{
+    xochip_display_t *frame = &frames->slots[frames->writing];
+    SDL_memcpy(frame->back_plane, display->back_plane, sizeof(frame->back_plane));
+    SDL_memcpy(frame->fore_plane, display->fore_plane, sizeof(frame->fore_plane));
+    frame->hires = display->hires; // low resolution pixels are doubled when the frame is converted
+
+    // hand the finished slot over, and take whichever one was waiting (the reader is done with it, or never saw it)
+    frames->writing = SDL_SetAtomicInt(&frames->shared, frames->writing | FRAME_FRESH) & 0x3;
+}
+
+static const xochip_display_t *acquire_frame(frame_buffer_t *frames)
+{
+    if (!(SDL_GetAtomicInt(&frames->shared) & FRAME_FRESH))
+    {
+        return NULL;
+    }
+
+    frames->reading = SDL_SetAtomicInt(&frames->shared, frames->reading) & 0x3;
+    return &frames->slots[frames->reading];
+}
+
+// Forwards key changes from the event thread to the core, from whichever thread owns the emulator
+static void apply_keys(emulator_app_t *app)
+{
+    const uint32_t keys = SDL_GetAtomicU32(&app->keys);
+    const uint32_t changed = keys ^ app->applied_keys;
+
+    for (uint8_t key = 0; key < XOCHIP_KEYCOUNT; ++key)
+    {
+        if (changed & (1u << key))
+        {
+            if (keys & (1u << key))
+            {
+                xochip_key_down(app->emulator, (xochip_keys_t)key);
+            }
+            else
+            {
+                xochip_key_up(app->emulator, (xochip_keys_t)key);
+            }
+        }
+    }
+
+    app->applied_keys = keys;
+}
+
+static bool write_record(void *context, const uint8_t *data, const size_t size)
+{
+    return SDL_WriteIO(context, data, size) == size;
+}
+
+// Runs until the timers tick once. Returns true when the display changed during the frame.
+static bool emulate_frame(xochip_t *emulator, xochip_scheduler_t *scheduler)
+{
+    const uint64_t ticks = scheduler->ticks;
+    bool updated = false;
+
+    while (scheduler->ticks == ticks)
+    {
+        xochip_yield_t reason;
+        const uint32_t budget = scheduler->cycles_per_tick - scheduler->tick_phase;
+        if (xochip_run_budget(emulator, scheduler, budget, NULL, &reason) != XOCHIP_SUCCESS)
+        {
+            // the machine is stuck on a bad instruction, keep the timers going at least
+            xochip_tick(emulator);
+            scheduler->ticks++;
+            break;
+        }
+        updated = updated || reason == XOCHIP_YIELD_FRAME;
+    }
+
+    return updated;
+}
+
+// Runs every frame that's due, publishes the display if it changed. Returns when the next frame is due.
+static uint64_t emulate_frames(emulator_app_t *app)
+{
+    uint64_t now = SDL_GetTicksNS();
+    bool emulated = false;
+
+    // after a stall (debugger, suspended laptop), skip ahead rather than fast forwarding
+    if (app->next_frame + MAX_CATCH_UP_FRAMES * TICK_TIME < now)
+    {
+        app->next_frame = now;
+    }
+
+    while (app->next_frame <= now)
+    {
+        apply_keys(app);
+        const bool updated = emulate_frame(app->emulator, &app->scheduler);
+        app->next_frame += TICK_TIME;
+        emulated = true;
+
+        if (app->calibrating)
+        {
+            xochip_calibrate(&app->calibrator, app->emulator, &app->scheduler);
+        }
+
+        if (app->record && xochip_record_frame(&app->recorder, &app->emulator->display) != XOCHIP_SUCCESS)
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write the recording, stopped recording");
+            SDL_CloseIO(app->record);
+            app->record = NULL;
+        }
+
+        if (!app->run_ahead && updated)
+        {
+            publish_frame(&app->frames, &app->emulator->display);
+        }
+    }
+
+    // show where the current keys lead, then roll back to the real machine. Only once per batch, the frames in
+    // between would never be seen anyway.
+    if (app->run_ahead && emulated)
+    {
+        xochip_save_state(app->emulator, &app->real_state);
+        app->real_scheduler = app->scheduler;
+        for (uint32_t frame = 0; frame < app->run_ahead; ++frame)
+        {
+            emulate_frame(app->emulator, &app->scheduler);
+        }
+        publish_frame(&app->frames, &app->emulator->display);
+        xochip_load_state(app->emulator, &app->real_state);
+        app->scheduler = app->real_scheduler;
+
+        // the frames that were rolled back aren't the real machine's
+        xochip_stats_begin(app->emulator);
+    }
+
+    return app->next_frame;
+}
+
+static int SDLCALL emulator_thread(void *data)
+{
+    emulator_app_t *app = data;
+
+    while (SDL_GetAtomicInt(&app->running))
+    {
+        const uint64_t next_frame = emulate_frames(app);
+        const uint64_t now = SDL_GetTicksNS();
+
+        if (next_frame > now)
+        {
+            SDL_DelayNS(next_frame - now);
+        }
+    }
+
+    return 0;
+}
+
+// Draws the newest frame, if there is one. With vsync on this blocks, which is exactly why --threaded exists.
+static void present_frame(emulator_app_t *app)
+{
+    const xochip_display_t *frame = acquire_frame(&app->frames);
+    if (!frame)
+    {
+        return;
+    }
+
+    xochip_pixels_convert(&app->pixels, frame, UINT64_MAX, app->rgba, XOCHIP_DISPLAY_WIDTH * 4);
+
+    SDL_UpdateTexture(app->texture, NULL, app->rgba, XOCHIP_DISPLAY_WIDTH * 4);
+    SDL_RenderClear(app->renderer);
+    SDL_RenderTexture(app->renderer, app->texture, NULL, NULL);
+    SDL_RenderPresent(app->renderer);
+}
+
 SDL_AppResult SDL_AppInit(void **app_state, int argc, char **argv)
 {
+    const char *rom_path = NULL;
+    bool threaded = false;
+    int run_ahead = 0;
+    int cycles_per_frame = 0;
+    const xochip_cost_table_t *costs = NULL;
+    const char *record_path = NULL;
+
+    for (int arg = 1; arg < argc; ++arg)
+    {
+        if (SDL_strcmp(argv[arg], "--threaded") == 0)
+        {
+            threaded = true;
+        }
+        else if (SDL_strcmp(argv[arg], "--run-ahead") == 0 && arg + 1 < argc)
+        {
+            run_ahead = SDL_atoi(argv[++arg]);
+        }
+        else if (SDL_strcmp(argv[arg], "--ipf") == 0 && arg + 1 < argc)
+        {
+            cycles_per_frame = SDL_atoi(argv[++arg]);
+            if (cycles_per_frame <= 0)
+            {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Instructions per frame must be at least 1");
+                return SDL_APP_FAILURE;
+            }
+        }
+        else if (SDL_strcmp(argv[arg], "--costs") == 0 && arg + 1 < argc)
+        {
+            static const char *presets[XOCHIP_COST_PRESET_COUNT] = {"vip", "schip", "xochip"};
+            const char *name = argv[++arg];
+            for (int preset = 0; preset < XOCHIP_COST_PRESET_COUNT; ++preset)
+            {
+                if (SDL_strcmp(name, presets[preset]) == 0)
+                {
+                    costs = xochip_cost_preset((xochip_cost_preset_t)preset);
+                }
+            }
+
+            if (!costs)
+            {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unknown cost preset %s, try vip, schip or xochip", name);
+                return SDL_APP_FAILURE;
+            }
+        }
+        else if (SDL_strcmp(argv[arg], "--record") == 0 && arg + 1 < argc)
+        {
+            record_path = argv[++arg];
+        }
+        else
+        {
+            rom_path = argv[arg];
+        }
+    }
 
-    if (argc < 2)
+    if (!rom_path)
     {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "I require a path to a ROM");
         return SDL_APP_FAILURE;
     }
 
+    if (run_ahead < 0 || run_ahead > MAX_RUN_AHEAD_FRAMES)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Run-ahead must be between 0 and %d frames", MAX_RUN_AHEAD_FRAMES);
+        return SDL_APP_FAILURE;
+    }
+
     if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO))
     {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to initialize SDL: %s", SDL_GetError());
         return SDL_APP_FAILURE;
     }
 
-    emulator_app_t *app = SDL_malloc(sizeof(emulator_app_t));
+    // zeroed, so SDL_AppQuit can tell what was set up when something below fails
+    emulator_app_t *app = SDL_calloc(1, sizeof(emulator_app_t));
 
     if (!app)
     {
@@ -55,6 +354,10 @@ SDL_AppResult SDL_AppInit(void **app_state, int argc, char **argv)
         return SDL_APP_FAILURE;
     }
 
+    *app_state = app;
+    app->threaded = threaded;
+    app->run_ahead = (uint32_t)run_ahead;
+
     app->emulator = SDL_malloc(sizeof(xochip_t));
 
     if (!app->emulator)
@@ -73,7 +376,7 @@ SDL_AppResult SDL_AppInit(void **app_state, int argc, char **argv)
     }
 
     // setting all unhandled keymaps in keymap to something that exists outside the range of valid keys, which
-    // xochip_key_down and xochip_key_up check for
+    // SDL_AppEvent checks for
     SDL_memset(app->keymap, XOCHIP_KEYCOUNT, sizeof(app->keymap));
 
     // Mapping physical keys to XOCHIP keys
@@ -94,10 +397,14 @@ SDL_AppResult SDL_AppInit(void **app_state, int argc, char **argv)
     app->keymap[SDL_SCANCODE_C] = XOCHIP_KEYB;
     app->keymap[SDL_SCANCODE_V] = XOCHIP_KEYF;
 
-    app->next_tick = 0;
-    app->next_cycle = 0;
+    // Octo's default palette: background, back plane, fore plane, both
+    static const uint32_t palette[4] = {0x996600, 0xFFCC00, 0xFF6600, 0x662200};
+    xochip_pixels_init(&app->pixels, XOCHIP_PIXELS_RGBA8888, palette, 1);
 
-    *app_state = app;
+    // slot 0 belongs to the emulator, 1 to the renderer, 2 starts out in the middle
+    app->frames.writing = 0;
+    app->frames.reading = 1;
+    SDL_SetAtomicInt(&app->frames.shared, 2);
 
     if (!SDL_CreateWindowAndRenderer("XOCHIP", WINDOW_WIDTH, WINDOW_HEIGHT, 0, &app->window, &app->renderer))
     {
@@ -105,53 +412,90 @@ SDL_AppResult SDL_AppInit(void **app_state, int argc, char **argv)
         return SDL_APP_FAILURE;
     }
 
-    // load the ROM
-    size_t romlen = 0;
-    uint8_t *rom = SDL_LoadFile(argv[1], &romlen);
+    SDL_SetRenderVSync(app->renderer, 1);
 
-    if (!rom)
+    app->texture = SDL_CreateTexture(app->renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING,
+                                     XOCHIP_DISPLAY_WIDTH, XOCHIP_DISPLAY_HEIGHT);
+    if (!app->texture)
     {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to load ROM: %s", SDL_GetError());
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create texture: %s", SDL_GetError());
         return SDL_APP_FAILURE;
     }
 
-    const xochip_result_t load_result = xochip_load_rom(app->emulator, rom, romlen);
+    SDL_SetTextureScaleMode(app->texture, SDL_SCALEMODE_NEAREST);
+
+    // load the ROM, it's memory mapped and copied straight into the emulator
+    const xochip_result_t load_result = xochip_load_rom_file(app->emulator, rom_path);
     if (load_result != XOCHIP_SUCCESS)
     {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to load ROM: %s", xochip_strerror(load_result));
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to load ROM %s: %s", rom_path, xochip_strerror(load_result));
         return SDL_APP_FAILURE;
     }
 
+    // without a cost table every instruction costs 1, which makes this instructions per frame. A cost table already
+    // says how fast the game should run, so only a plain instruction count is calibrated.
+    xochip_set_costs(app->emulator, costs);
+    if (costs)
+    {
+        xochip_scheduler_init(&app->scheduler, costs->cycles_per_tick, 0);
+    }
+    else if (cycles_per_frame)
+    {
+        xochip_scheduler_init(&app->scheduler, (uint32_t)cycles_per_frame, 0);
+    }
+    else
+    {
+        app->calibrating = true;
+        xochip_scheduler_init(&app->scheduler, CYCLES_PER_FRAME, 0);
+        xochip_calibrator_init(&app->calibrator, MIN_CALIBRATED_CYCLES, MAX_CALIBRATED_CYCLES, CYCLES_PER_FRAME);
+        xochip_attach_stats(app->emulator, &app->stats);
+    }
+    app->next_frame = SDL_GetTicksNS();
+
+    if (record_path)
+    {
+        app->record = SDL_IOFromFile(record_path, "wb");
+        if (!app->record)
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create %s: %s", record_path, SDL_GetError());
+            return SDL_APP_FAILURE;
+        }
+        xochip_record_start(&app->recorder, write_record, app->record, XOCHIP_RECORD_KEYFRAME_INTERVAL);
+    }
+
+    if (app->threaded)
+    {
+        SDL_SetAtomicInt(&app->running, 1);
+        app->thread = SDL_CreateThread(emulator_thread, "xochip", app);
+        if (!app->thread)
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to start emulator thread: %s", SDL_GetError());
+            return SDL_APP_FAILURE;
+        }
+    }
+
     return SDL_APP_CONTINUE;
 }
 
-// Calls xochip_cycle and xochip_tick when it's time. Afterwards, it will calculate the time needed until the next
-// upcoming action (tick or cycle), and will sleep until it's time.
+// Single threaded, runs the frames that are due and presents. Threaded, only presents, the emulator paces itself.
 SDL_AppResult SDL_AppIterate(void *app_state)
 {
     emulator_app_t *app = app_state;
 
-    uint64_t now = SDL_GetTicksNS();
-
-    if (app->next_cycle <= now)
+    if (app->threaded)
     {
-        xochip_cycle(app->emulator);
-        app->next_cycle += CYCLE_TIME;
+        present_frame(app);
+        return SDL_APP_CONTINUE;
     }
 
-    if (app->next_tick <= now)
-    {
-        xochip_tick(app->emulator);
-        app->next_tick += TICK_TIME;
-    }
+    const uint64_t next_frame = emulate_frames(app);
+    present_frame(app);
 
-    // determine when the next operation is, and wait until it's time
-    const uint64_t next_op_time = SDL_min(app->next_cycle, app->next_tick);
-    now = SDL_GetTicksNS(); // where are we after running previous instructions
-
-    if (next_op_time > now)
+    // wait for the next frame, unless presenting already took us there
+    const uint64_t now = SDL_GetTicksNS();
+    if (next_frame > now)
     {
-        SDL_DelayNS(next_op_time - now);
+        SDL_DelayNS(next_frame - now);
     }
 
     return SDL_APP_CONTINUE;
@@ -165,12 +509,24 @@ SDL_AppResult SDL_AppEvent(void *app_state, SDL_Event *event)
     case SDL_EVENT_QUIT:
         return SDL_APP_SUCCESS;
     case SDL_EVENT_KEY_DOWN:
-        // This is safe, xochip_key_down will ignore anything that's not a valid xochip key
-        xochip_key_down(app->emulator, app->keymap[event->key.scancode]);
-        break;
     case SDL_EVENT_KEY_UP:
-        xochip_key_up(app->emulator, app->keymap[event->key.scancode]);
+    {
+        // the emulator may be on another thread, so just record the key, apply_keys hands it to the core
+        const xochip_keys_t key = app->keymap[event->key.scancode];
+        if (key >= XOCHIP_KEYCOUNT)
+        {
+            break;
+        }
+
+        uint32_t keys;
+        uint32_t updated;
+        do
+        {
+            keys = SDL_GetAtomicU32(&app->keys);
+            updated = event->type == SDL_EVENT_KEY_DOWN ? keys | (1u << key) : keys & ~(1u << key);
+        } while (!SDL_CompareAndSwapAtomicU32(&app->keys, keys, updated));
         break;
+    }
     default:
         break;
     }
@@ -182,8 +538,25 @@ void SDL_AppQuit(void *app_state, SDL_AppResult result)
     emulator_app_t *app = app_state;
     if (app)
     {
-        SDL_DestroyWindow(app->window);
+        if (app->thread)
+        {
+            SDL_SetAtomicInt(&app->running, 0);
+            SDL_WaitThread(app->thread, NULL);
+        }
+
+        if (app->record)
+        {
+            if (xochip_record_flush(&app->recorder) != XOCHIP_SUCCESS)
+            {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write the end of the recording");
+            }
+            SDL_CloseIO(app->record);
+        }
+
+        SDL_DestroyTexture(app->texture);
         SDL_DestroyRenderer(app->renderer);
+        SDL_DestroyWindow(app->window);
+        SDL_free(app->emulator);
         SDL_free(app);
     }
 }
@@ -0,0 +1,196 @@
+//
+// Fuzz harness for the core. Builds as a libFuzzer target (XOCHIP_LIBFUZZER), and as a standalone program that runs
+// each file given on the command line, or stdin, once. That's what AFL++ wants, and what you want to reproduce a crash.
+//
+//     xochip-fuzz [files...]
+//
+// There are two modes:
+// - ROM mode (the default), each test case is a ROM.
+// - Input mode, when XOCHIP_FUZZ_ROM names a ROM. The ROM is fixed and each test case byte is a frame of input: bit 7
+//   presses (or releases, when clear) the key in the low nibble.
+//
+// The machine is booted once and snapshotted, and every test case starts from xochip_load_state instead of resetting
+// and loading the ROM again. Which opcodes ran is printed on exit, always in standalone mode, and with libFuzzer when
+// XOCHIP_FUZZ_COVERAGE is set.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define XOCHIP_IMPLEMENTATION
+#include "xochip.h"
+#include "xochip_file.h"
+
+// How long a test case runs for, at most. ROMs get FUZZ_FRAMES frames, inputs one frame per byte.
+#define FUZZ_FRAMES 60
+#define FUZZ_CYCLES_PER_FRAME 16
+
+static xochip_t emulator;
+static xochip_state_t boot;
+static bool booted = false;
+static bool input_mode = false;
+static uint64_t coverage[XOCHIP_OP_COUNT];
+
+static void print_coverage(void)
+{
+    uint32_t covered = 0;
+    for (uint32_t op = 0; op < XOCHIP_OP_COUNT; ++op)
+    {
+        covered += coverage[op] ? 1 : 0;
+    }
+
+    fprintf(stderr, "opcode coverage: %u/%u\n", (unsigned)covered, (unsigned)XOCHIP_OP_COUNT);
+    for (uint32_t op = 0; op < XOCHIP_OP_COUNT; ++op)
+    {
+        fprintf(stderr, "    %-16s %llu\n", xochip_op_name((xochip_op_t)op), (unsigned long long)coverage[op]);
+    }
+}
+
+// Boots the machine the test cases fork from. Returns false when XOCHIP_FUZZ_ROM can't be loaded.
+static bool boot_machine(void)
+{
+    xochip_init(&emulator);
+
+    const char *rom = getenv("XOCHIP_FUZZ_ROM");
+    if (rom)
+    {
+        const xochip_result_t result = xochip_load_rom_file(&emulator, rom);
+        if (result != XOCHIP_SUCCESS)
+        {
+            fprintf(stderr, "Failed to load ROM %s: %s\n", rom, xochip_strerror(result));
+            return false;
+        }
+        input_mode = true;
+    }
+
+#ifdef XOCHIP_LIBFUZZER
+    // libFuzzer owns main, the standalone build prints it itself
+    if (getenv("XOCHIP_FUZZ_COVERAGE"))
+    {
+        atexit(print_coverage);
+    }
+#endif
+
+    xochip_save_state(&emulator, &boot);
+    booted = true;
+    return true;
+}
+
+// Runs a frame one instruction at a time, so every opcode is counted. Returns false once the machine has stopped.
+static bool run_frame(void)
+{
+    for (uint32_t cycle = 0; cycle < FUZZ_CYCLES_PER_FRAME; ++cycle)
+    {
+        const uint16_t counter = emulator.counter;
+        const uint16_t opcode =
+            (uint16_t)(xochip_peek(&emulator, counter) << 8 | xochip_peek(&emulator, (uint16_t)(counter + 1)));
+        coverage[xochip_decode(opcode)]++;
+
+        if (xochip_cycle(&emulator) != XOCHIP_SUCCESS)
+        {
+            return false;
+        }
+    }
+
+    xochip_tick(&emulator);
+    return true;
+}
+
+static void run_case(const uint8_t *data, const size_t size)
+{
+    xochip_load_state(&emulator, &boot);
+
+    if (!input_mode)
+    {
+        if (size > XOCHIP_ROM_SIZE_MAX || xochip_write_rom(&emulator, data, size, XOCHIP_ADDRESS_SPACE_START))
+        {
+            return;
+        }
+
+        for (uint32_t frame = 0; frame < FUZZ_FRAMES && run_frame(); ++frame)
+        {
+        }
+        return;
+    }
+
+    for (size_t index = 0; index < size; ++index)
+    {
+        const xochip_keys_t key = (xochip_keys_t)(data[index] & 0xF);
+        if (data[index] & 0x80)
+        {
+            xochip_key_down(&emulator, key);
+        }
+        else
+        {
+            xochip_key_up(&emulator, key);
+        }
+
+        if (!run_frame())
+        {
+            return;
+        }
+    }
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    if (!booted && !boot_machine())
+    {
+        abort();
+    }
+
+    run_case(data, size);
+    return 0;
+}
+
+#ifndef XOCHIP_LIBFUZZER
+
+static uint8_t buffer[XOCHIP_ROM_SIZE_MAX + 1];
+
+static void run_stream(FILE *stream)
+{
+    const size_t size = fread(buffer, 1, sizeof(buffer), stream);
+    LLVMFuzzerTestOneInput(buffer, size);
+}
+
+int main(int argc, char **argv)
+{
+    if (!boot_machine())
+    {
+        return 1;
+    }
+
+#ifdef __AFL_LOOP
+    // AFL++ persistent mode, many test cases per process. Every one of them is read to the end, and AFL++ rewinds
+    // stdin for the next, which stdio doesn't know until the end of file flag is cleared.
+    while (__AFL_LOOP(10000))
+    {
+        clearerr(stdin);
+        run_stream(stdin);
+    }
+    return 0;
+#endif
+
+    if (argc < 2)
+    {
+        run_stream(stdin);
+    }
+
+    for (int arg = 1; arg < argc; ++arg)
+    {
+        FILE *stream = fopen(argv[arg], "rb");
+        if (!stream)
+        {
+            fprintf(stderr, "Failed to open %s\n", argv[arg]);
+            return 1;
+        }
+
+        run_stream(stream);
+        fclose(stream);
+    }
+
+    print_coverage();
+    return 0;
+}
+
+#endif
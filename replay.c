@@ -0,0 +1,198 @@
+//
+// Command line front end for xochip_record.h. Prints what's in a recording, or exports a range of its frames as an
+// image sequence of binary PPM files, <prefix>000000.ppm and up, which anything from ffmpeg to an image viewer reads.
+//
+//     xochip-replay [--from <frame>] [--to <frame>] [--scale <n>] <recording> [<prefix>]
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define XOCHIP_IMPLEMENTATION
+#include "xochip.h"
+#include "xochip_pixels.h"
+#include "xochip_record.h"
+
+// Too big for the stack
+static xochip_replay_t replay;
+static xochip_pixels_t pixels;
+static uint8_t image[XOCHIP_DISPLAY_PIXELS * 3 * XOCHIP_PIXELS_SCALE_MAX * XOCHIP_PIXELS_SCALE_MAX];
+
+// Recordings are unbounded, so they're read whole instead of going through xochip_map_rom_file
+static uint8_t *read_file(const char *path, size_t *size)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+    {
+        return NULL;
+    }
+
+    uint8_t *data = NULL;
+    size_t capacity = 0;
+    *size = 0;
+
+    for (;;)
+    {
+        if (*size == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 65536;
+            uint8_t *grown = realloc(data, capacity);
+            if (!grown)
+            {
+                free(data);
+                fclose(file);
+                return NULL;
+            }
+            data = grown;
+        }
+
+        const size_t read = fread(data + *size, 1, capacity - *size, file);
+        if (read == 0)
+        {
+            break;
+        }
+        *size += read;
+    }
+
+    const bool failed = ferror(file) != 0;
+    fclose(file);
+    if (failed)
+    {
+        free(data);
+        return NULL;
+    }
+    return data;
+}
+
+static bool write_frame(const char *prefix, const uint32_t frame, const uint32_t scale)
+{
+    const size_t pitch = xochip_pixels_row_size(&pixels);
+    xochip_pixels_convert(&pixels, &replay.display, UINT64_MAX, image, pitch);
+
+    char path[4096];
+    snprintf(path, sizeof(path), "%s%06u.ppm", prefix, (unsigned)frame);
+
+    FILE *file = fopen(path, "wb");
+    if (!file)
+    {
+        return false;
+    }
+
+    const size_t height = (size_t)XOCHIP_DISPLAY_HEIGHT * scale;
+    fprintf(file, "P6\n%u %u\n255\n", (unsigned)(XOCHIP_DISPLAY_WIDTH * scale), (unsigned)height);
+    const bool written = fwrite(image, pitch, height, file) == height;
+    return fclose(file) == 0 && written;
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = NULL;
+    const char *prefix = NULL;
+    uint32_t from = 0;
+    uint32_t to = UINT32_MAX;
+    uint32_t scale = 1;
+
+    for (int arg = 1; arg < argc; ++arg)
+    {
+        uint32_t *option = NULL;
+        if (strcmp(argv[arg], "--from") == 0)
+        {
+            option = &from;
+        }
+        else if (strcmp(argv[arg], "--to") == 0)
+        {
+            option = &to;
+        }
+        else if (strcmp(argv[arg], "--scale") == 0)
+        {
+            option = &scale;
+        }
+        else if (!path)
+        {
+            path = argv[arg];
+            continue;
+        }
+        else if (!prefix)
+        {
+            prefix = argv[arg];
+            continue;
+        }
+        else
+        {
+            path = NULL;
+            break;
+        }
+
+        if (++arg >= argc)
+        {
+            path = NULL;
+            break;
+        }
+        *option = (uint32_t)strtoul(argv[arg], NULL, 10);
+    }
+
+    if (!path || from > to || scale == 0 || scale > XOCHIP_PIXELS_SCALE_MAX)
+    {
+        fprintf(stderr, "usage: %s [--from <frame>] [--to <frame>] [--scale <1-%d>] <recording> [<prefix>]\n", argv[0],
+                XOCHIP_PIXELS_SCALE_MAX);
+        return 1;
+    }
+
+    size_t size = 0;
+    uint8_t *data = read_file(path, &size);
+    if (!data)
+    {
+        fprintf(stderr, "Failed to read %s\n", path);
+        return 1;
+    }
+
+    xochip_result_t result = xochip_replay_open(&replay, data, size);
+    if (result != XOCHIP_SUCCESS)
+    {
+        fprintf(stderr, "%s isn't a recording: %s\n", path, xochip_strerror(result));
+        free(data);
+        return 1;
+    }
+
+    if (!prefix)
+    {
+        printf("%s: %u frames, keyframe every %u, %zu bytes, %.1f bytes per frame\n", path,
+               (unsigned)replay.frame_count, (unsigned)replay.keyframe_interval, size,
+               replay.frame_count ? (double)size / replay.frame_count : 0.0);
+        free(data);
+        return 0;
+    }
+
+    // Octo's default palette, like the desktop demo
+    static const uint32_t palette[4] = {0x996600, 0xFFCC00, 0xFF6600, 0x662200};
+    xochip_pixels_init(&pixels, XOCHIP_PIXELS_RGB888, palette, (uint8_t)scale);
+
+    if (to >= replay.frame_count)
+    {
+        to = replay.frame_count ? replay.frame_count - 1 : 0;
+    }
+
+    uint32_t exported = 0;
+    for (uint32_t frame = from; frame <= to && frame < replay.frame_count; ++frame)
+    {
+        result = xochip_replay_seek(&replay, frame);
+        if (result != XOCHIP_SUCCESS)
+        {
+            fprintf(stderr, "Failed to decode frame %u: %s\n", (unsigned)frame, xochip_strerror(result));
+            break;
+        }
+
+        if (!write_frame(prefix, frame, scale))
+        {
+            fprintf(stderr, "Failed to write frame %u\n", (unsigned)frame);
+            result = XOCHIP_ERR_WRITE;
+            break;
+        }
+        exported++;
+    }
+
+    printf("exported %u frames\n", (unsigned)exported);
+    free(data);
+    return result == XOCHIP_SUCCESS ? 0 : 1;
+}
@@ -0,0 +1,551 @@
+//
+// Batch ROM screening. Runs every .ch8/.xo8 ROM in the given directories (and any ROM files given directly) headless
+// for a number of frames, spread over all cores, and reports per ROM how it ended up and which SUPER-CHIP and XO-CHIP
+// instructions it ran, as CSV or JSON on stdout. A summary goes to stderr. A ROM whose state hash doesn't change over
+// a frame would run the same frame forever, so it's stopped there and frames says when. Each thread keeps the last
+// --memo frames (1024 by default) by the state they started from, so a ROM that goes round the same loop replays it
+// instead of running it again.
+//
+//     xochip-screen [--frames <n>] [--ipf <n>] [--jobs <n>] [--memo <n>] [--json] <directory or rom>...
+//
+// Every ROM lands in exactly one class, the first that applies:
+// - load-error:          the file couldn't be read, or is too large
+// - invalid-instruction: ran an opcode that isn't CHIP-8, SUPER-CHIP or XO-CHIP
+// - stack-overflow:      too many nested calls
+// - stack-underflow:     returned without a call
+// - address-error:       jumped or called outside of memory
+// - exits:               ran 00FD
+// - key-wait:            sitting on Fx0A at the end, the ROM needs input to go on
+// - halts:               sitting on a jump to itself at the end, the usual way to stop
+// - stuck:               the whole machine stayed the same over a frame, a loop that waits for nothing
+// - renders:             still running and drew something
+// - blank:               still running, the display stayed empty
+//
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <dirent.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define XOCHIP_IMPLEMENTATION
+#include "xochip.h"
+#include "xochip_file.h"
+
+typedef enum screen_class
+{
+    SCREEN_LOAD_ERROR,
+    SCREEN_INVALID_INSTRUCTION,
+    SCREEN_STACK_OVERFLOW,
+    SCREEN_STACK_UNDERFLOW,
+    SCREEN_ADDRESS_ERROR,
+    SCREEN_EXITS,
+    SCREEN_KEY_WAIT,
+    SCREEN_HALTS,
+    SCREEN_STUCK,
+    SCREEN_RENDERS,
+    SCREEN_BLANK,
+    SCREEN_CLASS_COUNT,
+} screen_class_t;
+
+static const char *class_names[SCREEN_CLASS_COUNT] = {
+    "load-error", "invalid-instruction", "stack-overflow", "stack-underflow", "address-error",
+    "exits",      "key-wait",            "halts",          "stuck",           "renders",
+    "blank",
+};
+
+typedef struct screen_options
+{
+    uint32_t frames;
+    uint32_t cycles_per_frame;
+    uint32_t jobs;
+    uint32_t memo_entries;
+    bool json;
+} screen_options_t;
+
+typedef struct screen_rom
+{
+    char *path;
+    screen_class_t class;
+    xochip_result_t result;         // what stopped it, XOCHIP_SUCCESS when it ran all frames
+    uint32_t frames;                // frames run
+    uint64_t instructions;          // instructions run
+    uint16_t counter;               // where it ended up, or the instruction that failed
+    uint16_t opcode;                // and what's there
+    uint32_t drawn_frames;          // frames that changed the display
+    uint32_t lit_pixels;            // pixels lit in either plane at the end, in the resolution it ended in
+    bool stuck;                     // the state stopped changing
+    bool used[XOCHIP_OP_COUNT];     // instructions it ran
+} screen_rom_t;
+
+typedef struct screen_queue
+{
+    screen_rom_t *roms;
+    size_t count;
+    size_t next; // first ROM nobody has taken yet
+    pthread_mutex_t lock;
+    const screen_options_t *options;
+} screen_queue_t;
+
+static bool has_rom_extension(const char *name)
+{
+    const char *dot = strrchr(name, '.');
+    return dot && (strcmp(dot, ".ch8") == 0 || strcmp(dot, ".xo8") == 0);
+}
+
+static bool add_rom(screen_queue_t *queue, size_t *capacity, const char *path)
+{
+    if (queue->count == *capacity)
+    {
+        *capacity = *capacity ? *capacity * 2 : 256;
+        screen_rom_t *grown = realloc(queue->roms, *capacity * sizeof(screen_rom_t));
+        if (!grown)
+        {
+            return false;
+        }
+        queue->roms = grown;
+    }
+
+    screen_rom_t *rom = &queue->roms[queue->count];
+    memset(rom, 0, sizeof(*rom));
+    rom->path = malloc(strlen(path) + 1);
+    if (!rom->path)
+    {
+        return false;
+    }
+    strcpy(rom->path, path);
+    queue->count++;
+    return true;
+}
+
+// Adds the ROMs in a directory, or the path itself when it isn't one
+static bool add_path(screen_queue_t *queue, size_t *capacity, const char *path)
+{
+    DIR *directory = opendir(path);
+    if (!directory)
+    {
+        return add_rom(queue, capacity, path);
+    }
+
+    bool ok = true;
+    for (struct dirent *entry = readdir(directory); entry && ok; entry = readdir(directory))
+    {
+        if (!has_rom_extension(entry->d_name))
+        {
+            continue;
+        }
+
+        char full[4096];
+        const int length = snprintf(full, sizeof(full), "%s/%s", path, entry->d_name);
+        ok = length > 0 && (size_t)length < sizeof(full) && add_rom(queue, capacity, full);
+    }
+
+    closedir(directory);
+    return ok;
+}
+
+static int compare_roms(const void *a, const void *b)
+{
+    return strcmp(((const screen_rom_t *)a)->path, ((const screen_rom_t *)b)->path);
+}
+
+static uint16_t opcode_at(const xochip_t *emulator, const uint16_t address)
+{
+    return (uint16_t)(xochip_peek(emulator, address) << 8 | xochip_peek(emulator, (uint16_t)(address + 1)));
+}
+
+static uint32_t lit_pixels(const xochip_display_t *display)
+{
+    uint32_t count = 0;
+    for (size_t index = 0; index < sizeof(display->back_plane); ++index)
+    {
+        uint8_t lit = display->back_plane[index] | display->fore_plane[index];
+        for (; lit; lit &= (uint8_t)(lit - 1))
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+static screen_class_t classify(const screen_rom_t *rom)
+{
+    switch (rom->result)
+    {
+    case XOCHIP_SUCCESS:
+        break;
+    case XOCHIP_ERR_INVALID_INSTRUCTION:
+        return SCREEN_INVALID_INSTRUCTION;
+    case XOCHIP_ERR_STACK_OVERFLOW:
+        return SCREEN_STACK_OVERFLOW;
+    case XOCHIP_ERR_STACK_UNDERFLOW:
+        return SCREEN_STACK_UNDERFLOW;
+    case XOCHIP_ERR_ADDRESS_OVERFLOW:
+    case XOCHIP_ERR_ADDRESS_UNDERFLOW:
+        return SCREEN_ADDRESS_ERROR;
+    case XOCHIP_EXITED:
+        return SCREEN_EXITS;
+    default:
+        return SCREEN_LOAD_ERROR;
+    }
+
+    const xochip_op_t op = xochip_decode(rom->opcode);
+    if (op == XOCHIP_OP_LD_VX_K)
+    {
+        return SCREEN_KEY_WAIT;
+    }
+
+    if (op == XOCHIP_OP_JP_ADDR && OPCODE_NNN(rom->opcode) == rom->counter)
+    {
+        return SCREEN_HALTS;
+    }
+
+    if (rom->stuck)
+    {
+        return SCREEN_STUCK;
+    }
+
+    return rom->lit_pixels || rom->drawn_frames ? SCREEN_RENDERS : SCREEN_BLANK;
+}
+
+// One instruction at a time, so every instruction that runs is seen, with the timers ticking once per frame
+static void screen_rom(xochip_t *emulator, xochip_hash_t *hash, xochip_memo_t *memo, screen_rom_t *rom,
+                       const screen_options_t *options)
+{
+    xochip_init(emulator);
+    xochip_attach_hash(emulator, hash);
+    // forget the last ROM's frames, a replayed frame's instructions have to be in used already
+    xochip_memo_init(memo, memo->entries, memo->count);
+    rom->result = xochip_load_rom_file(emulator, rom->path);
+    if (rom->result != XOCHIP_SUCCESS)
+    {
+        rom->class = SCREEN_LOAD_ERROR;
+        return;
+    }
+
+    xochip_result_t result = XOCHIP_SUCCESS;
+    uint16_t last = emulator->counter;
+    uint64_t previous = xochip_state_hash(emulator);
+    for (rom->frames = 0; rom->frames < options->frames && result == XOCHIP_SUCCESS && !rom->stuck; ++rom->frames)
+    {
+        const uint64_t cycles = emulator->cycles;
+        if (xochip_memo_replay(memo, emulator, NULL))
+        {
+            rom->instructions += emulator->cycles - cycles;
+        }
+        else
+        {
+            for (uint32_t cycle = 0; cycle < options->cycles_per_frame; ++cycle)
+            {
+                last = emulator->counter;
+                rom->used[xochip_decode(opcode_at(emulator, last))] = true;
+                result = xochip_cycle(emulator);
+                if (result != XOCHIP_SUCCESS)
+                {
+                    break;
+                }
+                rom->instructions++;
+            }
+            xochip_memo_record(memo, emulator, NULL, result);
+        }
+
+        if (emulator->display.updated)
+        {
+            rom->drawn_frames++;
+            emulator->display.updated = false;
+        }
+        xochip_tick(emulator);
+
+        const uint64_t current = xochip_state_hash(emulator);
+        rom->stuck = result == XOCHIP_SUCCESS && current == previous;
+        previous = current;
+    }
+
+    // on an error, point at the instruction that caused it rather than past it
+    rom->result = result;
+    rom->counter = result == XOCHIP_SUCCESS ? emulator->counter : last;
+    rom->opcode = opcode_at(emulator, emulator->counter);
+    rom->lit_pixels = lit_pixels(&emulator->display);
+    rom->class = classify(rom);
+}
+
+static void *screen_worker(void *data)
+{
+    screen_queue_t *queue = data;
+    xochip_t *emulator = malloc(sizeof(xochip_t));
+    xochip_hash_t *hash = malloc(sizeof(xochip_hash_t));
+    xochip_memo_entry_t *entries = malloc(queue->options->memo_entries * sizeof(xochip_memo_entry_t));
+    if (!emulator || !hash || !entries)
+    {
+        free(emulator);
+        free(hash);
+        free(entries);
+        return NULL;
+    }
+    xochip_memo_t memo;
+    xochip_memo_init(&memo, entries, queue->options->memo_entries);
+
+    for (;;)
+    {
+        pthread_mutex_lock(&queue->lock);
+        const size_t index = queue->next < queue->count ? queue->next++ : queue->count;
+        pthread_mutex_unlock(&queue->lock);
+
+        if (index == queue->count)
+        {
+            break;
+        }
+        screen_rom(emulator, hash, &memo, &queue->roms[index], queue->options);
+    }
+
+    free(emulator);
+    free(hash);
+    free(entries);
+    return NULL;
+}
+
+static const char *platform(const screen_rom_t *rom)
+{
+    for (int op = XOCHIP_OP_SAVE_VX_VY; op <= XOCHIP_OP_SCU_N; ++op)
+    {
+        if (rom->used[op])
+        {
+            return "xo-chip";
+        }
+    }
+
+    for (int op = XOCHIP_OP_SCD_N; op <= XOCHIP_OP_LD_VX_R; ++op)
+    {
+        if (rom->used[op])
+        {
+            return "schip";
+        }
+    }
+
+    return "chip-8";
+}
+
+// The extended instructions a ROM ran, space separated
+static void extended_ops(const screen_rom_t *rom, char *out, const size_t size)
+{
+    size_t used = 0;
+    out[0] = '\0';
+
+    for (int op = XOCHIP_OP_SCD_N; op <= XOCHIP_OP_SCU_N; ++op)
+    {
+        if (rom->used[op])
+        {
+            const int length = snprintf(out + used, size - used, "%s%s", used ? " " : "", xochip_op_name(op));
+            if (length < 0 || (size_t)length >= size - used)
+            {
+                break;
+            }
+            used += (size_t)length;
+        }
+    }
+}
+
+static void print_csv_field(const char *text)
+{
+    putchar('"');
+    for (; *text; ++text)
+    {
+        if (*text == '"')
+        {
+            putchar('"');
+        }
+        putchar(*text);
+    }
+    putchar('"');
+}
+
+static void print_json_string(const char *text)
+{
+    putchar('"');
+    for (; *text; ++text)
+    {
+        const unsigned char c = (unsigned char)*text;
+        if (c == '"' || c == '\\')
+        {
+            printf("\\%c", c);
+        }
+        else if (c < 0x20)
+        {
+            printf("\\u%04x", c);
+        }
+        else
+        {
+            putchar(c);
+        }
+    }
+    putchar('"');
+}
+
+static void print_report(const screen_queue_t *queue, const bool json)
+{
+    if (json)
+    {
+        printf("[\n");
+    }
+    else
+    {
+        printf("rom,class,platform,result,frames,instructions,pc,opcode,drawn_frames,lit_pixels,extended\n");
+    }
+
+    for (size_t index = 0; index < queue->count; ++index)
+    {
+        const screen_rom_t *rom = &queue->roms[index];
+        char extended[512];
+        extended_ops(rom, extended, sizeof(extended));
+
+        if (json)
+        {
+            printf("  {\"rom\": ");
+            print_json_string(rom->path);
+            printf(", \"class\": \"%s\", \"platform\": \"%s\", \"result\": \"%s\", \"frames\": %u, "
+                   "\"instructions\": %llu, \"pc\": \"%04X\", \"opcode\": \"%04X\", \"drawn_frames\": %u, "
+                   "\"lit_pixels\": %u, \"extended\": [",
+                   class_names[rom->class], platform(rom), xochip_strerror(rom->result), (unsigned)rom->frames,
+                   (unsigned long long)rom->instructions, rom->counter, rom->opcode, (unsigned)rom->drawn_frames,
+                   (unsigned)rom->lit_pixels);
+
+            for (char *name = strtok(extended, " "), *first = name; name; name = strtok(NULL, " "))
+            {
+                printf("%s\"%s\"", name == first ? "" : ", ", name);
+            }
+            printf("]}%s\n", index + 1 < queue->count ? "," : "");
+        }
+        else
+        {
+            print_csv_field(rom->path);
+            printf(",%s,%s,%s,%u,%llu,%04X,%04X,%u,%u,%s\n", class_names[rom->class], platform(rom),
+                   xochip_strerror(rom->result), (unsigned)rom->frames, (unsigned long long)rom->instructions,
+                   rom->counter, rom->opcode, (unsigned)rom->drawn_frames, (unsigned)rom->lit_pixels, extended);
+        }
+    }
+
+    if (json)
+    {
+        printf("]\n");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    screen_options_t options = {600, 1000, cores > 0 ? (uint32_t)cores : 1, 1024, false};
+    screen_queue_t queue = {NULL, 0, 0, PTHREAD_MUTEX_INITIALIZER, &options};
+    size_t capacity = 0;
+    bool paths = false;
+
+    for (int arg = 1; arg < argc; ++arg)
+    {
+        uint32_t *option = NULL;
+        if (strcmp(argv[arg], "--frames") == 0)
+        {
+            option = &options.frames;
+        }
+        else if (strcmp(argv[arg], "--ipf") == 0)
+        {
+            option = &options.cycles_per_frame;
+        }
+        else if (strcmp(argv[arg], "--jobs") == 0)
+        {
+            option = &options.jobs;
+        }
+        else if (strcmp(argv[arg], "--memo") == 0)
+        {
+            option = &options.memo_entries;
+        }
+        else if (strcmp(argv[arg], "--json") == 0)
+        {
+            options.json = true;
+            continue;
+        }
+        else
+        {
+            if (!add_path(&queue, &capacity, argv[arg]))
+            {
+                fprintf(stderr, "Out of memory\n");
+                return 1;
+            }
+            paths = true;
+            continue;
+        }
+
+        if (++arg >= argc || (*option = (uint32_t)strtoul(argv[arg], NULL, 10)) == 0)
+        {
+            fprintf(stderr, "%s needs a number above 0\n", argv[arg - 1]);
+            return 1;
+        }
+    }
+
+    if (!paths)
+    {
+        fprintf(stderr,
+                "usage: %s [--frames <n>] [--ipf <n>] [--jobs <n>] [--memo <n>] [--json] <directory or rom>...\n",
+                argv[0]);
+        return 1;
+    }
+
+    // the report comes out in the same order however the work was spread
+    if (queue.count > 1)
+    {
+        qsort(queue.roms, queue.count, sizeof(screen_rom_t), compare_roms);
+    }
+
+    struct timespec start;
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    const uint32_t jobs = options.jobs < queue.count ? options.jobs : (uint32_t)(queue.count ? queue.count : 1);
+    pthread_t *threads = malloc(jobs * sizeof(pthread_t));
+    uint32_t started = 0;
+    for (; threads && started < jobs; ++started)
+    {
+        if (pthread_create(&threads[started], NULL, screen_worker, &queue) != 0)
+        {
+            break;
+        }
+    }
+
+    // without any threads (or memory for them) this thread does the work
+    if (started == 0)
+    {
+        screen_worker(&queue);
+    }
+    for (uint32_t thread = 0; thread < started; ++thread)
+    {
+        pthread_join(threads[thread], NULL);
+    }
+    free(threads);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    const double seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+
+    print_report(&queue, options.json);
+
+    uint32_t counts[SCREEN_CLASS_COUNT] = {0};
+    for (size_t index = 0; index < queue.count; ++index)
+    {
+        counts[queue.roms[index].class]++;
+        free(queue.roms[index].path);
+    }
+    free(queue.roms);
+
+    fprintf(stderr, "%zu ROMs in %.2f s on %u threads (%.0f per minute):", queue.count, seconds, (unsigned)jobs,
+            seconds > 0.0 ? (double)queue.count * 60.0 / seconds : 0.0);
+    for (int class = 0; class < SCREEN_CLASS_COUNT; ++class)
+    {
+        if (counts[class])
+        {
+            fprintf(stderr, " %u %s", (unsigned)counts[class], class_names[class]);
+        }
+    }
+    fprintf(stderr, "\n");
+    return 0;
+}
@@ -0,0 +1,319 @@
+//
+// Terminal frontend, for watching a ROM on a machine without a display, e.g. a build host over SSH. Draws with
+// xochip_terminal.h, so after the first frame only the cells that changed are sent. Needs a terminal of at least 128x33
+// characters, or 64x33 with --quadrants, with 24-bit colour unless --ansi16 is given.
+//
+//     xochip-terminal [--quadrants] [--ansi16] [--ipf <n>|auto] [--frames <n>] <rom>
+//
+// It runs 1000 instructions per frame, or with --ipf auto as many as xochip_calibrate finds the game needs.
+//
+// The keys are laid out like the desktop demo's: 1234, QWER, ASDF, ZXCV. Terminals only say when a key was pressed,
+// so a key counts as held for a moment after it was pressed, long enough to bridge the pause before autorepeat kicks
+// in, and for as long as autorepeat keeps pressing it. Ctrl-C quits, so does running --frames frames. How much was
+// sent per frame is printed when it's done.
+//
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define XOCHIP_IMPLEMENTATION
+#include "xochip.h"
+#include "xochip_file.h"
+#include "xochip_terminal.h"
+
+#define FRAME_NANOSECONDS 16666667L
+
+// A fresh press is held past the usual autorepeat delay, a repeat only until the next one is due
+#define KEY_PRESS_FRAMES 30
+#define KEY_REPEAT_FRAMES 4
+
+// How many late frames are caught up on before the clock is reset, e.g. after the process was stopped
+#define MAX_LATE_FRAMES 4
+
+// What --ipf auto starts with and may pick
+#define MIN_CALIBRATED_CYCLES 2
+#define INITIAL_CALIBRATED_CYCLES 8
+#define MAX_CALIBRATED_CYCLES 100000
+
+// Too big for the stack
+static xochip_t emulator;
+static xochip_terminal_t terminal;
+
+static volatile sig_atomic_t quit;
+static volatile sig_atomic_t resized;
+
+static struct termios saved_termios;
+static bool raw_input;
+
+static void on_quit(int signal_number)
+{
+    (void)signal_number;
+    quit = 1;
+}
+
+static void on_resize(int signal_number)
+{
+    (void)signal_number;
+    resized = 1;
+}
+
+static bool write_stdout(void *context, const uint8_t *data, size_t size)
+{
+    (void)context;
+    while (size > 0)
+    {
+        const ssize_t written = write(STDOUT_FILENO, data, size);
+        if (written < 0 && errno != EINTR)
+        {
+            return false;
+        }
+        if (written > 0)
+        {
+            data += written;
+            size -= (size_t)written;
+        }
+    }
+    return true;
+}
+
+// Key presses arrive as they're typed, reads never wait for them. Ctrl-C still raises SIGINT.
+static void start_raw_input(void)
+{
+    if (!isatty(STDIN_FILENO) || tcgetattr(STDIN_FILENO, &saved_termios) != 0)
+    {
+        return;
+    }
+
+    struct termios raw = saved_termios;
+    raw.c_lflag &= (tcflag_t) ~(ICANON | ECHO);
+    raw.c_cc[VMIN] = 0;
+    raw.c_cc[VTIME] = 0;
+    raw_input = tcsetattr(STDIN_FILENO, TCSANOW, &raw) == 0;
+}
+
+static void stop_raw_input(void)
+{
+    if (raw_input)
+    {
+        tcsetattr(STDIN_FILENO, TCSANOW, &saved_termios);
+        raw_input = false;
+    }
+}
+
+static int key_for(const char character)
+{
+    static const char layout[XOCHIP_KEYCOUNT + 1] = "x123qweasdzc4rfv";
+    const char *found = character ? strchr(layout, character | 0x20) : NULL;
+    return found ? (int)(found - layout) : -1;
+}
+
+// Presses whatever was typed since the last frame and lets go of keys that weren't pressed again in time
+static void update_keys(uint8_t held[XOCHIP_KEYCOUNT])
+{
+    char typed[64];
+    const ssize_t count = raw_input ? read(STDIN_FILENO, typed, sizeof(typed)) : 0;
+
+    for (ssize_t index = 0; index < count; ++index)
+    {
+        const int key = key_for(typed[index]);
+        if (key >= 0)
+        {
+            held[key] = held[key] ? KEY_REPEAT_FRAMES : KEY_PRESS_FRAMES;
+            xochip_key_down(&emulator, (xochip_keys_t)key);
+        }
+    }
+
+    for (int key = 0; key < XOCHIP_KEYCOUNT; ++key)
+    {
+        if (held[key] && --held[key] == 0)
+        {
+            xochip_key_up(&emulator, (xochip_keys_t)key);
+        }
+    }
+}
+
+static bool parse_number(const char *text, uint32_t *number)
+{
+    char *end = NULL;
+    const unsigned long value = strtoul(text, &end, 10);
+    if (end == text || *end != '\0' || value == 0)
+    {
+        return false;
+    }
+
+    *number = (uint32_t)value;
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    xochip_terminal_mode_t mode = XOCHIP_TERMINAL_HALF_BLOCKS;
+    xochip_terminal_colours_t colours = XOCHIP_TERMINAL_TRUECOLOUR;
+    uint32_t cycles_per_frame = 1000;
+    bool calibrating = false;
+    uint32_t frames = 0;
+    const char *rom = NULL;
+
+    for (int arg = 1; arg < argc; ++arg)
+    {
+        const bool has_value = arg + 1 < argc;
+
+        if (strcmp(argv[arg], "--quadrants") == 0)
+        {
+            mode = XOCHIP_TERMINAL_QUADRANTS;
+        }
+        else if (strcmp(argv[arg], "--ansi16") == 0)
+        {
+            colours = XOCHIP_TERMINAL_ANSI16;
+        }
+        else if (strcmp(argv[arg], "--ipf") == 0 && has_value && strcmp(argv[arg + 1], "auto") == 0)
+        {
+            calibrating = true;
+            cycles_per_frame = INITIAL_CALIBRATED_CYCLES;
+            arg++;
+        }
+        else if (strcmp(argv[arg], "--ipf") == 0 && has_value && parse_number(argv[arg + 1], &cycles_per_frame))
+        {
+            calibrating = false;
+            arg++;
+        }
+        else if (strcmp(argv[arg], "--frames") == 0 && has_value && parse_number(argv[arg + 1], &frames))
+        {
+            arg++;
+        }
+        else if (argv[arg][0] != '-' && !rom)
+        {
+            rom = argv[arg];
+        }
+        else
+        {
+            rom = NULL;
+            break;
+        }
+    }
+
+    if (!rom)
+    {
+        fprintf(stderr, "usage: %s [--quadrants] [--ansi16] [--ipf <n>|auto] [--frames <n>] <rom>\n", argv[0]);
+        return 2;
+    }
+
+    xochip_init(&emulator);
+    const xochip_result_t load_result = xochip_load_rom_file(&emulator, rom);
+    if (load_result != XOCHIP_SUCCESS)
+    {
+        fprintf(stderr, "Failed to load ROM %s: %s\n", rom, xochip_strerror(load_result));
+        return 2;
+    }
+
+    // Octo's default palette, like the desktop demo
+    static const uint32_t palette[4] = {0x996600, 0xFFCC00, 0xFF6600, 0x662200};
+    xochip_terminal_init(&terminal, mode, colours, palette, write_stdout, NULL);
+
+    xochip_scheduler_t scheduler;
+    xochip_scheduler_init(&scheduler, cycles_per_frame, 0);
+
+    xochip_frame_stats_t stats;
+    xochip_calibrator_t calibrator;
+    if (calibrating)
+    {
+        xochip_calibrator_init(&calibrator, MIN_CALIBRATED_CYCLES, MAX_CALIBRATED_CYCLES, cycles_per_frame);
+        xochip_attach_stats(&emulator, &stats);
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = on_quit;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    action.sa_handler = on_resize;
+    sigaction(SIGWINCH, &action, NULL);
+    start_raw_input();
+
+    uint8_t held[XOCHIP_KEYCOUNT] = {0};
+    xochip_result_t result = XOCHIP_SUCCESS;
+    uint32_t frame = 0;
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+
+    while (!quit && result == XOCHIP_SUCCESS && (frames == 0 || frame < frames))
+    {
+        update_keys(held);
+
+        const uint64_t ticks = scheduler.ticks;
+        while (result == XOCHIP_SUCCESS && scheduler.ticks == ticks)
+        {
+            result = xochip_run_budget(&emulator, &scheduler, scheduler.cycles_per_tick - scheduler.tick_phase, NULL,
+                                       NULL);
+        }
+        frame++;
+
+        if (calibrating)
+        {
+            xochip_calibrate(&calibrator, &emulator, &scheduler);
+        }
+
+        if (resized)
+        {
+            resized = 0;
+            xochip_terminal_invalidate(&terminal);
+        }
+        if (xochip_terminal_draw(&terminal, &emulator.display) != XOCHIP_SUCCESS)
+        {
+            break;
+        }
+
+        deadline.tv_nsec += FRAME_NANOSECONDS;
+        if (deadline.tv_nsec >= 1000000000L)
+        {
+            deadline.tv_nsec -= 1000000000L;
+            deadline.tv_sec++;
+        }
+
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        const long long late =
+            (long long)(now.tv_sec - deadline.tv_sec) * 1000000000LL + (now.tv_nsec - deadline.tv_nsec);
+        if (late > MAX_LATE_FRAMES * FRAME_NANOSECONDS)
+        {
+            deadline = now;
+        }
+        else
+        {
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR && !quit)
+            {
+            }
+        }
+    }
+
+    xochip_terminal_finish(&terminal);
+    stop_raw_input();
+
+    fprintf(stderr, "%u frames, %llu bytes sent, %.0f per frame\n", (unsigned)frame,
+            (unsigned long long)terminal.written, frame ? (double)terminal.written / frame : 0.0);
+    if (calibrating)
+    {
+        fprintf(stderr, "calibrated to %u instructions per frame\n", (unsigned)calibrator.cycles_per_tick);
+    }
+
+    // a ROM that exits is done, anything else is a failure
+    if (result != XOCHIP_SUCCESS && result != XOCHIP_EXITED)
+    {
+        fprintf(stderr, "%s stopped at %04X: %s\n", rom, emulator.counter, xochip_strerror(result));
+        return 1;
+    }
+    if (terminal.result != XOCHIP_SUCCESS)
+    {
+        fprintf(stderr, "Failed to write to the terminal\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,894 @@
+//
+// Checks that don't fit a golden: of the core, each on a few instructions of hand written ROM, and of the environment
+// and the terminal renderer on made up displays. Prints what failed and exits nonzero when anything did.
+//
+//     xochip-test-core
+//
+
+#include <stdio.h>
+
+#define XOCHIP_IMPLEMENTATION
+#include "xochip.h"
+#include "xochip_disasm.h"
+#include "xochip_env.h"
+#include "xochip_terminal.h"
+
+// Too big for the stack
+static xochip_t emulator;
+static xochip_t fresh;
+static xochip_state_t snapshot;
+static xochip_cfg_t cfg;
+static xochip_debugger_t debugger;
+static xochip_decode_cache_t decode_cache;
+static xochip_env_t env;
+static xochip_env_instance_t instance;
+static uint8_t observation[2 * XOCHIP_DISPLAY_PIXELS];
+static uint8_t stacked[2][2 * XOCHIP_ENV_FRAME_SIZE];
+static xochip_frame_stats_t stats;
+static xochip_terminal_t drawn;
+static xochip_terminal_t redrawn;
+
+static int failures;
+
+#define CHECK(condition) check((condition), #condition, __LINE__)
+
+static void check(const bool ok, const char *condition, const int line)
+{
+    if (!ok)
+    {
+        fprintf(stderr, "tests/core.c:%d: failed: %s\n", line, condition);
+        failures++;
+    }
+}
+
+// Fills both planes with the same pseudo random bits for the same seed
+static void fill_noise(xochip_display_t *display, uint32_t noise)
+{
+    for (size_t index = 0; index < sizeof(display->back_plane); ++index)
+    {
+        noise ^= noise << 13;
+        noise ^= noise >> 17;
+        noise ^= noise << 5;
+        display->back_plane[index] = (uint8_t)noise;
+        display->fore_plane[index] = (uint8_t)(noise >> 8);
+    }
+}
+
+// =====================================================================================================================
+//    DEBUGGER
+// =====================================================================================================================
+
+// Whether running stopped where and why it should have
+static bool stopped(const xochip_stop_reason_t reason, const uint16_t address, const uint16_t counter)
+{
+    return xochip_run(&emulator, 100, NULL) == XOCHIP_STOPPED && debugger.stop_reason == reason &&
+           debugger.stop_address == address && emulator.counter == counter;
+}
+
+// Every instruction that writes or reads through I, watched on the last byte it touches, and a breakpoint before them.
+// Watched bytes next to what they touch, and reads of what's only written, don't stop anything.
+static void test_debugger(void)
+{
+    static const uint8_t rom[] = {
+        0xA3, 0x00, // 200 LD I, 300
+        0x60, 0x07, // 202 LD V0, 07
+        0x61, 0x08, // 204 LD V1, 08
+        0xF0, 0x33, // 206 LD B, V0     writes 300-302
+        0xA3, 0x10, // 208 LD I, 310
+        0xF2, 0x55, // 20A LD [I], V2   writes 310-312
+        0xA3, 0x20, // 20C LD I, 320
+        0x51, 0x32, // 20E SAVE V1 - V3 writes 320-322
+        0xA3, 0x30, // 210 LD I, 330
+        0xF1, 0x65, // 212 LD V1, [I]   reads 330-331
+        0xA3, 0x40, // 214 LD I, 340
+        0xF0, 0x02, // 216 AUDIO        reads 340-34F
+        0x12, 0x18, // 218 JP 218
+    };
+
+    xochip_init(&emulator);
+    xochip_load_rom(&emulator, rom, sizeof(rom));
+    xochip_attach_decode_cache(&emulator, &decode_cache);
+    CHECK(xochip_attach_debugger(&emulator, &debugger) == XOCHIP_SUCCESS);
+    xochip_save_state(&emulator, &snapshot);
+
+    CHECK(xochip_set_breakpoint(&emulator, 0x206) == XOCHIP_SUCCESS);
+    CHECK(xochip_set_watchpoint(&emulator, 0x302, 1, XOCHIP_WATCH_WRITE) == XOCHIP_SUCCESS);
+    CHECK(xochip_set_watchpoint(&emulator, 0x312, 1, XOCHIP_WATCH_WRITE) == XOCHIP_SUCCESS);
+    CHECK(xochip_set_watchpoint(&emulator, 0x322, 1, XOCHIP_WATCH_WRITE) == XOCHIP_SUCCESS);
+    CHECK(xochip_set_watchpoint(&emulator, 0x331, 1, XOCHIP_WATCH_READ) == XOCHIP_SUCCESS);
+    CHECK(xochip_set_watchpoint(&emulator, 0x34F, 1, XOCHIP_WATCH_READ) == XOCHIP_SUCCESS);
+
+    // a breakpoint stops before its instruction, even under xochip_run with a decode cache, and running again runs it
+    uint32_t executed = 0;
+    CHECK(xochip_run(&emulator, 100, &executed) == XOCHIP_STOPPED && executed == 3);
+    CHECK(debugger.stop_reason == XOCHIP_STOP_BREAKPOINT && debugger.stop_address == 0x206);
+    CHECK(emulator.counter == 0x206 && emulator.registers[1] == 0x08);
+
+    // watches stop after the instruction that touched them
+    CHECK(stopped(XOCHIP_STOP_WRITE, 0x302, 0x208));
+    CHECK(xochip_peek(&emulator, 0x302) == 7);
+    CHECK(stopped(XOCHIP_STOP_WRITE, 0x312, 0x20C));
+    CHECK(stopped(XOCHIP_STOP_WRITE, 0x322, 0x210));
+    CHECK(stopped(XOCHIP_STOP_READ, 0x331, 0x214));
+    CHECK(stopped(XOCHIP_STOP_READ, 0x34F, 0x218));
+    CHECK(xochip_run(&emulator, 100, NULL) == XOCHIP_SUCCESS && debugger.stop_reason == XOCHIP_STOP_NONE);
+
+    // cleared, nothing stops
+    CHECK(xochip_clear_breakpoint(&emulator, 0x206) == XOCHIP_SUCCESS);
+    CHECK(xochip_clear_watchpoint(&emulator, 0x300, 0x50, XOCHIP_WATCH_READ | XOCHIP_WATCH_WRITE) == XOCHIP_SUCCESS);
+    CHECK(!emulator.debugging);
+    xochip_load_state(&emulator, &snapshot);
+    CHECK(xochip_run(&emulator, 100, NULL) == XOCHIP_SUCCESS && emulator.counter == 0x218);
+
+    xochip_load_state(&emulator, &snapshot);
+    CHECK(xochip_set_watchpoint(&emulator, 0x303, 1, XOCHIP_WATCH_WRITE) == XOCHIP_SUCCESS);
+    CHECK(xochip_set_watchpoint(&emulator, 0x313, 1, XOCHIP_WATCH_WRITE) == XOCHIP_SUCCESS);
+    CHECK(xochip_set_watchpoint(&emulator, 0x323, 1, XOCHIP_WATCH_WRITE) == XOCHIP_SUCCESS);
+    CHECK(xochip_set_watchpoint(&emulator, 0x300, 1, XOCHIP_WATCH_READ) == XOCHIP_SUCCESS);
+    CHECK(xochip_set_watchpoint(&emulator, 0x332, 1, XOCHIP_WATCH_READ) == XOCHIP_SUCCESS);
+    CHECK(xochip_set_watchpoint(&emulator, 0x350, 1, XOCHIP_WATCH_READ) == XOCHIP_SUCCESS);
+    CHECK(xochip_run(&emulator, 100, NULL) == XOCHIP_SUCCESS && debugger.stop_reason == XOCHIP_STOP_NONE);
+    CHECK(emulator.counter == 0x218);
+
+    xochip_attach_debugger(&emulator, NULL);
+    xochip_attach_decode_cache(&emulator, NULL);
+}
+
+// =====================================================================================================================
+//    ROM LOADING
+// =====================================================================================================================
+
+// A ROM of size bytes made up as it's read, in chunks of at most chunk bytes, failing once failing bytes were read
+typedef struct rom_stream
+{
+    size_t size;
+    size_t chunk;
+    size_t failing;
+    size_t offset;
+} rom_stream_t;
+
+static uint8_t rom_byte(const size_t offset)
+{
+    return (uint8_t)(offset * 7 + 3);
+}
+
+static size_t read_stream(void *context, uint8_t *buffer, size_t size)
+{
+    rom_stream_t *stream = context;
+    if (stream->offset >= stream->failing)
+    {
+        return XOCHIP_READ_ERROR;
+    }
+
+    size = size < stream->chunk ? size : stream->chunk;
+    size = size < stream->size - stream->offset ? size : stream->size - stream->offset;
+    for (size_t index = 0; index < size; ++index)
+    {
+        buffer[index] = rom_byte(stream->offset + index);
+    }
+    stream->offset += size;
+    return size;
+}
+
+// Loads a streamed ROM, and tells whether it ended up in memory when it loaded
+static xochip_result_t load_stream(const size_t size, const size_t chunk, const size_t failing)
+{
+    rom_stream_t stream = {size, chunk, failing, 0};
+    xochip_init(&emulator);
+    const xochip_result_t result = xochip_load_rom_reader(&emulator, read_stream, &stream);
+
+    bool loaded = true;
+    for (size_t offset = 0; offset < size && result == XOCHIP_SUCCESS; ++offset)
+    {
+        loaded = loaded && xochip_peek(&emulator, (uint16_t)(XOCHIP_ADDRESS_SPACE_START + offset)) == rom_byte(offset);
+    }
+    return loaded ? result : XOCHIP_ERR_READ;
+}
+
+// Short chunks, a reader that fails, and with a 64kb memory a ROM that fills it and one a byte too big
+static void test_load_reader(void)
+{
+    CHECK(load_stream(1000, 7, SIZE_MAX) == XOCHIP_SUCCESS);
+    CHECK(load_stream(1000, 1, SIZE_MAX) == XOCHIP_SUCCESS);
+    CHECK(load_stream(0, 7, SIZE_MAX) == XOCHIP_SUCCESS);
+    CHECK(load_stream(1000, 7, 500) == XOCHIP_ERR_READ);
+    CHECK(load_stream(1000, 7, 0) == XOCHIP_ERR_READ);
+
+#ifndef XOCHIP_XIP
+    CHECK(load_stream(XOCHIP_ROM_SIZE_MAX, 4000, SIZE_MAX) == XOCHIP_SUCCESS);
+    CHECK(load_stream(XOCHIP_ROM_SIZE_MAX + 1, 4000, SIZE_MAX) == XOCHIP_ERR_ROM_TOO_LARGE);
+    CHECK(load_stream(XOCHIP_ROM_SIZE_MAX, 4000, XOCHIP_ROM_SIZE_MAX) == XOCHIP_ERR_READ);
+#else
+    CHECK(load_stream(XOCHIP_ROM_SIZE_MAX, 4000, SIZE_MAX) == XOCHIP_ERR_OUT_OF_PAGES);
+#endif
+}
+
+// =====================================================================================================================
+//    DISASSEMBLER
+// =====================================================================================================================
+
+// A call, a return, a skip over a 4 byte instruction, a jump and an exit, and 2 bytes of data nothing reaches
+static void test_cfg(void)
+{
+    static const uint8_t rom[] = {
+        0x22, 0x0C,             // 200 CALL 20C
+        0x30, 0x01,             // 202 SE V0, 01
+        0xF0, 0x00, 0x03, 0x00, // 204 LD I, 0300
+        0x12, 0x0A,             // 208 JP 20A
+        0x00, 0xFD,             // 20A EXIT
+        0x60, 0x01,             // 20C LD V0, 01
+        0x00, 0xEE,             // 20E RET
+        0xAB, 0xCD,             // 210 data
+    };
+    static const xochip_block_t expected[] = {
+        {0x200, 0x200, 1, {0x20C, 0x202}, 2, XOCHIP_BLOCK_ENTRY | XOCHIP_BLOCK_CALL},
+        {0x202, 0x202, 1, {0x204, 0x208}, 2, 0},
+        {0x204, 0x204, 1, {0x208, 0}, 1, 0},
+        {0x208, 0x208, 1, {0x20A, 0}, 1, 0},
+        {0x20A, 0x20A, 1, {0, 0}, 0, XOCHIP_BLOCK_EXIT},
+        {0x20C, 0x20E, 2, {0, 0}, 0, XOCHIP_BLOCK_CALL_TARGET | XOCHIP_BLOCK_RETURN},
+    };
+
+    CHECK(xochip_cfg_build(&cfg, rom, sizeof(rom)) == XOCHIP_SUCCESS);
+    CHECK(!cfg.truncated);
+    CHECK(cfg.block_count == sizeof(expected) / sizeof(expected[0]));
+    for (size_t index = 0; index < cfg.block_count && index < sizeof(expected) / sizeof(expected[0]); ++index)
+    {
+        const xochip_block_t *block = &cfg.blocks[index];
+        const xochip_block_t *want = &expected[index];
+        CHECK(block->start == want->start && block->last == want->last);
+        CHECK(block->instruction_count == want->instruction_count && block->flags == want->flags);
+        CHECK(block->successor_count == want->successor_count);
+        for (uint8_t successor = 0; successor < block->successor_count && successor < 2; ++successor)
+        {
+            CHECK(block->successors[successor] == want->successors[successor]);
+        }
+    }
+
+    CHECK(xochip_cfg_is_code(&cfg, 0x207) && xochip_cfg_is_code(&cfg, 0x20F));
+    CHECK(!xochip_cfg_is_code(&cfg, 0x210) && !xochip_cfg_is_code(&cfg, 0x211));
+
+    // the long load is one instruction, and one that runs off the end doesn't decode
+    xochip_instruction_t instruction;
+    CHECK(xochip_disasm_decode(rom, sizeof(rom), 0x204, &instruction));
+    CHECK(instruction.op == XOCHIP_OP_LD_I_LONG && instruction.size == 4 && instruction.operand == 0x0300);
+    CHECK(!xochip_disasm_decode(rom, 6, 0x204, &instruction));
+}
+
+// =====================================================================================================================
+//    RUN BUDGET
+// =====================================================================================================================
+
+static xochip_scheduler_t scheduler;
+
+// Whether a run of budget cycles ran consumed of them and returned for reason
+static bool ran(const uint32_t budget, const uint32_t consumed, const xochip_yield_t reason)
+{
+    uint32_t spent = 0;
+    xochip_yield_t yield = XOCHIP_YIELD_BUDGET;
+    return xochip_run_budget(&emulator, &scheduler, budget, &spent, &yield) == XOCHIP_SUCCESS && spent == consumed &&
+           yield == reason;
+}
+
+// Budgets that run out mid tick, frames that end on a tick with a changed display, audio periods between them, and an
+// instruction that ends past the budget and a tick, each carried over into the next run
+static void test_run_budget(void)
+{
+    // LD V0, 05, LD DT, V0, halt
+    static const uint8_t idle[] = {0x60, 0x05, 0xF0, 0x15, 0x12, 0x04};
+    // DRW V0, V1, 5, halt
+    static const uint8_t draw[] = {0xD0, 0x15, 0x12, 0x02};
+
+    xochip_init(&emulator);
+    xochip_load_rom(&emulator, idle, sizeof(idle));
+    xochip_scheduler_init(&scheduler, 10, 0);
+    CHECK(ran(4, 4, XOCHIP_YIELD_BUDGET) && scheduler.tick_phase == 4 && scheduler.ticks == 0);
+    CHECK(ran(4, 4, XOCHIP_YIELD_BUDGET) && scheduler.tick_phase == 8 && scheduler.ticks == 0);
+
+    // a new display is a frame to draw, the ticks after it aren't
+    CHECK(ran(4, 2, XOCHIP_YIELD_FRAME) && scheduler.tick_phase == 0 && scheduler.ticks == 1);
+    CHECK(ran(14, 14, XOCHIP_YIELD_BUDGET) && scheduler.tick_phase == 4 && scheduler.ticks == 2);
+    CHECK(emulator.registers[XOCHIP_VDELAY] == 3 && scheduler.cycles == 24);
+
+    // the frame ends at the tick after the draw, the next one draws nothing and runs the whole budget
+    xochip_init(&emulator);
+    xochip_load_rom(&emulator, draw, sizeof(draw));
+    emulator.display.updated = false;
+    xochip_scheduler_init(&scheduler, 10, 0);
+    CHECK(ran(100, 10, XOCHIP_YIELD_FRAME) && scheduler.tick_phase == 0 && scheduler.ticks == 1);
+    CHECK(!emulator.display.updated);
+    CHECK(ran(100, 100, XOCHIP_YIELD_BUDGET) && scheduler.ticks == 11);
+
+    // audio every 4 cycles, across the tick at 10
+    xochip_init(&emulator);
+    xochip_load_rom(&emulator, idle, sizeof(idle));
+    emulator.display.updated = false;
+    xochip_scheduler_init(&scheduler, 10, 4);
+    CHECK(ran(100, 4, XOCHIP_YIELD_AUDIO) && scheduler.audio_phase == 0 && scheduler.tick_phase == 4);
+    CHECK(ran(100, 4, XOCHIP_YIELD_AUDIO) && scheduler.audio_phase == 0 && scheduler.tick_phase == 8);
+    CHECK(ran(100, 4, XOCHIP_YIELD_AUDIO) && scheduler.tick_phase == 2 && scheduler.ticks == 1);
+    CHECK(ran(3, 3, XOCHIP_YIELD_BUDGET) && scheduler.audio_phase == 3 && scheduler.tick_phase == 5);
+    CHECK(ran(100, 1, XOCHIP_YIELD_AUDIO) && scheduler.audio_phase == 0);
+
+    // every instruction costs 3, the fourth ends 2 past both the budget and the tick
+    static xochip_cost_table_t threes;
+    for (uint32_t op = 0; op < XOCHIP_OP_COUNT; ++op)
+    {
+        threes.ops[op] = 3;
+    }
+    threes.cycles_per_tick = 10;
+    xochip_init(&emulator);
+    xochip_load_rom(&emulator, idle, sizeof(idle));
+    xochip_set_costs(&emulator, &threes);
+    emulator.display.updated = false;
+    xochip_scheduler_init(&scheduler, 10, 0);
+    CHECK(ran(10, 12, XOCHIP_YIELD_BUDGET) && scheduler.tick_phase == 2 && scheduler.ticks == 1);
+    CHECK(ran(1, 3, XOCHIP_YIELD_BUDGET) && scheduler.tick_phase == 5 && scheduler.cycles == 15);
+
+    // and the second ends 2 into the next audio period
+    xochip_scheduler_init(&scheduler, 10, 4);
+    CHECK(ran(100, 6, XOCHIP_YIELD_AUDIO) && scheduler.audio_phase == 2 && scheduler.tick_phase == 6);
+    xochip_set_costs(&emulator, NULL);
+}
+
+// =====================================================================================================================
+//    COSTS
+// =====================================================================================================================
+
+// Runs one frame of a loop that ends in ADD I, V1 with V1 = 1, so I counts the trips around it
+static uint16_t loops_per_frame(const uint8_t *rom, const size_t size, const xochip_cost_table_t *costs,
+                                const uint32_t cycles_per_tick)
+{
+    xochip_init(&emulator);
+    xochip_load_rom(&emulator, rom, size);
+    xochip_set_costs(&emulator, costs);
+
+    xochip_scheduler_t scheduler;
+    xochip_scheduler_init(&scheduler, cycles_per_tick, 0);
+    xochip_result_t result = XOCHIP_SUCCESS;
+    while (result == XOCHIP_SUCCESS && scheduler.ticks == 0)
+    {
+        result = xochip_run_budget(&emulator, &scheduler, cycles_per_tick - scheduler.tick_phase, NULL, NULL);
+    }
+
+    CHECK(result == XOCHIP_SUCCESS);
+    return emulator.address;
+}
+
+// Every preset charges a draw more than a plain instruction, so a loop around a 5 row sprite fits fewer times into a
+// frame than the same loop around a register load. Without a table both go around as often.
+static void test_costs(void)
+{
+    static const uint8_t draws[] = {0x61, 0x01, 0xD0, 0x05, 0xF1, 0x1E, 0x12, 0x02};
+    static const uint8_t loads[] = {0x61, 0x01, 0x60, 0x05, 0xF1, 0x1E, 0x12, 0x02};
+
+    for (int preset = 0; preset < XOCHIP_COST_PRESET_COUNT; ++preset)
+    {
+        const xochip_cost_table_t *costs = xochip_cost_preset((xochip_cost_preset_t)preset);
+        const uint32_t cycles = costs->cycles_per_tick;
+
+        const uint16_t costed_draws = loops_per_frame(draws, sizeof(draws), costs, cycles);
+        const uint16_t costed_loads = loops_per_frame(loads, sizeof(loads), costs, cycles);
+        CHECK(costed_draws > 0);
+        CHECK(costed_draws < costed_loads);
+        CHECK(loops_per_frame(draws, sizeof(draws), NULL, cycles) ==
+              loops_per_frame(loads, sizeof(loads), NULL, cycles));
+    }
+
+    // a draw waits for the VIP's display interrupt, it's more than 10 times what a load is there
+    const xochip_cost_table_t *vip = xochip_cost_preset(XOCHIP_COST_VIP);
+    CHECK(loops_per_frame(draws, sizeof(draws), vip, vip->cycles_per_tick) * 10 <
+          loops_per_frame(loads, sizeof(loads), vip, vip->cycles_per_tick));
+}
+
+// =====================================================================================================================
+//    DIRTY PAGES
+// =====================================================================================================================
+
+// Whether the machine is the same as one that just loaded rom and never ran
+static bool same_as_loaded(const uint8_t *rom, const size_t size)
+{
+    xochip_init(&fresh);
+    xochip_load_rom(&fresh, rom, size);
+    return xochip_state_hash(&emulator) == xochip_state_hash(&fresh);
+}
+
+// Writes that land outside the ROM's pages, in free memory and over the fonts in page 0, have to be undone by a reset
+// and by restoring a snapshot, which only copy the pages marked dirty
+static void test_dirty_pages(void)
+{
+    // I = 800, V0 = 42, Fx55, I = 000, Fx55, halt
+    static const uint8_t rom[] = {0xA8, 0x00, 0x60, 0x42, 0xF0, 0x55, 0xA0, 0x00, 0xF0, 0x55, 0x12, 0x0A};
+
+    xochip_init(&emulator);
+    xochip_load_rom(&emulator, rom, sizeof(rom));
+    xochip_save_state(&emulator, &snapshot);
+    CHECK(xochip_run(&emulator, 5, NULL) == XOCHIP_SUCCESS);
+    CHECK(xochip_peek(&emulator, 0x800) == 0x42 && xochip_peek(&emulator, 0x000) == 0x42);
+    CHECK(!same_as_loaded(rom, sizeof(rom)));
+
+    CHECK(xochip_load_state(&emulator, &snapshot) == XOCHIP_SUCCESS);
+    CHECK(same_as_loaded(rom, sizeof(rom)));
+
+    CHECK(xochip_run(&emulator, 5, NULL) == XOCHIP_SUCCESS);
+    CHECK(xochip_reset(&emulator) == XOCHIP_SUCCESS);
+    CHECK(xochip_load_rom(&emulator, rom, sizeof(rom)) == XOCHIP_SUCCESS);
+    CHECK(same_as_loaded(rom, sizeof(rom)));
+}
+
+#ifdef XOCHIP_XIP
+// A write that runs from the last page there's a copy for into one there isn't stops the ROM, keeps what made it into
+// the copy and leaves the other page as it was and unmarked
+static void test_out_of_pages(void)
+{
+    // V0 = 11, V1 = 22, then I = 1000 + 100 * page and Fx55 for every copy, I = the last byte of them, F155, halt
+    static uint8_t rom[4 + 6 * XOCHIP_XIP_PAGES + 8];
+    uint32_t size = 0;
+    const uint8_t start[] = {0x60, 0x11, 0x61, 0x22};
+    memcpy(rom, start, sizeof(start));
+    size += sizeof(start);
+    for (uint32_t page = 0; page <= XOCHIP_XIP_PAGES; ++page)
+    {
+        const uint32_t address = 0x1000 + page * XOCHIP_PAGE_SIZE - (page == XOCHIP_XIP_PAGES);
+        const uint8_t write[] = {0xF0, 0x00, (uint8_t)(address >> 8), (uint8_t)address,
+                               (uint8_t)(0xF0 | (page == XOCHIP_XIP_PAGES)), 0x55};
+        memcpy(rom + size, write, sizeof(write));
+        size += sizeof(write);
+    }
+    rom[size] = (uint8_t)(0x10 | (XOCHIP_ADDRESS_SPACE_START + size) >> 8);
+    rom[size + 1] = (uint8_t)(XOCHIP_ADDRESS_SPACE_START + size);
+    size += 2;
+
+    const uint32_t last = 0x1000 + XOCHIP_XIP_PAGES * XOCHIP_PAGE_SIZE - 1;
+    const uint32_t page = last / XOCHIP_PAGE_SIZE;
+    xochip_init(&emulator);
+    CHECK(xochip_load_rom(&emulator, rom, size) == XOCHIP_SUCCESS);
+    CHECK(xochip_run(&emulator, 1000, NULL) == XOCHIP_ERR_OUT_OF_PAGES);
+    CHECK(emulator.pages_used == XOCHIP_XIP_PAGES);
+    CHECK(xochip_peek(&emulator, (uint16_t)last) == 0x11 && xochip_peek(&emulator, (uint16_t)(last + 1)) == 0);
+    CHECK(XOCHIP_BITMAP_TEST(emulator.dirty_pages, page) && !XOCHIP_BITMAP_TEST(emulator.dirty_pages, page + 1));
+}
+#endif
+
+// =====================================================================================================================
+//    DISPLAY
+// =====================================================================================================================
+
+// The row of the 128x64 picture xochip_display_row gives for plane 0, as its first two bytes
+static uint16_t picture_row(const uint8_t y)
+{
+    uint8_t scratch[XOCHIP_DISPLAY_ROW_BYTES];
+    const uint8_t *row = xochip_display_row(&emulator.display, 0, y, scratch);
+    return (uint16_t)(row[0] << 8 | row[1]);
+}
+
+// The same sprite drawn in low resolution, where it's doubled to two rows of the picture, then after 00FF, where it
+// isn't, and 00FE and 00FF clearing both planes on the way
+static void test_display_modes(void)
+{
+    // V0 = 1, V1 = 3, I = 210, DRW V0, V1, 1, HIGH, DRW V0, V1, 1, LOW, halt, the sprite 10100000
+    static const uint8_t rom[] = {0x60, 0x01, 0x61, 0x03, 0xA2, 0x10, 0xD0, 0x11,
+                                  0x00, 0xFF, 0xD0, 0x11, 0x00, 0xFE, 0x12, 0x0E, 0xA0};
+
+    xochip_init(&emulator);
+    xochip_load_rom(&emulator, rom, sizeof(rom));
+    CHECK(xochip_run(&emulator, 3, NULL) == XOCHIP_SUCCESS);
+    emulator.display.dirty_rows = 0;
+    CHECK(xochip_run(&emulator, 1, NULL) == XOCHIP_SUCCESS && !emulator.display.hires);
+    CHECK(emulator.display.back_plane[3 * XOCHIP_DISPLAY_ROW_BYTES] == 0x50);
+    CHECK(picture_row(5) == 0 && picture_row(6) == 0x3300 && picture_row(7) == 0x3300 && picture_row(8) == 0);
+    CHECK(emulator.display.dirty_rows == 0xC0);
+
+    CHECK(xochip_run(&emulator, 1, NULL) == XOCHIP_SUCCESS && emulator.display.hires);
+    CHECK(picture_row(6) == 0 && picture_row(7) == 0 && emulator.display.dirty_rows == UINT64_MAX);
+    emulator.display.dirty_rows = 0;
+    CHECK(xochip_run(&emulator, 1, NULL) == XOCHIP_SUCCESS);
+    CHECK(picture_row(3) == 0x5000 && picture_row(6) == 0 && emulator.display.dirty_rows == 0x08);
+
+    CHECK(xochip_run(&emulator, 1, NULL) == XOCHIP_SUCCESS && !emulator.display.hires);
+    bool blank = true;
+    for (uint32_t index = 0; index < sizeof(emulator.display.back_plane); ++index)
+    {
+        blank = blank && !emulator.display.back_plane[index] && !emulator.display.fore_plane[index];
+    }
+    CHECK(blank && emulator.display.dirty_rows == UINT64_MAX);
+}
+
+// =====================================================================================================================
+//    CALIBRATOR
+// =====================================================================================================================
+
+// Feeds the calibrator frames that all did the same: ran for what it picked, drew, and waited for the delay timer after
+// busy cycles, or didn't get to when busy is more than the pick. Returns the last pick.
+static uint32_t calibrate_frames(xochip_calibrator_t *calibrator, const uint32_t frames, const uint32_t busy)
+{
+    uint32_t pick = calibrator->cycles_per_tick;
+    for (uint32_t frame = 0; frame < frames; ++frame)
+    {
+        const bool waited = busy < pick;
+        stats.idle = waited ? XOCHIP_IDLE_DELAY : XOCHIP_IDLE_NONE;
+        stats.idle_since = waited ? stats.start + busy : 0;
+        stats.draws = 1;
+        emulator.cycles += pick;
+        pick = xochip_calibrate(calibrator, &emulator, NULL);
+    }
+    return pick;
+}
+
+// A game that needs the same every frame gets a steady pick a little above it, falling behind once doesn't send the
+// pick to the maximum, and once it needs nothing its peak fades away
+static void test_calibrate(void)
+{
+    xochip_calibrator_t calibrator;
+    xochip_init(&emulator);
+    CHECK(xochip_attach_stats(&emulator, &stats) == XOCHIP_SUCCESS);
+    CHECK(xochip_calibrator_init(&calibrator, 8, 100000, 1000) == XOCHIP_SUCCESS);
+
+    // 300 cycles of work wants 300 + 300 / 4 + 2, with up to an eighth to spare before it eases down
+    const uint32_t settled = calibrate_frames(&calibrator, 200, 300);
+    CHECK(settled >= 377 && settled <= 377 + 377 / 7);
+    CHECK(calibrate_frames(&calibrator, 10, 300) == settled);
+
+    // a frame that didn't wait doubles, the next one stops at 4 times the need
+    CHECK(calibrate_frames(&calibrator, 1, UINT32_MAX) == 2 * settled);
+    CHECK(calibrate_frames(&calibrator, 1, UINT32_MAX) == 4 * 377);
+
+    // falling behind at that too, it needs more now
+    CHECK(calibrate_frames(&calibrator, 1, UINT32_MAX) == 8 * 377);
+    const uint32_t recovered = calibrate_frames(&calibrator, 200, 300);
+    CHECK(recovered >= 377 && recovered <= 377 + 377 / 7);
+
+    // frames that wait at once fade the peak to nothing, and the pick down to the minimum
+    CHECK(calibrate_frames(&calibrator, 1000, 0) <= 8 + 8 / 7);
+    CHECK(calibrator.peak == 0);
+    xochip_attach_stats(&emulator, NULL);
+}
+
+// =====================================================================================================================
+//    ENVIRONMENT
+// =====================================================================================================================
+
+// Steps a single instance of rom for one frame and tells how its episode is doing
+static xochip_env_status_t env_status(const uint8_t *rom, const size_t size, const uint32_t cycles_per_frame)
+{
+    xochip_env_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.rom = rom;
+    config.rom_size = size;
+    config.cycles_per_frame = cycles_per_frame;
+    config.action_count = 1;
+
+    const uint8_t action = 0;
+    uint8_t done = XOCHIP_ENV_RUNNING;
+    CHECK(xochip_env_init(&env, &config, &instance, 1) == XOCHIP_SUCCESS);
+    CHECK(xochip_env_step(&env, &action, 1, NULL, &done, NULL) == XOCHIP_SUCCESS);
+    return (xochip_env_status_t)done;
+}
+
+// A jump to itself ends the episode. 1nnn can't reach past 0FFF, so up there a word that happens to read as its own
+// address with a 1 in front is a jump somewhere else, and the game goes on.
+static void test_env_halted(void)
+{
+    static const uint8_t halts[] = {0x12, 0x00};
+    CHECK(env_status(halts, sizeof(halts), 8) == XOCHIP_ENV_TERMINATED);
+
+    // jump to 0FFE, add to V0 into 1000, add to V1 up to 1200, where 1200 jumps back to the start
+    static uint8_t loops[0x1202 - XOCHIP_ADDRESS_SPACE_START];
+    loops[0x000] = 0x1F;
+    loops[0x001] = 0xFE;
+    loops[0xFFE - XOCHIP_ADDRESS_SPACE_START] = 0x70;
+    loops[0xFFF - XOCHIP_ADDRESS_SPACE_START] = 0x01;
+    for (size_t address = 0x1000; address < 0x1200; address += 2)
+    {
+        loops[address - XOCHIP_ADDRESS_SPACE_START] = 0x71;
+        loops[address + 1 - XOCHIP_ADDRESS_SPACE_START] = 0x01;
+    }
+    loops[0x1200 - XOCHIP_ADDRESS_SPACE_START] = 0x12;
+    loops[0x1201 - XOCHIP_ADDRESS_SPACE_START] = 0x00;
+
+    // the frame ends right on the word at 1200
+    CHECK(env_status(loops, sizeof(loops), 2 + 256) == XOCHIP_ENV_RUNNING);
+    CHECK(instance.machine.counter == 0x1200);
+}
+
+// A pixel of the 128x64 picture, the way the core shows it
+static uint8_t picture_pixel(const xochip_display_t *display, const uint8_t plane, const uint32_t x, const uint32_t y)
+{
+    uint8_t scratch[XOCHIP_DISPLAY_ROW_BYTES];
+    const uint8_t *row = xochip_display_row(display, plane, (uint8_t)y, scratch);
+    return (uint8_t)((row[x / 8] >> (7 - x % 8)) & 1);
+}
+
+// A pixel of the downsampled picture: the top left one of its block, or with pooling whether any of the block is set
+static uint8_t observed_pixel(const xochip_display_t *display, const xochip_env_observation_t *layout,
+                              const uint8_t plane, const uint32_t x, const uint32_t y)
+{
+    const uint32_t factor = layout->downsample ? layout->downsample : 1;
+    uint8_t pixel = 0;
+    for (uint32_t dy = 0; dy < (layout->max_pool ? factor : 1); ++dy)
+    {
+        for (uint32_t dx = 0; dx < (layout->max_pool ? factor : 1); ++dx)
+        {
+            pixel |= picture_pixel(display, plane, x * factor + dx, y * factor + dy);
+        }
+    }
+    return pixel;
+}
+
+// Whether out is the display in the layout, pixel by pixel
+static bool observed(const xochip_display_t *display, const xochip_env_observation_t *layout, const uint8_t *out)
+{
+    const uint32_t factor = layout->downsample ? layout->downsample : 1;
+    const uint32_t width = XOCHIP_DISPLAY_WIDTH / factor;
+    const uint32_t pixels = XOCHIP_DISPLAY_PIXELS / (factor * factor);
+
+    for (uint32_t y = 0; y < XOCHIP_DISPLAY_HEIGHT / factor; ++y)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            const uint32_t index = y * width + x;
+            const uint8_t back = observed_pixel(display, layout, 0, x, y);
+            const uint8_t fore = observed_pixel(display, layout, 1, x, y);
+
+            bool same = false;
+            switch (layout->layout)
+            {
+            case XOCHIP_ENV_LAYOUT_PACKED:
+                same = ((out[index / 8] >> (7 - index % 8)) & 1) == back &&
+                       ((out[(pixels + index) / 8] >> (7 - index % 8)) & 1) == fore;
+                break;
+            case XOCHIP_ENV_LAYOUT_PLANES:
+                same = out[index] == back && out[pixels + index] == fore;
+                break;
+            case XOCHIP_ENV_LAYOUT_COLOUR:
+                same = out[index] == (back | fore << 1);
+                break;
+            }
+            if (!same)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Every layout, downsampled or not, pooled or not, of a noisy display in both resolutions
+static void test_env_export(void)
+{
+    xochip_display_t display;
+    memset(&display, 0, sizeof(display));
+    fill_noise(&display, 0x12345678);
+
+    static const uint8_t downsamples[] = {1, 2, 4};
+    for (int hires = 0; hires < 2; ++hires)
+    {
+        display.hires = hires;
+        for (int layout = XOCHIP_ENV_LAYOUT_PACKED; layout <= XOCHIP_ENV_LAYOUT_COLOUR; ++layout)
+        {
+            for (size_t downsample = 0; downsample < sizeof(downsamples); ++downsample)
+            {
+                for (int max_pool = 0; max_pool < 2; ++max_pool)
+                {
+                    const xochip_env_observation_t description = {(xochip_env_layout_t)layout, downsamples[downsample],
+                                                                  max_pool, 1};
+                    CHECK(xochip_env_observation_size(&description) <= sizeof(observation));
+                    CHECK(xochip_env_export(&display, &description, observation) == XOCHIP_SUCCESS);
+                    CHECK(observed(&display, &description, observation));
+                }
+            }
+        }
+    }
+}
+
+// A stack of 2 is the frame before and the frame now, and the first step's is the one the next step starts from
+static void test_env_stack(void)
+{
+    // Dxyn with I on the font's 0, so every frame of one instruction flips the sprite
+    static const uint8_t rom[] = {0xD0, 0x15, 0xD0, 0x15, 0xD0, 0x15};
+
+    xochip_env_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.rom = rom;
+    config.rom_size = sizeof(rom);
+    config.cycles_per_frame = 1;
+    config.action_count = 1;
+    config.observation.stack = 2;
+    CHECK(xochip_env_init(&env, &config, &instance, 1) == XOCHIP_SUCCESS);
+    CHECK(env.observation_size == sizeof(stacked[0]));
+
+    const uint8_t action = 0;
+    const xochip_env_observation_t frame = {XOCHIP_ENV_LAYOUT_PACKED, 1, false, 1};
+    xochip_display_t blank;
+    memset(&blank, 0, sizeof(blank));
+    blank.hires = true;
+
+    CHECK(xochip_env_step(&env, &action, 1, NULL, NULL, stacked[0]) == XOCHIP_SUCCESS);
+    CHECK(observed(&blank, &frame, stacked[0]));
+    CHECK(observed(&instance.machine.display, &frame, stacked[0] + XOCHIP_ENV_FRAME_SIZE));
+    CHECK(!observed(&blank, &frame, stacked[0] + XOCHIP_ENV_FRAME_SIZE));
+
+    CHECK(xochip_env_step(&env, &action, 1, NULL, NULL, stacked[1]) == XOCHIP_SUCCESS);
+    CHECK(memcmp(stacked[1], stacked[0] + XOCHIP_ENV_FRAME_SIZE, XOCHIP_ENV_FRAME_SIZE) == 0);
+    CHECK(observed(&blank, &frame, stacked[1] + XOCHIP_ENV_FRAME_SIZE));
+}
+
+// =====================================================================================================================
+//    TERMINAL
+// =====================================================================================================================
+
+// What a terminal shows after the escape sequences the renderer sends: a glyph and its colours per cell
+typedef struct screen
+{
+    uint8_t glyphs[XOCHIP_TERMINAL_ROWS][XOCHIP_TERMINAL_COLUMNS_MAX]; // the index in xochip_terminal_glyphs
+    uint8_t foregrounds[XOCHIP_TERMINAL_ROWS][XOCHIP_TERMINAL_COLUMNS_MAX];
+    uint8_t backgrounds[XOCHIP_TERMINAL_ROWS][XOCHIP_TERMINAL_COLUMNS_MAX];
+    uint32_t row;
+    uint32_t column;
+    uint8_t foreground; // the SGR code last set, 0 after a reset
+    uint8_t background;
+    bool broken;        // something was sent that isn't on the screen, or went off it
+} screen_t;
+
+static screen_t incremental;
+static screen_t full;
+
+// Plays the bytes on the screen, the sequences the renderer uses and nothing else
+static bool screen_write(void *context, const uint8_t *data, const size_t size)
+{
+    screen_t *screen = context;
+    size_t index = 0;
+    while (index < size)
+    {
+        if (data[index] == 0x1B)
+        {
+            // CSI, an optional ?, numbers separated by ; and the final byte
+            uint32_t numbers[8] = {0};
+            uint32_t count = 0;
+            index += 2;
+            index += index < size && data[index] == '?' ? 1 : 0;
+            while (index < size && ((data[index] >= '0' && data[index] <= '9') || data[index] == ';'))
+            {
+                if (data[index] == ';')
+                {
+                    count = count + 1 < 8 ? count + 1 : count;
+                }
+                else
+                {
+                    numbers[count] = numbers[count] * 10 + (uint32_t)(data[index] - '0');
+                }
+                index++;
+            }
+            const uint8_t final = index < size ? data[index++] : 0;
+
+            if (final == 'H')
+            {
+                screen->row = numbers[0] - 1;
+                screen->column = numbers[1] - 1;
+            }
+            else if (final == 'C')
+            {
+                screen->column += numbers[0];
+            }
+            else if (final == 'J')
+            {
+                memset(screen->glyphs, 0xFF, sizeof(screen->glyphs));
+            }
+            else if (final == 'm')
+            {
+                for (uint32_t number = 0; number <= count; ++number)
+                {
+                    const uint32_t code = numbers[number];
+                    screen->foreground = code == 0 ? 0 : (code / 10 == 3 || code / 10 == 9) ? (uint8_t)code
+                                                                                               : screen->foreground;
+                    screen->background = code == 0 ? 0 : (code / 10 == 4 || code / 10 == 10) ? (uint8_t)code
+                                                                                                : screen->background;
+                }
+            }
+            continue;
+        }
+
+        uint8_t glyph = 0xFF;
+        for (uint8_t candidate = 0; candidate < 16 && glyph == 0xFF; ++candidate)
+        {
+            const size_t length = strlen(xochip_terminal_glyphs[candidate]);
+            glyph = size - index >= length && memcmp(data + index, xochip_terminal_glyphs[candidate], length) == 0
+                        ? candidate
+                        : 0xFF;
+        }
+        if (glyph == 0xFF || screen->row >= XOCHIP_TERMINAL_ROWS || screen->column >= XOCHIP_TERMINAL_COLUMNS_MAX)
+        {
+            screen->broken = true;
+            return true;
+        }
+
+        screen->glyphs[screen->row][screen->column] = glyph;
+        screen->foregrounds[screen->row][screen->column] = glyph ? screen->foreground : 0;
+        screen->backgrounds[screen->row][screen->column] = screen->background;
+        screen->column++;
+        index += strlen(xochip_terminal_glyphs[glyph]);
+    }
+    return true;
+}
+
+// Whether both screens show the same, a blank cell showing only its background
+static bool same_screen(const screen_t *a, const screen_t *b)
+{
+    return !a->broken && !b->broken && memcmp(a->glyphs, b->glyphs, sizeof(a->glyphs)) == 0 &&
+           memcmp(a->foregrounds, b->foregrounds, sizeof(a->foregrounds)) == 0 &&
+           memcmp(a->backgrounds, b->backgrounds, sizeof(a->backgrounds)) == 0;
+}
+
+// Draws a run of displays that change a little, a lot and between resolutions, and after every one the terminal that
+// only got the differences has to show what a new renderer draws from scratch
+static void test_terminal(void)
+{
+    static const uint32_t palette[4] = {0x000000, 0xFFFFFF, 0xAA0000, 0x5555FF};
+    xochip_display_t display;
+
+    for (int mode = XOCHIP_TERMINAL_HALF_BLOCKS; mode < XOCHIP_TERMINAL_MODE_COUNT; ++mode)
+    {
+        memset(&incremental, 0, sizeof(incremental));
+        memset(&display, 0, sizeof(display));
+        CHECK(xochip_terminal_init(&drawn, (xochip_terminal_mode_t)mode, XOCHIP_TERMINAL_ANSI16, palette,
+                                   screen_write, &incremental) == XOCHIP_SUCCESS);
+
+        for (uint32_t frame = 0; frame < 8; ++frame)
+        {
+            // noise, a few pixels flipped, lores noise, back to hires, and a blank display
+            if (frame % 4 == 0)
+            {
+                fill_noise(&display, 0x9E3779B9u * (frame + 1));
+            }
+            else if (frame % 4 == 1)
+            {
+                display.back_plane[frame * 37] ^= 0x81;
+                display.fore_plane[1000 + frame] ^= 0x18;
+            }
+            display.hires = frame % 4 != 2;
+            if (frame == 7)
+            {
+                memset(display.back_plane, 0, sizeof(display.back_plane));
+                memset(display.fore_plane, 0, sizeof(display.fore_plane));
+            }
+
+            CHECK(xochip_terminal_draw(&drawn, &display) == XOCHIP_SUCCESS);
+            memset(&full, 0, sizeof(full));
+            CHECK(xochip_terminal_init(&redrawn, (xochip_terminal_mode_t)mode, XOCHIP_TERMINAL_ANSI16, palette,
+                                       screen_write, &full) == XOCHIP_SUCCESS);
+            CHECK(xochip_terminal_draw(&redrawn, &display) == XOCHIP_SUCCESS);
+            CHECK(same_screen(&incremental, &full));
+
+            // nothing changed, nothing is sent
+            const uint64_t written = drawn.written;
+            CHECK(xochip_terminal_draw(&drawn, &display) == XOCHIP_SUCCESS);
+            CHECK(drawn.written == written);
+        }
+    }
+}
+
+int main(void)
+{
+    test_debugger();
+    test_load_reader();
+    test_cfg();
+    test_run_budget();
+    test_costs();
+    test_dirty_pages();
+#ifdef XOCHIP_XIP
+    test_out_of_pages();
+#endif
+    test_display_modes();
+    test_calibrate();
+    test_env_halted();
+    test_env_export();
+    test_env_stack();
+    test_terminal();
+
+    if (failures)
+    {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,589 @@
+//
+// Headless test runner. Runs a ROM for a fixed number of frames with scripted input, then prints an FNV-1a hash of the
+// display planes, or compares it with an expected one. CMake registers one test per line of tests/goldens.txt, and
+// runs each one again with xochip-test-runner-xip, the same runner built with XOCHIP_XIP.
+//
+//     xochip-test-runner [--frames <n>] [--ipf <n>] [--keys <script>] [--expect <hash>] [--dump] [--record <file>]
+//                        [--memo <entries>] [--attach <list>] [--check] <rom>
+//
+// The key script is a comma separated list of <frame>+<key> (press) and <frame>-<key> (release), keys in hex, e.g.
+// "30+3,32-3" presses key 3 at frame 30 and lets go 2 frames later. --dump prints the display, to check by eye what a
+// new golden hash stands for. --record saves every frame with xochip_record.h, for xochip-replay to export. --memo
+// keeps that many frames by the state they started from and replays them instead of running them again, which is what
+// long runs of title screens and idle loops spend their time on. It doesn't change the result.
+//
+// --attach takes a comma separated list of attachments to run with: decode (the decode cache, and with it the fused
+// handlers), sprite (the sprite cache) and hash (the incremental state hash, which --check compares with the reference
+// machine's, hashed whole). --check runs a second machine alongside, without attachments, one xochip_cycle at a time,
+// and fails on the first frame the two end in different states. It also keeps a framebuffer converted with
+// xochip_pixels.h from the dirty rows alone, which has to match converting the whole display, and records every frame
+// with short keyframe intervals, which played back and seeked into at the end has to show the same pictures. Every
+// frame is run twice, the second time from a snapshot of where it started, and at the end the machine is reset, which
+// only touches the pages it wrote, and has to match a new one. CMake runs every golden that way with the attachments
+// on.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define XOCHIP_IMPLEMENTATION
+#include "xochip.h"
+#include "xochip_file.h"
+#include "xochip_pixels.h"
+#include "xochip_record.h"
+
+// Too big for the stack
+static xochip_t emulator;
+static xochip_recorder_t recorder;
+static xochip_hash_t hash;
+static xochip_memo_t memo;
+static xochip_decode_cache_t decode_cache;
+static xochip_sprite_cache_t sprite_cache;
+static xochip_t reference;
+static xochip_state_t snapshot;
+static xochip_pixels_t pixels;
+static uint8_t framebuffer[XOCHIP_DISPLAY_HEIGHT][XOCHIP_DISPLAY_WIDTH * 4];
+static uint8_t full_framebuffer[XOCHIP_DISPLAY_HEIGHT][XOCHIP_DISPLAY_WIDTH * 4];
+
+// What --check records, to play back at the end
+#define RUNNER_CHECK_KEYFRAME_INTERVAL 50
+static xochip_recorder_t check_recorder;
+static uint8_t *recording;
+static size_t recording_size;
+static size_t recording_capacity;
+static uint64_t *frame_hashes;
+static uint32_t recorded_frames;
+
+typedef struct runner_options
+{
+    uint32_t frames;
+    uint32_t cycles_per_frame;
+    const char *keys;
+    const char *expect;
+    bool dump;
+    const char *record;
+    uint32_t memo_entries;
+    bool decode_cache;
+    bool sprite_cache;
+    bool state_hash;
+    bool check;
+    const char *rom;
+} runner_options_t;
+
+// 64-bit FNV-1a, over the back plane then the fore plane of the 128x64 picture, so either resolution hashes the same
+// way it's shown
+static uint64_t hash_display(const xochip_display_t *display)
+{
+    uint64_t hash = 0xCBF29CE484222325ULL;
+
+    for (uint8_t plane = 0; plane < 2; ++plane)
+    {
+        for (uint8_t y = 0; y < XOCHIP_DISPLAY_HEIGHT; ++y)
+        {
+            uint8_t scratch[XOCHIP_DISPLAY_ROW_BYTES];
+            const uint8_t *row = xochip_display_row(display, plane, y, scratch);
+            for (size_t index = 0; index < XOCHIP_DISPLAY_ROW_BYTES; ++index)
+            {
+                hash ^= row[index];
+                hash *= 0x100000001B3ULL;
+            }
+        }
+    }
+
+    return hash;
+}
+
+// Applies every key event of the script that's due at frame to machine. Returns false when the script is malformed.
+static bool apply_keys(xochip_t *machine, const char *script, const uint32_t frame)
+{
+    const char *cursor = script;
+
+    while (cursor && *cursor)
+    {
+        char *end = NULL;
+        const unsigned long at = strtoul(cursor, &end, 10);
+        if (end == cursor || (*end != '+' && *end != '-') || !end[1])
+        {
+            return false;
+        }
+
+        const bool press = *end == '+';
+        char *key_end = NULL;
+        const unsigned long key = strtoul(end + 1, &key_end, 16);
+        if (key_end == end + 1 || key >= XOCHIP_KEYCOUNT || (*key_end != ',' && *key_end != '\0'))
+        {
+            return false;
+        }
+
+        if (at == frame)
+        {
+            if (press)
+            {
+                xochip_key_down(machine, (xochip_keys_t)key);
+            }
+            else
+            {
+                xochip_key_up(machine, (xochip_keys_t)key);
+            }
+        }
+
+        cursor = *key_end == ',' ? key_end + 1 : key_end;
+    }
+
+    return true;
+}
+
+static void dump_display(const xochip_display_t *display)
+{
+    // one character per pixel, the colour index picks it
+    static const char shades[4] = {'.', '#', 'o', '@'};
+
+    for (uint8_t y = 0; y < XOCHIP_DISPLAY_HEIGHT; ++y)
+    {
+        uint8_t scratch[2][XOCHIP_DISPLAY_ROW_BYTES];
+        const uint8_t *back = xochip_display_row(display, 0, y, scratch[0]);
+        const uint8_t *fore = xochip_display_row(display, 1, y, scratch[1]);
+        for (uint32_t x = 0; x < XOCHIP_DISPLAY_WIDTH; ++x)
+        {
+            const uint8_t bit = (uint8_t)(0x80 >> (x % 8));
+            const uint8_t colour = (uint8_t)(((fore[x / 8] & bit) ? 2 : 0) | ((back[x / 8] & bit) ? 1 : 0));
+            putchar(shades[colour]);
+        }
+        putchar('\n');
+    }
+}
+
+static bool write_file(void *context, const uint8_t *data, const size_t size)
+{
+    return fwrite(data, 1, size, context) == size;
+}
+
+static bool write_memory(void *context, const uint8_t *data, const size_t size)
+{
+    (void)context;
+    if (recording_size + size > recording_capacity)
+    {
+        const size_t capacity = 2 * (recording_size + size);
+        uint8_t *grown = realloc(recording, capacity);
+        if (!grown)
+        {
+            return false;
+        }
+        recording = grown;
+        recording_capacity = capacity;
+    }
+
+    memcpy(recording + recording_size, data, size);
+    recording_size += size;
+    return true;
+}
+
+// Plays back what --check recorded, every frame in order and then a few seeks back across keyframes
+static bool check_recording(void)
+{
+    xochip_replay_t replay;
+    if (xochip_record_flush(&check_recorder) != XOCHIP_SUCCESS ||
+        xochip_replay_open(&replay, recording, recording_size) != XOCHIP_SUCCESS ||
+        replay.frame_count != recorded_frames)
+    {
+        return false;
+    }
+
+    for (uint32_t frame = 0; frame < recorded_frames; ++frame)
+    {
+        if (xochip_replay_seek(&replay, frame) != XOCHIP_SUCCESS ||
+            hash_display(&replay.display) != frame_hashes[frame])
+        {
+            return false;
+        }
+    }
+
+    const uint32_t seeks[] = {0, recorded_frames / 2, recorded_frames - 1, RUNNER_CHECK_KEYFRAME_INTERVAL + 1};
+    for (size_t index = 0; index < sizeof(seeks) / sizeof(seeks[0]); ++index)
+    {
+        const uint32_t frame = seeks[index];
+        if (frame < recorded_frames && (xochip_replay_seek(&replay, frame) != XOCHIP_SUCCESS ||
+                                        hash_display(&replay.display) != frame_hashes[frame]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool parse_number(const char *text, uint32_t *number)
+{
+    char *end = NULL;
+    const unsigned long value = strtoul(text, &end, 10);
+    if (end == text || *end != '\0' || value == 0)
+    {
+        return false;
+    }
+
+    *number = (uint32_t)value;
+    return true;
+}
+
+// Sets the attachments named in a comma separated list. Returns false on a name it doesn't know.
+static bool parse_attachments(const char *list, runner_options_t *options)
+{
+    while (*list)
+    {
+        const size_t length = strcspn(list, ",");
+        if (length == strlen("decode") && strncmp(list, "decode", length) == 0)
+        {
+            options->decode_cache = true;
+        }
+        else if (length == strlen("sprite") && strncmp(list, "sprite", length) == 0)
+        {
+            options->sprite_cache = true;
+        }
+        else if (length == strlen("hash") && strncmp(list, "hash", length) == 0)
+        {
+            options->state_hash = true;
+        }
+        else
+        {
+            return false;
+        }
+
+        list += length;
+        list += *list == ',' ? 1 : 0;
+    }
+
+    return true;
+}
+
+// A frame is over when the timers tick, whether or not the display changed
+static xochip_result_t run_frame(xochip_scheduler_t *scheduler)
+{
+    const uint64_t ticks = scheduler->ticks;
+    xochip_result_t result = XOCHIP_SUCCESS;
+    while (result == XOCHIP_SUCCESS && scheduler->ticks == ticks)
+    {
+        result =
+            xochip_run_budget(&emulator, scheduler, scheduler->cycles_per_tick - scheduler->tick_phase, NULL, NULL);
+    }
+    return result;
+}
+
+// Runs the frame again from the snapshot taken before it, restoring only the pages either run wrote, and tells whether
+// it ended the same way
+static bool check_rerun(const xochip_scheduler_t *before, const xochip_scheduler_t *after, const xochip_result_t result)
+{
+    const uint64_t state = xochip_state_hash(&emulator);
+    const uint64_t dirty_rows = emulator.display.dirty_rows;
+
+    xochip_scheduler_t scheduler = *before;
+    xochip_load_state(&emulator, &snapshot);
+    const bool same = run_frame(&scheduler) == result && xochip_state_hash(&emulator) == state &&
+                      scheduler.ticks == after->ticks && scheduler.tick_phase == after->tick_phase;
+
+    // the restore flagged the whole display, what the first run flagged is what the dirty row check is after
+    emulator.display.dirty_rows = dirty_rows;
+    return same;
+}
+
+// Resets the machine and loads the ROM again, which has to leave it the same as a machine that never ran
+static bool check_reset(const xochip_rom_file_t *rom)
+{
+    xochip_reset(&emulator);
+    xochip_load_rom(&emulator, rom->data, rom->size);
+    xochip_init(&reference);
+    xochip_load_rom(&reference, rom->data, rom->size);
+    return xochip_state_hash(&emulator) == xochip_state_hash(&reference);
+}
+
+// Runs a frame of the reference machine the plainest way there is, one xochip_cycle at a time
+static xochip_result_t run_reference(const uint32_t cycles_per_frame)
+{
+    xochip_result_t result = XOCHIP_SUCCESS;
+    for (uint32_t cycle = 0; cycle < cycles_per_frame && result == XOCHIP_SUCCESS; ++cycle)
+    {
+        result = xochip_cycle(&reference);
+    }
+
+    if (result == XOCHIP_SUCCESS)
+    {
+        xochip_tick(&reference);
+    }
+    return result;
+}
+
+// Converts only the rows flagged dirty since the last call, and tells whether that left the same picture as converting
+// every row
+static bool check_dirty_rows(xochip_display_t *display)
+{
+    xochip_pixels_convert(&pixels, display, display->dirty_rows, framebuffer, sizeof(framebuffer[0]));
+    display->dirty_rows = 0;
+    xochip_pixels_convert(&pixels, display, UINT64_MAX, full_framebuffer, sizeof(full_framebuffer[0]));
+    return memcmp(framebuffer, full_framebuffer, sizeof(framebuffer)) == 0;
+}
+
+static bool parse_options(const int argc, char **argv, runner_options_t *options)
+{
+    for (int arg = 1; arg < argc; ++arg)
+    {
+        const bool has_value = arg + 1 < argc;
+
+        if (strcmp(argv[arg], "--frames") == 0 && has_value)
+        {
+            if (!parse_number(argv[++arg], &options->frames))
+            {
+                return false;
+            }
+        }
+        else if (strcmp(argv[arg], "--ipf") == 0 && has_value)
+        {
+            if (!parse_number(argv[++arg], &options->cycles_per_frame))
+            {
+                return false;
+            }
+        }
+        else if (strcmp(argv[arg], "--keys") == 0 && has_value)
+        {
+            options->keys = argv[++arg];
+        }
+        else if (strcmp(argv[arg], "--expect") == 0 && has_value)
+        {
+            options->expect = argv[++arg];
+        }
+        else if (strcmp(argv[arg], "--record") == 0 && has_value)
+        {
+            options->record = argv[++arg];
+        }
+        else if (strcmp(argv[arg], "--memo") == 0 && has_value)
+        {
+            if (!parse_number(argv[++arg], &options->memo_entries))
+            {
+                return false;
+            }
+        }
+        else if (strcmp(argv[arg], "--attach") == 0 && has_value)
+        {
+            if (!parse_attachments(argv[++arg], options))
+            {
+                return false;
+            }
+        }
+        else if (strcmp(argv[arg], "--dump") == 0)
+        {
+            options->dump = true;
+        }
+        else if (strcmp(argv[arg], "--check") == 0)
+        {
+            options->check = true;
+        }
+        else if (argv[arg][0] != '-' && !options->rom)
+        {
+            options->rom = argv[arg];
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return options->rom != NULL;
+}
+
+int main(int argc, char **argv)
+{
+    runner_options_t options = {120, 1000, NULL, NULL, false, NULL, 0, false, false, false, false, NULL};
+
+    if (!parse_options(argc, argv, &options))
+    {
+        fprintf(stderr,
+                "usage: %s [--frames <n>] [--ipf <n>] [--keys <script>] [--expect <hash>] [--dump] [--record <file>] "
+                "[--memo <entries>] [--attach <list>] [--check] <rom>\n",
+                argv[0]);
+        return 2;
+    }
+
+    // the mapping stays for the whole run, a XOCHIP_XIP build reads the ROM from it
+    xochip_rom_file_t rom;
+    xochip_init(&emulator);
+    xochip_result_t load_result = xochip_map_rom_file(options.rom, &rom);
+    if (load_result == XOCHIP_SUCCESS)
+    {
+        load_result = xochip_load_rom(&emulator, rom.data, rom.size);
+    }
+    if (load_result == XOCHIP_SUCCESS && options.check)
+    {
+        // a colour per index, so a stale row shows whichever plane it missed
+        static const uint32_t palette[4] = {0x000000, 0xFF0000, 0x00FF00, 0x0000FF};
+        xochip_pixels_init(&pixels, XOCHIP_PIXELS_RGBA8888, palette, 1);
+        xochip_record_start(&check_recorder, write_memory, NULL, RUNNER_CHECK_KEYFRAME_INTERVAL);
+        frame_hashes = malloc(options.frames * sizeof(uint64_t));
+        if (!frame_hashes)
+        {
+            fprintf(stderr, "Not enough memory to check %u frames\n", (unsigned)options.frames);
+            return 2;
+        }
+        xochip_init(&reference);
+        load_result = xochip_load_rom(&reference, rom.data, rom.size);
+    }
+    if (load_result != XOCHIP_SUCCESS)
+    {
+        fprintf(stderr, "Failed to load ROM %s: %s\n", options.rom, xochip_strerror(load_result));
+        return 2;
+    }
+
+    if (options.decode_cache)
+    {
+        xochip_attach_decode_cache(&emulator, &decode_cache);
+    }
+    if (options.sprite_cache)
+    {
+        xochip_attach_sprite_cache(&emulator, &sprite_cache);
+    }
+    if (options.state_hash)
+    {
+        xochip_attach_hash(&emulator, &hash);
+    }
+
+    FILE *record = NULL;
+    if (options.record)
+    {
+        record = fopen(options.record, "wb");
+        if (!record)
+        {
+            fprintf(stderr, "Failed to create %s\n", options.record);
+            return 2;
+        }
+        xochip_record_start(&recorder, write_file, record, XOCHIP_RECORD_KEYFRAME_INTERVAL);
+    }
+
+    xochip_memo_entry_t *entries = NULL;
+    if (options.memo_entries)
+    {
+        entries = malloc(options.memo_entries * sizeof(xochip_memo_entry_t));
+        if (!entries)
+        {
+            fprintf(stderr, "Not enough memory for %u memo entries\n", (unsigned)options.memo_entries);
+            return 2;
+        }
+        xochip_memo_init(&memo, entries, options.memo_entries);
+        xochip_attach_hash(&emulator, &hash);
+    }
+
+    xochip_scheduler_t scheduler;
+    xochip_scheduler_init(&scheduler, options.cycles_per_frame, 0);
+
+    xochip_result_t result = XOCHIP_SUCCESS;
+    for (uint32_t frame = 0; frame < options.frames && result == XOCHIP_SUCCESS; ++frame)
+    {
+        if (!apply_keys(&emulator, options.keys, frame) ||
+            (options.check && !apply_keys(&reference, options.keys, frame)))
+        {
+            fprintf(stderr, "Malformed key script: %s\n", options.keys);
+            return 2;
+        }
+
+        const xochip_scheduler_t before = scheduler;
+        if (options.check)
+        {
+            xochip_save_state(&emulator, &snapshot);
+        }
+
+        if (!entries || !xochip_memo_replay(&memo, &emulator, &scheduler))
+        {
+            result = run_frame(&scheduler);
+            xochip_memo_record(&memo, &emulator, &scheduler, result);
+        }
+
+        if (options.check)
+        {
+            if (!check_rerun(&before, &scheduler, result))
+            {
+                fprintf(stderr, "%s: frame %u ends differently when run again from a snapshot\n", options.rom,
+                        (unsigned)frame);
+                return 1;
+            }
+
+            const xochip_result_t expected = run_reference(options.cycles_per_frame);
+            if (result != expected || xochip_state_hash(&emulator) != xochip_state_hash(&reference))
+            {
+                fprintf(stderr, "%s: frame %u ends in a different state than with xochip_cycle (%04X: %s, %04X: %s)\n",
+                        options.rom, (unsigned)frame, emulator.counter, xochip_strerror(result), reference.counter,
+                        xochip_strerror(expected));
+                return 1;
+            }
+
+            if (!check_dirty_rows(&emulator.display))
+            {
+                fprintf(stderr, "%s: frame %u changed rows that aren't flagged dirty\n", options.rom, (unsigned)frame);
+                return 1;
+            }
+
+            if (xochip_record_frame(&check_recorder, &emulator.display) != XOCHIP_SUCCESS)
+            {
+                fprintf(stderr, "Not enough memory to record %s\n", options.rom);
+                return 2;
+            }
+            frame_hashes[recorded_frames++] = hash_display(&emulator.display);
+        }
+
+        if (record && xochip_record_frame(&recorder, &emulator.display) != XOCHIP_SUCCESS)
+        {
+            fprintf(stderr, "Failed to write %s\n", options.record);
+            return 1;
+        }
+    }
+
+    if (record && (xochip_record_flush(&recorder) != XOCHIP_SUCCESS || fclose(record) != 0))
+    {
+        fprintf(stderr, "Failed to write %s\n", options.record);
+        return 1;
+    }
+
+    if (options.check)
+    {
+        const bool played_back = check_recording();
+        free(recording);
+        free(frame_hashes);
+        if (!played_back)
+        {
+            fprintf(stderr, "%s: the recording doesn't play back the frames that were recorded\n", options.rom);
+            return 1;
+        }
+    }
+
+    if (entries)
+    {
+        fprintf(stderr, "%llu of %u frames replayed\n", (unsigned long long)memo.hits, (unsigned)options.frames);
+        free(entries);
+    }
+
+    // a ROM that exits is done, anything else is a failure
+    if (result != XOCHIP_SUCCESS && result != XOCHIP_EXITED)
+    {
+        fprintf(stderr, "%s stopped at %04X: %s\n", options.rom, emulator.counter, xochip_strerror(result));
+        return 1;
+    }
+
+    if (options.dump)
+    {
+        dump_display(&emulator.display);
+    }
+
+    char hash[17];
+    snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)hash_display(&emulator.display));
+    printf("%s\n", hash);
+
+    if (options.expect && strcmp(options.expect, hash) != 0)
+    {
+        fprintf(stderr, "%s: expected %s, got %s\n", options.rom, options.expect, hash);
+        return 1;
+    }
+
+    if (options.check && !check_reset(&rom))
+    {
+        fprintf(stderr, "%s: a reset leaves the machine different from a new one\n", options.rom);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,175 @@
+//
+// Checks xochip.hpp against the C API. Runs every ROM given for a number of frames through the C API and through
+// machines of every profile, with and without hooks, and fails when a machine ends up in a different state.
+//
+//     xochip-test-wrapper [--frames <n>] <rom>...
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "xochip.hpp"
+
+namespace
+{
+
+// Counts what it sees, and switches the machine to stepping one instruction at a time
+struct CountingHooks
+{
+    std::uint64_t instructions = 0;
+    std::uint64_t frames = 0;
+
+    void on_instruction(const xochip_t &)
+    {
+        ++instructions;
+    }
+
+    void on_frame(const xochip_t &, bool)
+    {
+        ++frames;
+    }
+};
+
+std::vector<std::uint8_t> read_rom(const char *path)
+{
+    std::vector<std::uint8_t> rom;
+    FILE *file = std::fopen(path, "rb");
+    if (!file)
+    {
+        return rom;
+    }
+
+    std::uint8_t buffer[4096];
+    std::size_t count = 0;
+    while ((count = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        rom.insert(rom.end(), buffer, buffer + count);
+    }
+    std::fclose(file);
+    return rom;
+}
+
+// The state the C API leaves the machine in, paced the way a machine with these quirks paces it
+template <typename Quirks>
+std::uint64_t run_c(const std::vector<std::uint8_t> &rom, const std::uint32_t frames)
+{
+    static xochip_t emulator;
+    xochip_init(&emulator);
+    const xochip_cost_table_t *costs = xochip_cost_preset(Quirks::preset);
+    xochip_set_costs(&emulator, Quirks::costed ? costs : nullptr);
+    xochip_scheduler_t scheduler;
+    xochip_scheduler_init(&scheduler, costs->cycles_per_tick, 0);
+    if (xochip_load_rom(&emulator, rom.data(), rom.size()) != XOCHIP_SUCCESS)
+    {
+        return 0;
+    }
+
+    for (std::uint32_t frame = 0; frame < frames; ++frame)
+    {
+        const std::uint64_t ticks = scheduler.ticks;
+        while (scheduler.ticks == ticks)
+        {
+            const std::uint32_t budget = scheduler.cycles_per_tick - scheduler.tick_phase;
+            if (xochip_run_budget(&emulator, &scheduler, budget, nullptr, nullptr) != XOCHIP_SUCCESS)
+            {
+                return xochip_state_hash(&emulator);
+            }
+        }
+    }
+    return xochip_state_hash(&emulator);
+}
+
+template <typename Machine>
+std::uint64_t run_machine(Machine &machine, const std::vector<std::uint8_t> &rom, const std::uint32_t frames)
+{
+    if (machine.load(rom) != XOCHIP_SUCCESS)
+    {
+        return 0;
+    }
+
+    for (std::uint32_t frame = 0; frame < frames; ++frame)
+    {
+        if (machine.run_frame() != XOCHIP_SUCCESS)
+        {
+            break;
+        }
+    }
+    return machine.state_hash();
+}
+
+bool check(const char *rom_path, const char *what, const std::uint64_t expected, const std::uint64_t actual)
+{
+    if (expected == actual)
+    {
+        return true;
+    }
+
+    std::fprintf(stderr, "%s: %s ended in state %016llx instead of %016llx\n", rom_path, what,
+                 static_cast<unsigned long long>(actual), static_cast<unsigned long long>(expected));
+    return false;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::uint32_t frames = 120;
+    int first = 1;
+    if (argc > 2 && std::strcmp(argv[1], "--frames") == 0)
+    {
+        frames = static_cast<std::uint32_t>(std::strtoul(argv[2], nullptr, 10));
+        first = 3;
+    }
+
+    if (first >= argc)
+    {
+        std::fprintf(stderr, "usage: %s [--frames <n>] <rom>...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    bool ok = true;
+    for (int arg = first; arg < argc; ++arg)
+    {
+        const char *path = argv[arg];
+        const std::vector<std::uint8_t> rom = read_rom(path);
+        if (rom.empty())
+        {
+            std::fprintf(stderr, "%s: can't read the ROM\n", path);
+            ok = false;
+            continue;
+        }
+
+        const std::uint64_t expected = run_c<xo::quirks::XoChip>(rom, frames);
+
+        xo::Machine<xo::profile::Minimal> minimal;
+        ok = check(path, "profile::Minimal", expected, run_machine(minimal, rom, frames)) && ok;
+
+        xo::Machine<xo::profile::Fast> fast;
+        ok = check(path, "profile::Fast", expected, run_machine(fast, rom, frames)) && ok;
+
+        // moved machines keep their attachments
+        xo::Machine<xo::profile::Tooling, xo::quirks::XoChip, CountingHooks> tooling;
+        xo::Machine<xo::profile::Tooling, xo::quirks::XoChip, CountingHooks> moved(std::move(tooling));
+        ok = check(path, "profile::Tooling with hooks", expected, run_machine(moved, rom, frames)) && ok;
+        if (moved.hooks().instructions != moved.get()->cycles || moved.hooks().frames > frames)
+        {
+            std::fprintf(stderr, "%s: the hooks saw %llu instructions over %llu frames, %llu cycles ran\n", path,
+                         static_cast<unsigned long long>(moved.hooks().instructions),
+                         static_cast<unsigned long long>(moved.hooks().frames),
+                         static_cast<unsigned long long>(moved.get()->cycles));
+            ok = false;
+        }
+
+        const std::uint64_t expected_vip = run_c<xo::quirks::Vip>(rom, frames);
+        xo::Machine<xo::profile::Fast, xo::quirks::Vip> vip;
+        ok = check(path, "quirks::Vip", expected_vip, run_machine(vip, rom, frames)) && ok;
+
+        // stepping has to pace by the cost table the same way
+        xo::Machine<xo::profile::Minimal, xo::quirks::Vip, CountingHooks> vip_hooks;
+        ok = check(path, "quirks::Vip with hooks", expected_vip, run_machine(vip_hooks, rom, frames)) && ok;
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,3 @@
+// The implementation for xochip-test-wrapper, which is C++ and can't compile it
+#define XOCHIP_IMPLEMENTATION
+#include "xochip.h"
@@ -57,6 +57,7 @@
 // PLANE        // Fn01 - Select drawing planes n (n = 1, 2, or 3)
 // AUDIO        // F002 - Store 16 bytes starting at I in the audio pattern buffer
 // LD_PITCH_VX  // Fx3A - Set audio pitch = Vx
+// SCU_N        // 00Dn - Scroll display up n pixels
 
 // Additional XO-CHIP opcodes for completeness
 // XOCHIP_OP_INVALID // For invalid/unknown opcodes
@@ -65,35 +66,87 @@
 #define XOCHIP_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <string.h>
 
-// TODO figure out what to do when we don't have stdlib.h. The only reason they're here is for random
-// numbers. Replace this with a better solution
-#include <stdlib.h>
+// The implementation is C, C++ hosts include this for the declarations, see xochip.hpp
+#ifdef __cplusplus
+extern "C"
+{
+#endif
 
 // =====================================================================================================================
 //    DEFINES
 // =====================================================================================================================
 
-// XO-CHIP address space is 64kb vs the original CHIP-8's 4kb. However, like the original CHIP-8, the first 512 bytes is
-// traditionally reserved for the interpreter. We don't need that, and since this is meant for resource constrained
-// systems, we don't want to waste those bytes. 0xFE00 is 0x10000 - 0x200, or 64kb without the 512 wasted bytes.
+// XO-CHIP address space is 64kb vs the original CHIP-8's 4kb. Like the original CHIP-8, the first 512 bytes are
+// traditionally reserved for the interpreter, so memory[] is indexed by the same addresses the ROM uses.
 #define XOCHIP_ADDRESS_SPACE_SIZE 0x10000
 
-// Where the address space would traditionally start. This value is applied to address operations as needed, to account
-// for the "missing" 512 bytes.
+// Every access to memory[] goes through this mask, so no address can reach past the end and nothing needs a bounds
+// check. Accesses that run past 0xFFFF wrap around to 0, like the address register does.
+#define XOCHIP_ADDRESS_MASK (XOCHIP_ADDRESS_SPACE_SIZE - 1)
+#if (XOCHIP_ADDRESS_SPACE_SIZE & XOCHIP_ADDRESS_MASK) != 0
+#error "XOCHIP_ADDRESS_SPACE_SIZE must be a power of two for address masking"
+#endif
+
+// Where ROMs are loaded and where execution starts.
 #define XOCHIP_ADDRESS_SPACE_START 0x200
 
+// The largest ROM that fits, 0x10000 - 0x200. ROM sizes are size_t, so oversized files are rejected instead of
+// silently truncated to 16 bits.
+#define XOCHIP_ROM_SIZE_MAX (XOCHIP_ADDRESS_SPACE_SIZE - XOCHIP_ADDRESS_SPACE_START)
+
+// Writes to memory are tracked per page, so resets and snapshot restores only touch the pages that were written
+#define XOCHIP_PAGE_SIZE 256
+#define XOCHIP_PAGE_COUNT (XOCHIP_ADDRESS_SPACE_SIZE / XOCHIP_PAGE_SIZE)
+
+// A memoized frame keeps up to this many memory pages, frames that write more are always run
+#define XOCHIP_MEMO_PAGES 4
+
+// Define XOCHIP_XIP before every include of this header to run ROMs in place, e.g. from memory mapped flash, instead
+// of copying them into a 64kb memory[]. Only pages the ROM writes to get a copy in RAM, up to this many of them.
+#ifndef XOCHIP_XIP_PAGES
+#define XOCHIP_XIP_PAGES 8
+#endif
+#if XOCHIP_XIP_PAGES < 1 || XOCHIP_XIP_PAGES > 255
+#error "XOCHIP_XIP_PAGES must be between 1 and 255"
+#endif
+
+// Returned by a xochip_reader_t when the underlying storage failed
+#define XOCHIP_READ_ERROR ((size_t)-1)
+
 // The display's width and height. There's a xochip_display_t struct that the emulator uses that assumes this is always
 // the case.
 #define XOCHIP_DISPLAY_WIDTH 128
 #define XOCHIP_DISPLAY_HEIGHT 64
 #define XOCHIP_DISPLAY_PIXELS (XOCHIP_DISPLAY_WIDTH * XOCHIP_DISPLAY_HEIGHT)
 
+// Bytes per row in a display plane, the leftmost pixel is the most significant bit of the first byte
+#define XOCHIP_DISPLAY_ROW_BYTES (XOCHIP_DISPLAY_WIDTH / 8)
+
+// The low resolution the machine starts in and 00FE switches to. Its pixels are kept as they are, in the top left of
+// the planes, and only doubled to the 128x64 picture when someone looks at it, see xochip_display_row.
+#define XOCHIP_LORES_WIDTH 64
+#define XOCHIP_LORES_HEIGHT 32
+
+// Dxy0 draws 16x16 sprites, so no sprite has more rows than this
+#define XOCHIP_SPRITE_MAX_ROWS 16
+
+// Cxkk's generator is seeded with this on reset, see xochip_seed_random
+#define XOCHIP_RANDOM_SEED 0x2545F491u
+
 // XO-CHIP fonts are 5 rows tall, therefore 5 bytes
 #define XOCHIP_FONT_SIZE 5
 
+// SUPER-CHIP's big font is 10 rows tall, and lives right after the small one in the interpreter's memory
+#define XOCHIP_BIG_FONT_SIZE 10
+#define XOCHIP_BIG_FONT_ADDRESS (16 * XOCHIP_FONT_SIZE)
+
+// Fx75/Fx85 user flags, 8 on the HP 48 and 16 on XO-CHIP
+#define XOCHIP_FLAG_COUNT 16
+
 // XO-CHIP instruction size
 #define XOCHIP_OPCODE_SIZE 2
 
@@ -138,8 +191,34 @@ typedef enum xochip_result
     XOCHIP_ERR_ADDRESS_UNDERFLOW,   // attempted to access memory outside address space
     XOCHIP_ERR_STACK_OVERFLOW,      // tried to push to many subroutines onto the stack
     XOCHIP_ERR_NULL_POINTER,        // whatever pointer you passed to something was null
+    XOCHIP_STOPPED,                 // hit a breakpoint or watchpoint, see xochip_debugger_t for why
+    XOCHIP_ERR_READ,                // couldn't read the ROM from wherever it lives
+    XOCHIP_ERR_INVALID_ARGUMENT,    // an option passed to something is out of range
+    XOCHIP_ERR_STACK_UNDERFLOW,     // returned from a subroutine that was never called
+    XOCHIP_EXITED,                  // the ROM ran 00FD and is done, every cycle after returns this too
+    XOCHIP_ERR_WRITE,               // a writer callback, e.g. a recording's, failed
+    XOCHIP_ERR_OUT_OF_PAGES,        // XOCHIP_XIP only, the ROM wrote to more than XOCHIP_XIP_PAGES pages
 } xochip_result_t;
 
+/**
+ * Streams ROM data for xochip_load_rom_reader, e.g. straight out of flash or an SD card.
+ * @param context Whatever you passed to xochip_load_rom_reader
+ * @param buffer Where to put the data, this points directly into the emulator's memory, or with XOCHIP_XIP at a page
+ * sized buffer on the stack
+ * @param size Maximum number of bytes to read
+ * @return The number of bytes read (at most size), 0 at the end of the ROM, or XOCHIP_READ_ERROR
+ */
+typedef size_t (*xochip_reader_t)(void *context, uint8_t *buffer, size_t size);
+
+/**
+ * Takes output, e.g. a recording's or a terminal renderer's, to a file or a socket.
+ * @param context Whatever you passed along with the writer
+ * @param data The bytes to write
+ * @param size Number of bytes
+ * @return true when all of it was written
+ */
+typedef bool (*xochip_writer_t)(void *context, const uint8_t *data, size_t size);
+
 /**
  * V1-VF registers, these are used for indexing into the registers array in the xochip_t struct. You don't need to use
  * these directly.
@@ -168,6 +247,74 @@ typedef enum xochip_registers
     XOCHIP_VCOUNT  // just a sentinel value, not a register
 } xochip_registers_t;
 
+/**
+ * Every instruction the emulator knows about, see the list at the top of this file. xochip_decode maps an opcode to
+ * one of these, and xochip_cycle dispatches on the result, so tools that decode ROMs see exactly what the emulator does.
+ */
+typedef enum xochip_op
+{
+    // CHIP-8
+    XOCHIP_OP_SYS,
+    XOCHIP_OP_CLS,
+    XOCHIP_OP_RET,
+    XOCHIP_OP_JP_ADDR,
+    XOCHIP_OP_CALL,
+    XOCHIP_OP_SE_VX_BYTE,
+    XOCHIP_OP_SNE_VX_BYTE,
+    XOCHIP_OP_SE_VX_VY,
+    XOCHIP_OP_LD_VX_BYTE,
+    XOCHIP_OP_ADD_VX_BYTE,
+    XOCHIP_OP_LD_VX_VY,
+    XOCHIP_OP_OR_VX_VY,
+    XOCHIP_OP_AND_VX_VY,
+    XOCHIP_OP_XOR_VX_VY,
+    XOCHIP_OP_ADD_VX_VY,
+    XOCHIP_OP_SUB_VX_VY,
+    XOCHIP_OP_SHR_VX_VY,
+    XOCHIP_OP_SUBN_VX_VY,
+    XOCHIP_OP_SHL_VX_VY,
+    XOCHIP_OP_SNE_VX_VY,
+    XOCHIP_OP_LD_I_ADDR,
+    XOCHIP_OP_JP_V0_ADDR,
+    XOCHIP_OP_RND_VX_BYTE,
+    XOCHIP_OP_DRW_VX_VY_N,
+    XOCHIP_OP_SKP_VX,
+    XOCHIP_OP_SKNP_VX,
+    XOCHIP_OP_LD_VX_DT,
+    XOCHIP_OP_LD_VX_K,
+    XOCHIP_OP_LD_DT_VX,
+    XOCHIP_OP_LD_ST_VX,
+    XOCHIP_OP_ADD_I_VX,
+    XOCHIP_OP_LD_F_VX,
+    XOCHIP_OP_LD_B_VX,
+    XOCHIP_OP_LD_I_VX,
+    XOCHIP_OP_LD_VX_I,
+
+    // SUPER-CHIP
+    XOCHIP_OP_SCD_N,
+    XOCHIP_OP_SCR,
+    XOCHIP_OP_SCL,
+    XOCHIP_OP_EXIT,
+    XOCHIP_OP_LOW,
+    XOCHIP_OP_HIGH,
+    XOCHIP_OP_DRW_VX_VY_0,
+    XOCHIP_OP_LD_HF_VX,
+    XOCHIP_OP_LD_R_VX,
+    XOCHIP_OP_LD_VX_R,
+
+    // XO-CHIP
+    XOCHIP_OP_SAVE_VX_VY,
+    XOCHIP_OP_LOAD_VX_VY,
+    XOCHIP_OP_LD_I_LONG,
+    XOCHIP_OP_PLANE,
+    XOCHIP_OP_AUDIO,
+    XOCHIP_OP_LD_PITCH_VX,
+    XOCHIP_OP_SCU_N,
+
+    XOCHIP_OP_INVALID, // for invalid/unknown opcodes
+    XOCHIP_OP_COUNT    // just a sentinel value, not an op
+} xochip_op_t;
+
 /**
  * Used for representing XO-CHIP's hexadecimal input keys.
  */
@@ -202,16 +349,193 @@ typedef struct xochip_stack
 } xochip_stack_t;
 
 /**
- * 128x64 pixel display buffer. Each pixel is packed into 1024 uint8_t's, each bit corresponding to 1 pixel.
+ * 128x64 pixel display buffer. Each pixel is packed into 1024 uint8_t's, each bit corresponding to 1 pixel. In low
+ * resolution only the top left 64x32 pixels are used, with the same row stride, and everything else stays blank. Read
+ * rows with xochip_display_row to always get the 128x64 picture.
  */
 typedef struct xochip_display
 {
     uint8_t back_plane[XOCHIP_DISPLAY_PIXELS / 8]; // 8192 bits representing pixels
     uint8_t fore_plane[XOCHIP_DISPLAY_PIXELS / 8]; // 8192 bits representing pixels
-    uint8_t selected_plane;
+    uint8_t selected_plane; // bit 0 draws to back_plane, bit 1 to fore_plane
+    bool hires;             // 128x64 after 00FF, 64x32 after a reset or 00FE
     bool updated;
+    uint64_t dirty_rows; // bit n is set when row n of the 128x64 picture changed, like updated it's up to you to clear
 } xochip_display_t;
 
+/**
+ * Why the attached debugger stopped execution.
+ */
+typedef enum xochip_stop_reason
+{
+    XOCHIP_STOP_NONE,       // still running
+    XOCHIP_STOP_BREAKPOINT, // the program counter landed on a breakpoint, that instruction has NOT been executed yet
+    XOCHIP_STOP_READ,       // the last instruction read from a watched address, it has been executed
+    XOCHIP_STOP_WRITE,      // the last instruction wrote to a watched address, it has been executed
+} xochip_stop_reason_t;
+
+// Flags for xochip_set_watchpoint/xochip_clear_watchpoint
+#define XOCHIP_WATCH_READ 0x1
+#define XOCHIP_WATCH_WRITE 0x2
+
+/**
+ * Breakpoints and watchpoints, one bit per address in the address space for each kind (3 * 8kb). This is owned by you
+ * and attached with xochip_attach_debugger, so emulators that never debug don't pay for the space. Use the API below
+ * to set and clear points, and read stop_reason/stop_address after xochip_cycle returns XOCHIP_STOPPED.
+ */
+typedef struct xochip_debugger
+{
+    uint8_t breakpoints[XOCHIP_ADDRESS_SPACE_SIZE / 8];
+    uint8_t read_watch[XOCHIP_ADDRESS_SPACE_SIZE / 8];
+    uint8_t write_watch[XOCHIP_ADDRESS_SPACE_SIZE / 8];
+    uint32_t count; // number of set bits across all three bitmaps
+
+    xochip_stop_reason_t stop_reason;
+    uint16_t stop_address; // the breakpoint's address, or the first watched address that was accessed
+} xochip_debugger_t;
+
+// Instructions a single fused handler can cover at most (a run of 6xkk)
+#define XOCHIP_FUSED_MAX_LENGTH 8
+
+/**
+ * Handlers for common instruction sequences, run as one by xochip_run. These continue where xochip_op_t ends, so a
+ * pre-decoded handler is either a plain instruction or one of these.
+ */
+typedef enum xochip_fused
+{
+    XOCHIP_FUSED_SKIP_JP = XOCHIP_OP_COUNT, // 3xkk/4xkk, 1nnn
+    XOCHIP_FUSED_LD_I_DRW,                  // Annn, Dxyn
+    XOCHIP_FUSED_LD_VX_RUN,                 // 6xkk, 6xkk, ... up to XOCHIP_FUSED_MAX_LENGTH of them
+    XOCHIP_FUSED_DELAY_LOOP,                // Fx07, 3x00, 1nnn back to the Fx07
+    XOCHIP_DECODE_EMPTY = 0xFF,             // not decoded yet, or invalidated by a write to memory
+} xochip_fused_t;
+
+/**
+ * A pre-decoded instruction, see xochip_decode_cache_t.
+ */
+typedef struct xochip_decoded
+{
+    uint16_t opcode; // the first instruction's opcode
+    uint8_t handler; // an xochip_op_t or xochip_fused_t
+    uint8_t length;  // number of instructions the handler covers
+} xochip_decoded_t;
+
+/**
+ * One pre-decoded entry for every address in the address space (256kb). This is owned by you and attached with
+ * xochip_attach_decode_cache, which makes xochip_run decode each instruction only once and run common sequences with
+ * fused handlers. Entries are thrown away when the memory they were decoded from is written.
+ */
+typedef struct xochip_decode_cache
+{
+    xochip_decoded_t entries[XOCHIP_ADDRESS_SPACE_SIZE];
+} xochip_decode_cache_t;
+
+// Sprites remembered by a xochip_sprite_cache_t
+#define XOCHIP_SPRITE_CACHE_SIZE 32
+
+/**
+ * A sprite's rows, shifted right by 0-7 pixels so that each row lines up with the bytes of a display row. Every row
+ * takes 3 bytes, enough for a 16 pixel wide row shifted by 7.
+ */
+typedef struct xochip_sprite_entry
+{
+    uint16_t address; // where the rows are read from
+    uint8_t rows;     // 0 when the entry is empty
+    bool wide;        // 16 pixels per row (Dxy0) instead of 8
+    uint8_t shifts;   // bit n is set when shifted[n] has been filled in
+    uint8_t shifted[8][XOCHIP_SPRITE_MAX_ROWS * 3];
+} xochip_sprite_entry_t;
+
+/**
+ * Pre-shifted copies of recently drawn sprites (~12kb), owned by you and attached with xochip_attach_sprite_cache.
+ * Games redraw the same sprites from the same addresses every frame, this turns those draws into aligned XORs. An
+ * entry is dropped as soon as the memory it was read from is written, so self-modifying ROMs still draw correctly.
+ */
+typedef struct xochip_sprite_cache
+{
+    xochip_sprite_entry_t entries[XOCHIP_SPRITE_CACHE_SIZE];
+    uint8_t pages[XOCHIP_ADDRESS_SPACE_SIZE / 256 / 8]; // bit per 256 byte page that a cached sprite is read from
+} xochip_sprite_cache_t;
+
+/**
+ * A hash of the machine's state kept up to date piece by piece (~2.6kb), owned by you and attached with
+ * xochip_attach_hash. Writes to memory and the display only mark the pages and rows they touch, and xochip_state_hash
+ * rehashes just those, so reading the hash doesn't cost more for having 64kb of memory.
+ */
+typedef struct xochip_hash
+{
+    uint64_t pages[XOCHIP_PAGE_COUNT];          // hash of every memory page
+    uint64_t rows[XOCHIP_DISPLAY_HEIGHT];       // hash of every display row, both planes
+    uint64_t memory;                            // pages XORed together
+    uint64_t display;                           // rows XORed together
+    uint8_t stale_pages[XOCHIP_PAGE_COUNT / 8]; // bit n is set when page n was written since it was hashed
+    uint64_t stale_rows;                        // bit n is set when row n changed since it was hashed
+} xochip_hash_t;
+
+/**
+ * What each instruction costs, for pacing by cycles instead of by instructions. The unit is whatever the preset says,
+ * see xochip_cost_preset. A cost of 0 counts as 1, so a table only has to list what's expensive.
+ */
+typedef struct xochip_cost_table
+{
+    uint16_t ops[XOCHIP_OP_COUNT]; // base cost of each instruction
+    uint16_t sprite_row;           // extra per sprite row drawn by Dxyn/Dxy0
+    uint16_t register_copy;        // extra per register stored or loaded by Fx55/Fx65/5xy2/5xy3
+    uint32_t cycles_per_tick;      // what a 60 Hz frame costs on the machine this table models
+} xochip_cost_table_t;
+
+/**
+ * The machines xochip_cost_preset has tables for.
+ */
+typedef enum xochip_cost_preset
+{
+    XOCHIP_COST_VIP,    // COSMAC VIP, in microseconds. Approximate, from published measurements of the original
+    XOCHIP_COST_SCHIP,  // SUPER-CHIP on the HP 48, in plain instructions, 30 to a frame
+    XOCHIP_COST_XOCHIP, // XO-CHIP, in plain instructions, 1000 to a frame like Octo
+    XOCHIP_COST_PRESET_COUNT,
+} xochip_cost_preset_t;
+
+/**
+ * What a machine was waiting for when it stopped doing anything useful for the rest of a frame.
+ */
+typedef enum xochip_idle
+{
+    XOCHIP_IDLE_NONE,  // it was busy the whole frame
+    XOCHIP_IDLE_KEY,   // Fx0A, for a key
+    XOCHIP_IDLE_DELAY, // reading the delay timer over and over until it runs out
+    XOCHIP_IDLE_HALT,  // a jump to itself, for good
+} xochip_idle_t;
+
+/**
+ * What a machine did during a frame, collected while attached with xochip_attach_stats. Keys only change and the delay
+ * timer only runs down between frames, so once the machine waits for either of them it waits until the frame is over,
+ * and everything from idle_since on was spare.
+ */
+typedef struct xochip_frame_stats
+{
+    uint64_t start;       // emulator->cycles when the frame started, see xochip_stats_begin
+    xochip_idle_t idle;   // what it started waiting for, if it did
+    uint64_t idle_since;  // emulator->cycles when it did
+    uint32_t draws;       // Dxyn/Dxy0 run
+    uint32_t expired;     // Fx07 that found the delay timer already run out, a game that's late for its own pace
+    uint16_t poll;        // where the last Fx07 that found the timer running is, 0 for none
+    uint64_t poll_cycles; // emulator->cycles when it ran
+} xochip_frame_stats_t;
+
+/**
+ * Picks the cycles per frame for a game from its frame stats, see xochip_calibrate. Games that keep time with the delay
+ * timer or wait for keys show how much of a frame they need, and get that plus a margin. Games that never wait don't,
+ * and keep whatever they have.
+ */
+typedef struct xochip_calibrator
+{
+    uint32_t minimum;
+    uint32_t maximum;
+    uint32_t cycles_per_tick; // the pick for the next frame
+    uint32_t peak;            // the most a recent frame that drew needed before it waited, fading by 1/64 a frame
+    bool keeps_time;          // it was seen waiting, so a frame that doesn't is a frame it fell behind in
+} xochip_calibrator_t;
+
 /**
  * This is the main struct, which holds all the ROM, registers, counters, pressed keys, etc. All fields in here are
  * "private", just don't mess around in here unless you have a good reason to. The API below provides access and
@@ -225,13 +549,120 @@ typedef struct xochip
     uint16_t released_keys; // pressed keys packed into an uint16_t for space
 
     xochip_register_t registers[XOCHIP_VCOUNT];
+#ifdef XOCHIP_XIP
+    const uint8_t *rom;                                // read in place, from XOCHIP_ADDRESS_SPACE_START on
+    uint32_t rom_size;                                 // bytes of it
+    uint8_t page_slots[XOCHIP_PAGE_COUNT];             // 1 + where in pages page n's copy is, 0 while it has none
+    uint8_t pages_used;                                // copies in pages
+    uint8_t pages[XOCHIP_XIP_PAGES][XOCHIP_PAGE_SIZE]; // the pages that were written, copied on the first write
+#else
     uint8_t memory[XOCHIP_ADDRESS_SPACE_SIZE];
+#endif
+    uint8_t dirty_pages[XOCHIP_PAGE_COUNT / 8]; // bit n is set when page n may differ from a reset machine's memory
     xochip_stack_t stack;
 
     xochip_display_t display; // the pixel display buffer
     uint8_t audio[16];        // audio buffer, 16 bytes per spec
+    uint32_t random;          // Cxkk's xorshift32 state, part of the machine so snapshots replay the same numbers
+    uint64_t cycles;          // cost of everything executed since reset, see xochip_set_costs
+    uint8_t flags[XOCHIP_FLAG_COUNT]; // Fx75/Fx85 user flags
+
+    xochip_debugger_t *debugger; // optional, attached with xochip_attach_debugger
+    bool debugging;              // true only while a debugger is attached AND has at least one point set
+
+    xochip_decode_cache_t *decode_cache; // optional, attached with xochip_attach_decode_cache
+    xochip_sprite_cache_t *sprite_cache; // optional, attached with xochip_attach_sprite_cache
+    xochip_hash_t *hash;                 // optional, attached with xochip_attach_hash
+    const xochip_cost_table_t *costs;    // optional, set with xochip_set_costs, every instruction costs 1 without
+    xochip_frame_stats_t *stats;         // optional, attached with xochip_attach_stats
 } xochip_t;
 
+/**
+ * A snapshot of a machine, taken with xochip_save_state. Attachments (debugger, caches) aren't part of it.
+ */
+typedef struct xochip_state
+{
+    xochip_t machine;
+} xochip_state_t;
+
+/**
+ * Why xochip_run_budget returned.
+ */
+typedef enum xochip_yield
+{
+    XOCHIP_YIELD_BUDGET, // the budget is spent
+    XOCHIP_YIELD_FRAME,  // the timers just ticked and the display changed since the last frame, draw it
+    XOCHIP_YIELD_AUDIO,  // audio_period cycles passed since the last audio yield, refill the audio buffer
+} xochip_yield_t;
+
+/**
+ * Pacing state for xochip_run_budget, for hosts without a timer interrupt to drive xochip_tick. The timers tick every
+ * cycles_per_tick cycles, so everything is derived from the cycle count and a run is deterministic no matter how the
+ * host slices its budgets.
+ */
+typedef struct xochip_scheduler
+{
+    uint32_t cycles_per_tick; // cycles per 60 Hz timer tick, e.g. 8 for ~500 Hz, or a cost table's cycles_per_tick
+    uint32_t audio_period;    // cycles between XOCHIP_YIELD_AUDIO, 0 never yields for audio
+    uint32_t tick_phase;      // cycles into the current tick
+    uint32_t audio_phase;     // cycles into the current audio period
+    uint64_t cycles;          // cycles run in total
+    uint64_t ticks;           // timer ticks in total
+} xochip_scheduler_t;
+
+/**
+ * What one frame did to a machine, ~3.3kb. Everything but memory and the display is kept whole, the display only for
+ * the rows that changed and memory only for the pages that were written.
+ */
+typedef struct xochip_memo_entry
+{
+    uint64_t key; // the state hash the frame started from, mixed with the pacing
+    bool valid;
+
+    uint16_t counter;
+    uint16_t address;
+    uint16_t pressed_keys;
+    uint16_t released_keys;
+    xochip_register_t registers[XOCHIP_VCOUNT];
+    xochip_stack_t stack;
+    uint8_t audio[16];
+    uint32_t random;
+    uint8_t flags[XOCHIP_FLAG_COUNT];
+    uint8_t selected_plane;
+    bool hires;
+    bool updated;
+
+    uint64_t cycles;      // cycles the frame took
+    uint64_t ticks;       // timer ticks the scheduler did, if there was one
+    uint32_t tick_phase;  // and where it was left
+    uint32_t audio_phase;
+
+    uint64_t rows; // rows that changed, only those rows of the planes are kept
+    uint8_t back_plane[XOCHIP_DISPLAY_PIXELS / 8];
+    uint8_t fore_plane[XOCHIP_DISPLAY_PIXELS / 8];
+    uint8_t page_count;
+    uint8_t pages[XOCHIP_MEMO_PAGES];
+    uint8_t memory[XOCHIP_MEMO_PAGES][XOCHIP_PAGE_SIZE];
+} xochip_memo_entry_t;
+
+/**
+ * Frames already seen, by the state they started from, see xochip_memo_replay. The entries are yours, as many as you
+ * want to spend memory on. An entry is picked by its hash, a new frame replaces whatever was there.
+ */
+typedef struct xochip_memo
+{
+    xochip_memo_entry_t *entries;
+    size_t count;
+    uint64_t hits;   // frames replayed
+    uint64_t misses; // frames that had to be run
+
+    // the frame being run since the last miss, for xochip_memo_record
+    bool recording;
+    uint64_t key;
+    uint64_t cycles;
+    uint64_t ticks;
+} xochip_memo_t;
+
 // =====================================================================================================================
 //    API
 // =====================================================================================================================
@@ -247,6 +678,7 @@ xochip_result_t xochip_init(xochip_t *emulator);
 
 /**
  * @brief Resets the internal state of an emulator, like you just booted it up for the first time. ROM will be cleared.
+ * Only the memory pages written since the last reset are cleared, so a reset costs what the ROM touched.
  *
  * @param emulator A non-null pointer to an emulator
  * @return Success or error:
@@ -257,16 +689,35 @@ xochip_result_t xochip_reset(xochip_t *emulator);
 
 /**
  * @brief Load the full contents of a ROM into the emulator's address space. The emulator will completely clear the
- * memory and load in the new ROM. This is more convenient if you're able to allocate enough memory for a complete ROM.
+ * memory and load in the new ROM at XOCHIP_ADDRESS_SPACE_START. This is more convenient if you're able to allocate
+ * enough memory for a complete ROM. With XOCHIP_XIP nothing is copied, the ROM is read from data, which has to stay
+ * around and unchanged until the next load or reset.
  * @param emulator A non-null pointer to an emulator
  * @param data Beginning of the ROM data buffer
  * @param size The number of bytes to copy into the emulator's address space
  * @return Success or error:
  * - XOCHIP_SUCCESS when ok
- * - XOCHIP_ERR_NULL_POINTER when emulator is null
- * - XOCHIP_ERR_ROM_TOO_LARGE when ROM is too large to fit in the address space
+ * - XOCHIP_ERR_NULL_POINTER when emulator is null, or data is null with a non-zero size
+ * - XOCHIP_ERR_ROM_TOO_LARGE when ROM is larger than XOCHIP_ROM_SIZE_MAX
+ */
+xochip_result_t xochip_load_rom(xochip_t *emulator, const uint8_t *data, size_t size);
+
+/**
+ * @brief Load a ROM by streaming it through a reader callback, straight into the emulator's memory without a staging
+ * buffer. Like xochip_load_rom, the memory is cleared first and the ROM lands at XOCHIP_ADDRESS_SPACE_START. The reader
+ * is called until it returns 0. On error, whatever was read so far stays in memory. With XOCHIP_XIP the ROM is copied
+ * into the written pages, so only ROMs of up to XOCHIP_XIP_PAGES pages fit, use xochip_load_rom to run one in place.
+ * @param emulator A non-null pointer to an emulator
+ * @param reader Called repeatedly for the next chunk of the ROM
+ * @param context Passed through to reader
+ * @return Success or error:
+ * - XOCHIP_SUCCESS when ok
+ * - XOCHIP_ERR_NULL_POINTER when emulator or reader is null
+ * - XOCHIP_ERR_ROM_TOO_LARGE when the reader has more than XOCHIP_ROM_SIZE_MAX bytes
+ * - XOCHIP_ERR_READ when the reader returned XOCHIP_READ_ERROR
+ * - XOCHIP_ERR_OUT_OF_PAGES when built with XOCHIP_XIP and the ROM needs more than XOCHIP_XIP_PAGES pages
  */
-xochip_result_t xochip_load_rom(xochip_t *emulator, const uint8_t *data, uint16_t size);
+xochip_result_t xochip_load_rom_reader(xochip_t *emulator, xochip_reader_t reader, void *context);
 
 /**
  * @brief Write a chunk of memory into the address space. Useful if you can't copy the full ROM in one go for whatever
@@ -274,14 +725,36 @@ xochip_result_t xochip_load_rom(xochip_t *emulator, const uint8_t *data, uint16_
  * @param emulator A non-null pointer to an emulator
  * @param data Beginning of the ROM data buffer
  * @param size The number of bytes to copy into the emulator's address space
- * @param address Where in the emulator's address space you want to write this memory to (start from 0, not from 0x200!)
+ * @param address Where in the emulator's address space you want to write this memory to (ROMs start at
+ * XOCHIP_ADDRESS_SPACE_START)
  * @return Success or error:
  * - XOCHIP_SUCCESS when ok
- * - XOCHIP_ERR_NULL_POINTER when emulator is null
+ * - XOCHIP_ERR_NULL_POINTER when emulator or data is null
  * - XOCHIP_ERR_ROM_TOO_LARGE when ROM is too large to fit in the address space
- * - XOCHIP_ERR_OVERFLOW when write would overflow the address space
+ * - XOCHIP_ERR_ADDRESS_OVERFLOW when write would overflow the address space
+ * - XOCHIP_ERR_OUT_OF_PAGES when built with XOCHIP_XIP and the pages written don't fit
+ */
+xochip_result_t xochip_write_rom(xochip_t *emulator, const uint8_t *data, size_t size, uint16_t address);
+
+/**
+ * @brief Figure out which instruction an opcode is. This is the table xochip_cycle uses.
+ * @param opcode The 16-bit opcode, for F000 nnnn this is just the F000 half
+ * @return The instruction, or XOCHIP_OP_INVALID
+ */
+xochip_op_t xochip_decode(uint16_t opcode);
+
+/**
+ * @brief How many bytes an instruction takes up in memory, which is 2 except for XO-CHIP's F000 nnnn.
+ * @param op A decoded instruction
+ * @return The size in bytes
+ */
+uint8_t xochip_op_size(xochip_op_t op);
+
+/**
+ * @param op A decoded instruction
+ * @return The instruction's name as listed at the top of this file, e.g. "DRW_VX_VY_N"
  */
-xochip_result_t xochip_write_rom(xochip_t *emulator, const uint8_t *data, uint16_t size, uint16_t address);
+const char *xochip_op_name(xochip_op_t op);
 
 /**
  * @brief Perform the next operation. This doesn't handle timing or anything like that. That is left to you because it
@@ -294,6 +767,64 @@ xochip_result_t xochip_write_rom(xochip_t *emulator, const uint8_t *data, uint16
  */
 xochip_result_t xochip_cycle(xochip_t *emulator);
 
+/**
+ * @brief Perform up to cycles operations. With a decode cache attached, instructions are only decoded once and common
+ * sequences run as a single fused handler, which is much faster than calling xochip_cycle in a loop. Either way the
+ * result is exactly the same as calling xochip_cycle cycles times, and stops early on the first error.
+ * @param emulator A non-null pointer to an emulator
+ * @param cycles The maximum number of instructions to perform
+ * @param executed Receives the number of instructions performed, can be null
+ * @return Success or error, see xochip_cycle
+ */
+xochip_result_t xochip_run(xochip_t *emulator, uint32_t cycles, uint32_t *executed);
+
+/**
+ * @brief Set up a scheduler for xochip_run_budget.
+ * @param scheduler The scheduler to set up
+ * @param cycles_per_tick Cycles per 60 Hz timer tick, at least 1
+ * @param audio_period Cycles between XOCHIP_YIELD_AUDIO, 0 for never
+ * @return Success or error:
+ * - XOCHIP_SUCCESS when ok
+ * - XOCHIP_ERR_NULL_POINTER when scheduler is null
+ * - XOCHIP_ERR_INVALID_ARGUMENT when cycles_per_tick is 0
+ */
+xochip_result_t xochip_scheduler_init(xochip_scheduler_t *scheduler, uint32_t cycles_per_tick, uint32_t audio_period);
+
+/**
+ * @brief Run until the budget is spent, a frame is ready or audio needs refilling, whichever comes first. The timers
+ * are ticked along the way, don't call xochip_tick yourself. Doesn't allocate. Cycles are counted with the emulator's
+ * cost table, and without one the budget is never exceeded. With one, the last instruction can end past the budget
+ * or a tick, and the difference is carried over so the long run pace stays exact.
+ * @param emulator A non-null pointer to an emulator
+ * @param scheduler Pacing state from xochip_scheduler_init
+ * @param budget The most cycles to run
+ * @param consumed Receives the cycles run, can be null
+ * @param reason Receives why it returned, can be null. Only meaningful on success.
+ * @return Success or error, see xochip_cycle
+ */
+xochip_result_t xochip_run_budget(xochip_t *emulator, xochip_scheduler_t *scheduler, uint32_t budget,
+                                  uint32_t *consumed, xochip_yield_t *reason);
+
+/**
+ * @brief Count cycles with a cost table instead of 1 per instruction. Affects emulator->cycles and xochip_run_budget.
+ * While a table is set, xochip_run doesn't use fused handlers.
+ * @param emulator A non-null pointer to an emulator
+ * @param costs The table, e.g. from xochip_cost_preset, or NULL for 1 per instruction. It's not copied.
+ * @return Success or error:
+ * - XOCHIP_SUCCESS when ok
+ * - XOCHIP_ERR_NULL_POINTER when emulator is null
+ */
+xochip_result_t xochip_set_costs(xochip_t *emulator, const xochip_cost_table_t *costs);
+
+/**
+ * @brief A cost table for one of the machines XO-CHIP grew out of. The VIP's counts microseconds, the others count
+ * plain instructions like an ALU op or a jump, so without a table their cycles_per_tick is also how many instructions
+ * a frame runs. All of them charge Dxyn per sprite row, and clearing, scrolling and Fx33 more than a plain instruction.
+ * @param preset Which machine
+ * @return The machine's cost table, or NULL when preset is out of range
+ */
+const xochip_cost_table_t *xochip_cost_preset(xochip_cost_preset_t preset);
+
 /**
  * @brief Tick the emulators various timers down. It's recommended you call this function at 60 Hz, since that is what
  * the original CHIP-8s did. This function will always succeed.
@@ -316,781 +847,3168 @@ void xochip_key_up(xochip_t *emulator, xochip_keys_t key);
 void xochip_key_down(xochip_t *emulator, xochip_keys_t key);
 
 /**
- *
- * @param err A result returned from a function, assuming you're calling this after an error
- * @return A string description of the error
+ * @brief Read a byte of the machine's memory, wherever it's kept, e.g. still in the ROM with XOCHIP_XIP. Meant for
+ * hosts and tools that look at memory, it doesn't count as a read for watchpoints.
+ * @param emulator A non-null pointer to an emulator
+ * @param address The address to read, wrapped around the end of memory like the machine does
+ * @return The byte at the address
  */
-const char *xochip_strerror(xochip_result_t err);
-
-// =====================================================================================================================
-//    IMPLEMENTATION
-// =====================================================================================================================
+uint8_t xochip_peek(const xochip_t *emulator, uint16_t address);
 
-#ifdef XOCHIP_IMPLEMENTATION
+/**
+ * @brief Attach a debugger to the emulator, or detach it by passing NULL. The debugger is cleared when attached. The
+ * checks are skipped entirely unless at least one breakpoint or watchpoint is set.
+ * @param emulator A non-null pointer to an emulator
+ * @param debugger The debugger to attach, or NULL to detach the current one
+ * @return Success or error:
+ * - XOCHIP_SUCCESS when ok
+ * - XOCHIP_ERR_NULL_POINTER when emulator is null
+ */
+xochip_result_t xochip_attach_debugger(xochip_t *emulator, xochip_debugger_t *debugger);
 
-// =====================================================================================================================
-//    HELPERS
-// =====================================================================================================================
+/**
+ * @brief Stop before the instruction at address is executed. Calling xochip_cycle again after the stop executes it.
+ * @param emulator A non-null pointer to an emulator
+ * @param address The address of the instruction
+ * @return Success or error:
+ * - XOCHIP_SUCCESS when ok
+ * - XOCHIP_ERR_NULL_POINTER when emulator is null or has no debugger attached
+ */
+xochip_result_t xochip_set_breakpoint(xochip_t *emulator, xochip_address_t address);
 
-static xochip_result_t xochip_stack_push(xochip_stack_t *stack, uint16_t address)
-{
-    if (!stack)
-    {
-        return XOCHIP_ERR_NULL_POINTER;
-    }
+/**
+ * @brief Remove a breakpoint set with xochip_set_breakpoint. Clearing a breakpoint that isn't set does nothing.
+ * @param emulator A non-null pointer to an emulator
+ * @param address The address of the instruction
+ * @return Success or error:
+ * - XOCHIP_SUCCESS when ok
+ * - XOCHIP_ERR_NULL_POINTER when emulator is null or has no debugger attached
+ */
+xochip_result_t xochip_clear_breakpoint(xochip_t *emulator, xochip_address_t address);
 
-    if (stack->counter >= (sizeof(stack->addresses) - 1))
-    {
-        return XOCHIP_ERR_STACK_OVERFLOW; // I'm finally a real programmer now
-    }
+/**
+ * @brief Stop after any instruction that reads and/or writes the given range of memory.
+ * @param emulator A non-null pointer to an emulator
+ * @param address First address of the range
+ * @param length Number of bytes in the range
+ * @param flags XOCHIP_WATCH_READ, XOCHIP_WATCH_WRITE or both
+ * @return Success or error:
+ * - XOCHIP_SUCCESS when ok
+ * - XOCHIP_ERR_NULL_POINTER when emulator is null or has no debugger attached
+ * - XOCHIP_ERR_ADDRESS_OVERFLOW when the range runs past the end of the address space
+ */
+xochip_result_t xochip_set_watchpoint(xochip_t *emulator, xochip_address_t address, uint32_t length, uint8_t flags);
 
-    stack->addresses[stack->counter] = address;
-    stack->counter++;
+/**
+ * @brief Remove a watchpoint set with xochip_set_watchpoint.
+ * @param emulator A non-null pointer to an emulator
+ * @param address First address of the range
+ * @param length Number of bytes in the range
+ * @param flags XOCHIP_WATCH_READ, XOCHIP_WATCH_WRITE or both
+ * @return Success or error:
+ * - XOCHIP_SUCCESS when ok
+ * - XOCHIP_ERR_NULL_POINTER when emulator is null or has no debugger attached
+ * - XOCHIP_ERR_ADDRESS_OVERFLOW when the range runs past the end of the address space
+ */
+xochip_result_t xochip_clear_watchpoint(xochip_t *emulator, xochip_address_t address, uint32_t length, uint8_t flags);
 
-    return XOCHIP_SUCCESS;
-}
+/**
+ * @brief Attach a decode cache for xochip_run, or detach it by passing NULL. The cache is cleared when attached.
+ * @param emulator A non-null pointer to an emulator
+ * @param cache The cache to attach, or NULL to detach the current one
+ * @return Success or error:
+ * - XOCHIP_SUCCESS when ok
+ * - XOCHIP_ERR_NULL_POINTER when emulator is null
+ */
+xochip_result_t xochip_attach_decode_cache(xochip_t *emulator, xochip_decode_cache_t *cache);
 
-static xochip_result_t xochip_stack_pop(xochip_stack_t *stack, uint16_t *address)
-{
-    if (!stack || !address)
-    {
-        return XOCHIP_ERR_NULL_POINTER;
-    }
+/**
+ * @brief Attach a sprite cache for Dxyn, or detach it by passing NULL. The cache is cleared when attached.
+ * @param emulator A non-null pointer to an emulator
+ * @param cache The cache to attach, or NULL to detach the current one
+ * @return Success or error:
+ * - XOCHIP_SUCCESS when ok
+ * - XOCHIP_ERR_NULL_POINTER when emulator is null
+ */
+xochip_result_t xochip_attach_sprite_cache(xochip_t *emulator, xochip_sprite_cache_t *cache);
 
-    *address = stack->addresses[stack->counter];
+/**
+ * @brief Attach a state hash, which makes xochip_state_hash incremental, or detach it by passing NULL. The hash is
+ * cleared when attached, the first xochip_state_hash after that hashes everything.
+ * @param emulator A non-null pointer to an emulator
+ * @param hash The hash to attach, or NULL to detach the current one
+ * @return Success or error:
+ * - XOCHIP_SUCCESS when ok
+ * - XOCHIP_ERR_NULL_POINTER when emulator is null
+ */
+xochip_result_t xochip_attach_hash(xochip_t *emulator, xochip_hash_t *hash);
 
-    if (stack->counter > 0)
-    {
-        stack->addresses[stack->counter] = 0;
-        stack->counter--;
-    }
+/**
+ * @brief Hash everything that decides what the machine does next: memory, display, registers, timers, stack, keys,
+ * user flags, audio and the random generator, but not the cycle count or the dirty flags. Machines with the same hash
+ * behave the same given the same input, e.g. a machine whose hash didn't change over a frame is stuck for good. With a
+ * hash attached only what changed since the last call is rehashed, without one the whole machine is, to the same value.
+ * @param emulator A non-null pointer to an emulator
+ * @return The hash, or 0 when emulator is null
+ */
+uint64_t xochip_state_hash(xochip_t *emulator);
 
-    return XOCHIP_SUCCESS;
-}
+/**
+ * @brief Set up a memo over count entries you own, all of them empty.
+ * @param memo The memo
+ * @param entries Where frames are kept, it's not copied
+ * @param count How many entries there are, at least 1
+ * @return Success or error:
+ * - XOCHIP_SUCCESS when ok
+ * - XOCHIP_ERR_NULL_POINTER when memo or entries is null
+ * - XOCHIP_ERR_INVALID_ARGUMENT when count is 0
+ */
+xochip_result_t xochip_memo_init(xochip_memo_t *memo, xochip_memo_entry_t *entries, size_t count);
 
-// Used for checking released keys in emulator->released_keys
-static int8_t xochip_find_first_set_bit(uint16_t value)
-{
-    int8_t pos = 0;
+/**
+ * @brief Replay the next frame if a frame from the same state was recorded. A frame is whatever you run between this
+ * call and xochip_memo_record, e.g. running until the scheduler ticks, and has to be the same every time, input
+ * included: press and release keys before this call, not in between. On a miss nothing changes, run the frame and
+ * call xochip_memo_record. On a hit the machine, its cycle count and the scheduler end up as the frame left them, with
+ * the changed display rows flagged, but no instructions run, so debuggers see nothing: with breakpoints or watchpoints
+ * set every frame is a miss. Needs a hash attached with xochip_attach_hash, without one every frame is a miss.
+ * @param memo The memo
+ * @param emulator A non-null pointer to an emulator
+ * @param scheduler The scheduler pacing the frame, or NULL when you pace it yourself. Its phases are part of the state
+ * a frame is looked up by, so are the emulator's cost table and that of the frame being the same
+ * @return True when the frame was replayed, false when it has to be run
+ */
+bool xochip_memo_replay(xochip_memo_t *memo, xochip_t *emulator, xochip_scheduler_t *scheduler);
 
-    // Check lower byte first (usually faster on 8-bit MCUs)
-    if (!(value & 0xFF))
-    {
-        value >>= 8;
-        pos += 8;
-    }
+/**
+ * @brief Keep the frame run since xochip_memo_replay missed, for the next time the machine is in that state. Frames
+ * that failed or exited, or wrote more than XOCHIP_MEMO_PAGES pages of memory, aren't kept. Call it before anything
+ * else reads xochip_state_hash, which is what tells it which pages and rows the frame touched.
+ * @param memo The memo
+ * @param emulator The emulator passed to xochip_memo_replay
+ * @param scheduler The scheduler passed to xochip_memo_replay
+ * @param result What running the frame returned
+ */
+void xochip_memo_record(xochip_memo_t *memo, xochip_t *emulator, const xochip_scheduler_t *scheduler,
+                        xochip_result_t result);
 
-    // Binary search through remaining bits
-    if (!(value & 0x0F))
-    {
-        value >>= 4;
-        pos += 4;
-    }
-    if (!(value & 0x03))
-    {
-        value >>= 2;
-        pos += 2;
-    }
-    if (!(value & 0x01))
-    {
-        pos += 1;
-    }
+/**
+ * @brief Attach frame stats, or detach them by passing NULL. They're cleared and a frame starts when attached. Frames
+ * replayed by xochip_memo_replay aren't seen, their cycles don't count.
+ * @param emulator A non-null pointer to an emulator
+ * @param stats The stats to attach, or NULL to detach the current ones
+ * @return Success or error:
+ * - XOCHIP_SUCCESS when ok
+ * - XOCHIP_ERR_NULL_POINTER when emulator is null
+ */
+xochip_result_t xochip_attach_stats(xochip_t *emulator, xochip_frame_stats_t *stats);
 
-    return pos;
+/**
+ * @brief Start a new frame in the attached stats, e.g. right after the timers ticked. Does nothing without stats.
+ * @param emulator A non-null pointer to an emulator
+ */
+void xochip_stats_begin(xochip_t *emulator);
+
+/**
+ * @brief Set up a calibrator.
+ * @param calibrator The calibrator
+ * @param minimum The fewest cycles per frame it picks, at least 1
+ * @param maximum The most cycles per frame it picks, what the host can afford
+ * @param initial Cycles per frame until the game shows what it needs, and for games that never do
+ * @return Success or error:
+ * - XOCHIP_SUCCESS when ok
+ * - XOCHIP_ERR_NULL_POINTER when calibrator is null
+ * - XOCHIP_ERR_INVALID_ARGUMENT when minimum is 0, or initial isn't between minimum and maximum
+ */
+xochip_result_t xochip_calibrator_init(xochip_calibrator_t *calibrator, uint32_t minimum, uint32_t maximum,
+                                       uint32_t initial);
+
+/**
+ * @brief Pick the cycles per frame for the next frame from the frame that just ended, and start the next one. Call it
+ * once a frame, after the timers ticked. A frame the game waited in teaches it what the game needs, and it settles a
+ * quarter above the busiest recent frame that drew something. A frame a game that waits didn't wait in, or one where it
+ * found the delay timer already run out, means it fell behind, and it doubles, stopping once at 4 times what the
+ * busiest recent frame that drew needed.
+ * @param calibrator A calibrator from xochip_calibrator_init
+ * @param emulator A non-null pointer to an emulator with stats attached, without them nothing changes
+ * @param scheduler When not NULL, its cycles_per_tick is set to the pick, never at or below where it is into the tick
+ * @return The pick
+ */
+uint32_t xochip_calibrate(xochip_calibrator_t *calibrator, xochip_t *emulator, xochip_scheduler_t *scheduler);
+
+/**
+ * @brief Get a row of the 128x64 picture. In high resolution that's the plane's own row, in low resolution row y / 2
+ * with every pixel doubled, so nothing is scaled until it's looked at.
+ * @param display The display
+ * @param plane 0 for the back plane, 1 for the fore plane
+ * @param y Row of the picture, 0 to XOCHIP_DISPLAY_HEIGHT - 1
+ * @param scratch XOCHIP_DISPLAY_ROW_BYTES bytes for a doubled row
+ * @return The row's XOCHIP_DISPLAY_ROW_BYTES bytes, either in the plane or in scratch
+ */
+const uint8_t *xochip_display_row(const xochip_display_t *display, uint8_t plane, uint8_t y, uint8_t *scratch);
+
+/**
+ * @brief Copy both planes out as the 128x64 picture, doubling every pixel in low resolution.
+ * @param display The display
+ * @param back_plane Receives XOCHIP_DISPLAY_PIXELS / 8 bytes
+ * @param fore_plane Receives XOCHIP_DISPLAY_PIXELS / 8 bytes
+ */
+void xochip_display_expand(const xochip_display_t *display, uint8_t *back_plane, uint8_t *fore_plane);
+
+/**
+ * @brief Take a snapshot of the machine: memory, registers, stack, display, timers, keys and the random generator.
+ * @param emulator A non-null pointer to an emulator
+ * @param state Receives the snapshot
+ * @return Success or error:
+ * - XOCHIP_SUCCESS when ok
+ * - XOCHIP_ERR_NULL_POINTER when emulator or state is null
+ */
+xochip_result_t xochip_save_state(const xochip_t *emulator, xochip_state_t *state);
+
+/**
+ * @brief Put the machine back the way it was when the snapshot was taken. The emulator keeps its own attachments, its
+ * caches are flushed and the whole display is marked as updated. Only memory pages written by the emulator or by the
+ * snapshot's machine are copied, so restoring costs what both of them touched.
+ * @param emulator A non-null pointer to an initialized emulator
+ * @param state A snapshot from xochip_save_state, possibly taken from another emulator
+ * @return Success or error:
+ * - XOCHIP_SUCCESS when ok
+ * - XOCHIP_ERR_NULL_POINTER when emulator or state is null
+ */
+xochip_result_t xochip_load_state(xochip_t *emulator, const xochip_state_t *state);
+
+/**
+ * @brief Seed the generator Cxkk draws from. xochip_reset seeds it with XOCHIP_RANDOM_SEED, so a run is reproducible
+ * unless you seed it with something else.
+ * @param emulator A non-null pointer to an emulator
+ * @param seed Any value, 0 is replaced with XOCHIP_RANDOM_SEED
+ */
+void xochip_seed_random(xochip_t *emulator, uint32_t seed);
+
+/**
+ *
+ * @param err A result returned from a function, assuming you're calling this after an error
+ * @return A string description of the error
+ */
+const char *xochip_strerror(xochip_result_t err);
+
+#ifdef __cplusplus
 }
+#endif
 
 // =====================================================================================================================
-//    OP CODE HANDLERS
+//    IMPLEMENTATION
 // =====================================================================================================================
 
-// clear the screen
-inline xochip_result_t xochip_op_cls(xochip_t *emulator)
-{
-    memset(emulator->display.back_plane, 0, sizeof(emulator->display.back_plane));
-    memset(emulator->display.fore_plane, 0, sizeof(emulator->display.fore_plane));
-    emulator->display.updated = true;
-    return XOCHIP_SUCCESS;
-}
+#ifdef XOCHIP_IMPLEMENTATION
 
-// return from a subroutine
-inline xochip_result_t xochip_op_ret(xochip_t *emulator)
-{
-    return xochip_stack_pop(&emulator->stack, &emulator->counter);
-}
+// =====================================================================================================================
+//    HELPERS
+// =====================================================================================================================
 
-// jump to an address
-inline xochip_result_t xochip_op_jp_addr(xochip_t *emulator, uint16_t address)
+// The hex digits Fx29 points at, one 5 byte character each
+static const uint8_t xochip_font[16 * XOCHIP_FONT_SIZE] = {
+    0xF0, 0x90, 0x90, 0x90, 0xF0, 0x20, 0x60, 0x20, 0x20, 0x70, 0xF0, 0x10, 0xF0, 0x80, 0xF0, 0xF0,
+    0x10, 0xF0, 0x10, 0xF0, 0x90, 0x90, 0xF0, 0x10, 0x10, 0xF0, 0x80, 0xF0, 0x10, 0xF0, 0xF0, 0x80,
+    0xF0, 0x90, 0xF0, 0xF0, 0x10, 0x20, 0x40, 0x40, 0xF0, 0x90, 0xF0, 0x90, 0xF0, 0xF0, 0x90, 0xF0,
+    0x10, 0xF0, 0xF0, 0x90, 0xF0, 0x90, 0x90, 0xE0, 0x90, 0xE0, 0x90, 0xE0, 0xF0, 0x80, 0x80, 0x80,
+    0xF0, 0xE0, 0x90, 0x90, 0x90, 0xE0, 0xF0, 0x80, 0xF0, 0x80, 0xF0, 0xF0, 0x80, 0xF0, 0x80, 0x80,
+};
+
+// The big hex digits Fx30 points at, one 10 byte character each, as Octo draws them
+static const uint8_t xochip_big_font[16 * XOCHIP_BIG_FONT_SIZE] = {
+    0xFF, 0xFF, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0x18, 0x78, 0x78, 0x18, 0x18, 0x18,
+    0x18, 0x18, 0xFF, 0xFF, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xFF, 0xFF,
+    0x03, 0x03, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0x03, 0x03,
+    0x03, 0x03, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0xFF, 0xFF, 0xC0, 0xC0,
+    0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0xFF, 0xFF, 0x03, 0x03, 0x06, 0x0C, 0x18, 0x18, 0x18, 0x18,
+    0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF,
+    0x03, 0x03, 0xFF, 0xFF, 0x7E, 0xFF, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xC3, 0xFC, 0xFC,
+    0xC3, 0xC3, 0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, 0x3C, 0xFF, 0xC3, 0xC0, 0xC0, 0xC0, 0xC0, 0xC3,
+    0xFF, 0x3C, 0xFC, 0xFE, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFE, 0xFC, 0xFF, 0xFF, 0xC0, 0xC0,
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xC0, 0xC0,
+};
+
+#ifdef XOCHIP_XIP
+
+// What address holds until it's written: the fonts, the ROM where it lies, and zeros everywhere else
+static inline uint8_t xochip_unwritten_byte(const xochip_t *emulator, const uint32_t address)
 {
-    if (address < XOCHIP_ADDRESS_SPACE_START)
+    const uint32_t offset = address - XOCHIP_ADDRESS_SPACE_START;
+    if (offset < emulator->rom_size)
     {
-        return XOCHIP_ERR_ADDRESS_UNDERFLOW;
+        return emulator->rom[offset];
     }
-
-    address -= XOCHIP_ADDRESS_SPACE_START;
-    if (address > XOCHIP_ADDRESS_SPACE_SIZE)
+    if (address < sizeof(xochip_font))
     {
-        return XOCHIP_ERR_ADDRESS_OVERFLOW;
+        return xochip_font[address];
     }
-
-    emulator->counter = address;
-    return XOCHIP_SUCCESS;
+    if (address - XOCHIP_BIG_FONT_ADDRESS < sizeof(xochip_big_font))
+    {
+        return xochip_big_font[address - XOCHIP_BIG_FONT_ADDRESS];
+    }
+    return 0;
 }
 
-// call a subroutine at address
-static xochip_result_t xochip_op_call(xochip_t *emulator, uint16_t address)
+// The copy of page the next write goes to, made on the first write. NULL when every copy is taken.
+static uint8_t *xochip_writable_page(xochip_t *emulator, const uint32_t page)
 {
-    if (address < XOCHIP_ADDRESS_SPACE_START)
+    if (emulator->page_slots[page])
     {
-        return XOCHIP_ERR_ADDRESS_UNDERFLOW;
+        return emulator->pages[emulator->page_slots[page] - 1];
     }
-
-    address -= XOCHIP_ADDRESS_SPACE_START;
-    if (address > XOCHIP_ADDRESS_SPACE_SIZE)
+    if (emulator->pages_used == XOCHIP_XIP_PAGES)
     {
-        return XOCHIP_ERR_ADDRESS_OVERFLOW;
+        return NULL;
     }
 
-    const xochip_result_t res = xochip_stack_push(&emulator->stack, emulator->counter);
-    if (!res)
+    uint8_t *copy = emulator->pages[emulator->pages_used++];
+    emulator->page_slots[page] = emulator->pages_used;
+    for (uint32_t offset = 0; offset < XOCHIP_PAGE_SIZE; ++offset)
     {
-        return res;
+        copy[offset] = xochip_unwritten_byte(emulator, page * XOCHIP_PAGE_SIZE + offset);
     }
+    return copy;
+}
 
-    emulator->counter = address;
-    return XOCHIP_SUCCESS;
+// The only way the interpreter touches memory. Addresses are masked like in memory[] builds, written pages are read
+// from their copy and everything else from where it lies.
+static inline uint8_t xochip_read_byte(const xochip_t *emulator, uint32_t address)
+{
+    address &= XOCHIP_ADDRESS_MASK;
+    const uint8_t slot = emulator->page_slots[address / XOCHIP_PAGE_SIZE];
+    return slot ? emulator->pages[slot - 1][address % XOCHIP_PAGE_SIZE] : xochip_unwritten_byte(emulator, address);
 }
 
-static xochip_result_t xochip_op_se_vx_b(xochip_t *emulator, const xochip_register_t reg, const uint8_t byte)
+static inline void xochip_read_block(const xochip_t *emulator, const uint32_t address, uint8_t *destination,
+                                     const uint32_t length)
 {
-    if (emulator->registers[reg] == byte)
+    for (uint32_t index = 0; index < length; ++index)
     {
-        emulator->counter += XOCHIP_OPCODE_SIZE;
+        destination[index] = xochip_read_byte(emulator, address + index);
     }
-    return XOCHIP_SUCCESS;
 }
 
-static xochip_result_t xochip_op_sne_vx_b(xochip_t *emulator, const xochip_register_t reg, const uint8_t byte)
+// The number of bytes written, which stops short of length at the first page there's no copy left for
+static inline uint32_t xochip_write_block(xochip_t *emulator, const uint32_t address, const uint8_t *source,
+                                          const uint32_t length)
 {
-    if (emulator->registers[reg] != byte)
+    for (uint32_t index = 0; index < length; ++index)
     {
-        emulator->counter += XOCHIP_OPCODE_SIZE;
+        const uint32_t masked = (address + index) & XOCHIP_ADDRESS_MASK;
+        uint8_t *page = xochip_writable_page(emulator, masked / XOCHIP_PAGE_SIZE);
+        if (!page)
+        {
+            return index;
+        }
+        page[masked % XOCHIP_PAGE_SIZE] = source[index];
     }
-    return XOCHIP_SUCCESS;
+    return length;
 }
 
-static xochip_result_t xochip_op_se_vx_vy(xochip_t *emulator, const xochip_register_t vx, const xochip_register_t vy)
+// The bytes of page, read into scratch unless they're somewhere they can be read as they are
+static inline const uint8_t *xochip_page_bytes(const xochip_t *emulator, const uint32_t page, uint8_t *scratch)
 {
-    if (emulator->registers[vx] == emulator->registers[vy])
+    const uint32_t offset = page * XOCHIP_PAGE_SIZE - XOCHIP_ADDRESS_SPACE_START;
+    if (emulator->page_slots[page])
     {
-        emulator->counter += XOCHIP_OPCODE_SIZE;
+        return emulator->pages[emulator->page_slots[page] - 1];
+    }
+    if (page * XOCHIP_PAGE_SIZE >= XOCHIP_ADDRESS_SPACE_START && offset + XOCHIP_PAGE_SIZE <= emulator->rom_size)
+    {
+        return emulator->rom + offset;
     }
-    return XOCHIP_SUCCESS;
-}
 
-static xochip_result_t xochip_op_ld_vx_b(xochip_t *emulator, const xochip_register_t vx, const uint8_t byte)
-{
-    emulator->registers[vx] = byte;
-    return XOCHIP_SUCCESS;
+    xochip_read_block(emulator, page * XOCHIP_PAGE_SIZE, scratch, XOCHIP_PAGE_SIZE);
+    return scratch;
 }
 
-static xochip_result_t xochip_op_add_vx_b(xochip_t *emulator, const xochip_register_t vx, const uint8_t byte)
-{
-    emulator->registers[vx] += byte;
-    return XOCHIP_SUCCESS;
-}
+#else
 
-static xochip_result_t xochip_op_ld_vx_vy(xochip_t *emulator, const xochip_register_t vx, const xochip_register_t vy)
+// The only way the interpreter touches memory[]. Addresses are masked, and blocks that run past the end are split in
+// two, so every access stays inside memory[] without a branch on the common path. These don't tell the debugger or
+// the caches, see xochip_memory_read and xochip_memory_written for that.
+static inline uint8_t xochip_read_byte(const xochip_t *emulator, const uint32_t address)
 {
-    emulator->registers[vx] = emulator->registers[vy];
-    return XOCHIP_SUCCESS;
+    return emulator->memory[address & XOCHIP_ADDRESS_MASK];
 }
 
-static xochip_result_t xochip_op_or_xv_vy(xochip_t *emulator, const xochip_register_t vx, const xochip_register_t vy)
+static inline void xochip_read_block(const xochip_t *emulator, const uint32_t address, uint8_t *destination,
+                                     const uint32_t length)
 {
-    emulator->registers[vx] |= emulator->registers[vy];
-    emulator->registers[XOCHIP_VF] = 0;
-    return XOCHIP_SUCCESS;
+    const uint32_t start = address & XOCHIP_ADDRESS_MASK;
+    const uint32_t first = start + length > XOCHIP_ADDRESS_SPACE_SIZE ? XOCHIP_ADDRESS_SPACE_SIZE - start : length;
+    memcpy(destination, emulator->memory + start, first);
+    if (first < length)
+    {
+        memcpy(destination + first, emulator->memory, length - first);
+    }
 }
 
-static xochip_result_t xochip_op_and_xv_vy(xochip_t *emulator, const xochip_register_t vx, const xochip_register_t vy)
+static inline uint32_t xochip_write_block(xochip_t *emulator, const uint32_t address, const uint8_t *source,
+                                          const uint32_t length)
 {
-    emulator->registers[vx] &= emulator->registers[vy];
-    emulator->registers[XOCHIP_VF] = 0;
-    return XOCHIP_SUCCESS;
+    const uint32_t start = address & XOCHIP_ADDRESS_MASK;
+    const uint32_t first = start + length > XOCHIP_ADDRESS_SPACE_SIZE ? XOCHIP_ADDRESS_SPACE_SIZE - start : length;
+    memcpy(emulator->memory + start, source, first);
+    if (first < length)
+    {
+        memcpy(emulator->memory, source + first, length - first);
+    }
+    return length;
 }
 
-static xochip_result_t xochip_op_xor_xv_vy(xochip_t *emulator, const xochip_register_t vx, const xochip_register_t vy)
+static inline const uint8_t *xochip_page_bytes(const xochip_t *emulator, const uint32_t page, uint8_t *scratch)
 {
-    emulator->registers[vx] ^= emulator->registers[vy];
-    emulator->registers[XOCHIP_VF] = 0;
-    return XOCHIP_SUCCESS;
+    (void)scratch;
+    return emulator->memory + page * XOCHIP_PAGE_SIZE;
 }
 
-static xochip_result_t xochip_op_add_xv_vy(xochip_t *emulator, const xochip_register_t vx, const xochip_register_t vy)
-{
-    emulator->registers[vx] += emulator->registers[vy];
-    emulator->registers[XOCHIP_VF] = emulator->registers[vx] <= emulator->registers[vy] ? 1 : 0;
-    return XOCHIP_SUCCESS;
-}
+#endif
 
-static xochip_result_t xochip_op_sub_xv_vy(xochip_t *emulator, const xochip_register_t vx, const xochip_register_t vy)
+static xochip_result_t xochip_stack_push(xochip_stack_t *stack, uint16_t address)
 {
-    // This one took more finesse to make the test ROMs happy
-    const uint8_t _vx = emulator->registers[vx];
-    const uint8_t _vy = emulator->registers[vy];
-    emulator->registers[vx] = _vx - _vy;
-    emulator->registers[XOCHIP_VF] = _vx >= _vy ? 1 : 0;
-    return XOCHIP_SUCCESS;
-}
+    if (!stack)
+    {
+        return XOCHIP_ERR_NULL_POINTER;
+    }
 
-// There's some confusion on this one, SHR 1 or SHR VY?
-static xochip_result_t xochip_op_shr_xv_vy(xochip_t *emulator, const xochip_register_t vx, const xochip_register_t vy)
-{
-    const uint8_t carry = emulator->registers[vx] & 0x1;
-    emulator->registers[vx] >>= emulator->registers[vy];
-    emulator->registers[XOCHIP_VF] = carry;
-    return XOCHIP_SUCCESS;
-}
+    if (stack->counter >= sizeof(stack->addresses) / sizeof(stack->addresses[0]))
+    {
+        return XOCHIP_ERR_STACK_OVERFLOW; // I'm finally a real programmer now
+    }
 
-static xochip_result_t xochip_op_subn_xv_vy(xochip_t *emulator, const xochip_register_t vx, const xochip_register_t vy)
-{
-    emulator->registers[vx] = emulator->registers[vy] - emulator->registers[vx];
-    emulator->registers[XOCHIP_VF] = emulator->registers[vy] >= emulator->registers[vx] ? 1 : 0;
-    return XOCHIP_SUCCESS;
-}
+    stack->addresses[stack->counter] = address;
+    stack->counter++;
 
-static xochip_result_t xochip_op_shl_xv_vy(xochip_t *emulator, const xochip_register_t vx, const xochip_register_t vy)
-{
-    const uint8_t carry = (emulator->registers[vx] & 0x80) >> 7;
-    emulator->registers[vx] <<= emulator->registers[vy];
-    emulator->registers[XOCHIP_VF] = carry;
     return XOCHIP_SUCCESS;
 }
 
-static xochip_result_t xochip_op_sne_xv_vy(xochip_t *emulator, const xochip_register_t vx, const xochip_register_t vy)
+static xochip_result_t xochip_stack_pop(xochip_stack_t *stack, uint16_t *address)
 {
-    if (emulator->registers[vx] != emulator->registers[vy])
+    if (!stack || !address)
     {
-        emulator->counter += XOCHIP_OPCODE_SIZE;
+        return XOCHIP_ERR_NULL_POINTER;
     }
-    return XOCHIP_SUCCESS;
-}
 
-static xochip_result_t xochip_op_ld_i(xochip_t *emulator, const xochip_address_t address)
-{
-    emulator->address = address;
-    return XOCHIP_SUCCESS;
-}
+    if (stack->counter == 0)
+    {
+        return XOCHIP_ERR_STACK_UNDERFLOW;
+    }
+
+    stack->counter--;
+    *address = stack->addresses[stack->counter];
+    stack->addresses[stack->counter] = 0;
 
-static xochip_result_t xochip_op_jp_v0_addr(xochip_t *emulator, const xochip_address_t address)
-{
-    emulator->address = emulator->registers[XOCHIP_V0] + address;
     return XOCHIP_SUCCESS;
 }
 
-static xochip_result_t xochip_op_rnd_vx_b(xochip_t *emulator, const xochip_register_t vx, const uint8_t byte)
+// Used for checking released keys in emulator->released_keys
+static int8_t xochip_find_first_set_bit(uint16_t value)
 {
-    const uint8_t rnd = (uint8_t)(rand() % 0xFF);
-    emulator->registers[vx] = rnd & byte;
-    return XOCHIP_SUCCESS;
+    int8_t pos = 0;
+
+    // Check lower byte first (usually faster on 8-bit MCUs)
+    if (!(value & 0xFF))
+    {
+        value >>= 8;
+        pos += 8;
+    }
+
+    // Binary search through remaining bits
+    if (!(value & 0x0F))
+    {
+        value >>= 4;
+        pos += 4;
+    }
+    if (!(value & 0x03))
+    {
+        value >>= 2;
+        pos += 2;
+    }
+    if (!(value & 0x01))
+    {
+        pos += 1;
+    }
+
+    return pos;
 }
 
-static xochip_result_t xochip_op_drw_vx_vy_n(xochip_t *emulator, const xochip_register_t vx, const xochip_register_t vy,
-                                             const uint8_t height)
+#define XOCHIP_BITMAP_TEST(bitmap, bit) ((bitmap)[(bit) >> 3] & (1u << ((bit) & 0x7)))
+
+// Sets or clears a bit, returns 1 when the bit actually changed so callers can keep count
+static uint32_t xochip_bitmap_update(uint8_t *bitmap, const uint32_t bit, const bool set)
 {
+    const uint8_t mask = (uint8_t)(1u << (bit & 0x7));
+    const bool was_set = (bitmap[bit >> 3] & mask) != 0;
 
-    return XOCHIP_SUCCESS;
+    if (set)
+    {
+        bitmap[bit >> 3] |= mask;
+    }
+    else
+    {
+        bitmap[bit >> 3] &= (uint8_t)~mask;
+    }
+
+    return was_set != set;
 }
 
-static xochip_result_t xochip_op_skp_vx(xochip_t *emulator, const xochip_register_t vx)
+// Called by every op that reads/writes memory through I. The fast path is a single test of emulator->debugging.
+static void xochip_watch(xochip_t *emulator, const uint8_t *bitmap, const xochip_stop_reason_t reason,
+                         const uint32_t address, const uint32_t length)
 {
-    const uint16_t key = (uint16_t)0x1 << (emulator->registers[vx]);
-    if (emulator->pressed_keys & key)
+    xochip_debugger_t *debugger = emulator->debugger;
+
+    // only report the first access of an instruction
+    if (debugger->stop_reason != XOCHIP_STOP_NONE)
     {
-        emulator->counter += XOCHIP_OPCODE_SIZE;
+        return;
+    }
+
+    for (uint32_t offset = 0; offset < length; ++offset)
+    {
+        const uint32_t watched = (address + offset) & (XOCHIP_ADDRESS_SPACE_SIZE - 1);
+        if (XOCHIP_BITMAP_TEST(bitmap, watched))
+        {
+            debugger->stop_reason = reason;
+            debugger->stop_address = (uint16_t)watched;
+            return;
+        }
     }
-    return XOCHIP_SUCCESS;
 }
 
-static xochip_result_t xochip_op_skpn_vx(xochip_t *emulator, const xochip_register_t vx)
+static inline void xochip_memory_read(xochip_t *emulator, const uint32_t address, const uint32_t length)
 {
-    const uint16_t key = (uint16_t)0x1 << (emulator->registers[vx]);
-    if (!(emulator->pressed_keys & key))
+    if (emulator->debugging)
     {
-        emulator->counter += XOCHIP_OPCODE_SIZE;
+        xochip_watch(emulator, emulator->debugger->read_watch, XOCHIP_STOP_READ, address, length);
     }
-    return XOCHIP_SUCCESS;
 }
 
-static xochip_result_t xochip_op_ld_vx_dt(xochip_t *emulator, const xochip_register_t vx)
+// Forgets everything pre-decoded from the given range of memory, including fused sequences that run into it
+static void xochip_invalidate_decoded(xochip_decode_cache_t *cache, const uint32_t address, const uint32_t length)
 {
-    emulator->registers[vx] = emulator->registers[XOCHIP_VDELAY];
-    return XOCHIP_SUCCESS;
+    const uint32_t reach = XOCHIP_FUSED_MAX_LENGTH * XOCHIP_OPCODE_SIZE - 1;
+    for (uint32_t offset = 0; offset < length + reach; ++offset)
+    {
+        const uint16_t decoded = (uint16_t)(address - reach + offset);
+        cache->entries[decoded].handler = XOCHIP_DECODE_EMPTY;
+    }
 }
 
-static xochip_result_t xochip_op_ld_vx_k(xochip_t *emulator, const xochip_register_t vx)
+// Drops every cached sprite that's read from [address, address + length), which must not wrap around
+static void xochip_invalidate_sprites(xochip_sprite_cache_t *cache, const uint32_t address, const uint32_t length)
 {
-    if (!(emulator->released_keys))
+    bool cached = false;
+    for (uint32_t page = address >> 8; page <= ((address + length - 1) >> 8); ++page)
     {
-        emulator->counter -= XOCHIP_OPCODE_SIZE;
-        return XOCHIP_SUCCESS;
+        cached = cached || XOCHIP_BITMAP_TEST(cache->pages, page);
     }
 
-    // we wouldn't get here if emulator->released_keys wasn't 0, therefore, there should always be a set bit
-    emulator->registers[vx] = xochip_find_first_set_bit(emulator->released_keys);
-    return XOCHIP_SUCCESS;
+    // the common case, nothing was ever drawn from here
+    if (!cached)
+    {
+        return;
+    }
+
+    memset(cache->pages, 0, sizeof(cache->pages));
+    for (uint8_t index = 0; index < XOCHIP_SPRITE_CACHE_SIZE; ++index)
+    {
+        xochip_sprite_entry_t *entry = &cache->entries[index];
+        if (!entry->rows)
+        {
+            continue;
+        }
+
+        const uint32_t start = entry->address;
+        const uint32_t end = start + entry->rows * (entry->wide ? 2u : 1u);
+        if (start < address + length && address < end)
+        {
+            entry->rows = 0;
+            continue;
+        }
+
+        for (uint32_t page = start >> 8; page <= ((end - 1) >> 8); ++page)
+        {
+            cache->pages[page >> 3] |= (uint8_t)(1u << (page & 0x7));
+        }
+    }
 }
 
-static xochip_result_t xochip_op_ld_dt_vx(xochip_t *emulator, const xochip_register_t vx)
+// Marks the pages [address, address + length) falls in as dirty, wrapping around like addresses do
+static inline void xochip_mark_pages(uint8_t *pages, const uint32_t address, const uint32_t length)
 {
-    emulator->registers[XOCHIP_VDELAY] = emulator->registers[vx];
-    return XOCHIP_SUCCESS;
+    if (length == 0)
+    {
+        return;
+    }
+
+    const uint32_t last = (address + length - 1) / XOCHIP_PAGE_SIZE;
+    for (uint32_t page = address / XOCHIP_PAGE_SIZE; page <= last; ++page)
+    {
+        const uint32_t wrapped = page % XOCHIP_PAGE_COUNT;
+        pages[wrapped >> 3] |= (uint8_t)(1u << (wrapped & 0x7));
+    }
 }
 
-static xochip_result_t xochip_op_ld_st_vx(xochip_t *emulator, const xochip_register_t vx)
+// Called when the pages set in pages were replaced, e.g. by a reset or a snapshot, drops what the caches hold for them
+static void xochip_pages_replaced(xochip_t *emulator, const uint8_t *pages)
 {
-    emulator->registers[XOCHIP_VSOUND] = emulator->registers[vx];
-    return XOCHIP_SUCCESS;
+    if (emulator->hash)
+    {
+        for (uint32_t index = 0; index < sizeof(emulator->hash->stale_pages); ++index)
+        {
+            emulator->hash->stale_pages[index] |= pages[index];
+        }
+    }
+
+    if (!emulator->decode_cache && !emulator->sprite_cache)
+    {
+        return;
+    }
+
+    for (uint32_t page = 0; page < XOCHIP_PAGE_COUNT; ++page)
+    {
+        if (!XOCHIP_BITMAP_TEST(pages, page))
+        {
+            continue;
+        }
+
+        if (emulator->decode_cache)
+        {
+            xochip_invalidate_decoded(emulator->decode_cache, page * XOCHIP_PAGE_SIZE, XOCHIP_PAGE_SIZE);
+        }
+        if (emulator->sprite_cache)
+        {
+            xochip_invalidate_sprites(emulator->sprite_cache, page * XOCHIP_PAGE_SIZE, XOCHIP_PAGE_SIZE);
+        }
+    }
 }
 
-static xochip_result_t xochip_op_add_i_vx(xochip_t *emulator, const xochip_register_t vx)
+// Puts memory back to what the interpreter itself keeps there, which is zeros and the fonts. Only the dirty pages can
+// be anything else, so only those are touched.
+static void xochip_clear_memory(xochip_t *emulator)
 {
-    emulator->address += emulator->registers[vx];
-    return XOCHIP_SUCCESS;
+    xochip_pages_replaced(emulator, emulator->dirty_pages);
+
+#ifdef XOCHIP_XIP
+    // the fonts are read from where they are, dropping the copies and the ROM leaves nothing else
+    emulator->rom = NULL;
+    emulator->rom_size = 0;
+    memset(emulator->page_slots, 0, sizeof(emulator->page_slots));
+    emulator->pages_used = 0;
+#else
+    for (uint32_t page = 0; page < XOCHIP_PAGE_COUNT; ++page)
+    {
+        if (XOCHIP_BITMAP_TEST(emulator->dirty_pages, page))
+        {
+            memset(emulator->memory + page * XOCHIP_PAGE_SIZE, 0, XOCHIP_PAGE_SIZE);
+        }
+    }
+
+    // the fonts live in page 0
+    if (XOCHIP_BITMAP_TEST(emulator->dirty_pages, 0))
+    {
+        memcpy(emulator->memory, xochip_font, sizeof(xochip_font));
+        memcpy(emulator->memory + XOCHIP_BIG_FONT_ADDRESS, xochip_big_font, sizeof(xochip_big_font));
+    }
+#endif
+
+    memset(emulator->dirty_pages, 0, sizeof(emulator->dirty_pages));
 }
 
-static xochip_result_t xochip_op_ld_f_vx(xochip_t *emulator, const xochip_register_t vx)
+// Called when the host put data into [address, address + length), e.g. a ROM, which must not wrap around
+static void xochip_memory_loaded(xochip_t *emulator, const uint32_t address, const uint32_t length)
 {
-    const uint8_t digit = emulator->registers[vx];
-    emulator->address = digit * XOCHIP_FONT_SIZE;
-    return XOCHIP_SUCCESS;
+    if (length == 0)
+    {
+        return;
+    }
+
+    xochip_mark_pages(emulator->dirty_pages, address, length);
+    if (emulator->hash)
+    {
+        xochip_mark_pages(emulator->hash->stale_pages, address, length);
+    }
+    if (emulator->decode_cache)
+    {
+        xochip_invalidate_decoded(emulator->decode_cache, address, length);
+    }
+    if (emulator->sprite_cache)
+    {
+        xochip_invalidate_sprites(emulator->sprite_cache, address, length);
+    }
 }
 
-static xochip_result_t xochip_op_ld_b_vx(xochip_t *emulator, const xochip_register_t vx)
+static inline void xochip_memory_written(xochip_t *emulator, const uint32_t address, const uint32_t length)
 {
-    const xochip_address_t VI = emulator->address;
-    uint8_t value = emulator->registers[vx];
-    emulator->memory[VI + 2] = value % 10;
-    value /= 10;
-    emulator->memory[VI + 1] = value % 10;
-    value /= 10;
-    emulator->memory[VI] = value % 10;
-    return XOCHIP_SUCCESS;
+    if (length == 0)
+    {
+        return;
+    }
+
+    xochip_mark_pages(emulator->dirty_pages, address, length);
+    if (emulator->hash)
+    {
+        xochip_mark_pages(emulator->hash->stale_pages, address, length);
+    }
+
+    if (emulator->debugging)
+    {
+        xochip_watch(emulator, emulator->debugger->write_watch, XOCHIP_STOP_WRITE, address, length);
+    }
+
+    if (emulator->decode_cache)
+    {
+        xochip_invalidate_decoded(emulator->decode_cache, address, length);
+    }
+
+    if (emulator->sprite_cache)
+    {
+        // a write that wraps around the end of the address space is two separate ranges
+        const uint32_t start = address & (XOCHIP_ADDRESS_SPACE_SIZE - 1);
+        const uint32_t first = start + length > XOCHIP_ADDRESS_SPACE_SIZE ? XOCHIP_ADDRESS_SPACE_SIZE - start : length;
+        xochip_invalidate_sprites(emulator->sprite_cache, start, first);
+        if (first < length)
+        {
+            xochip_invalidate_sprites(emulator->sprite_cache, 0, length - first);
+        }
+    }
 }
 
-static xochip_result_t xochip_op_ld_i_vx(xochip_t *emulator, const xochip_register_t vx)
+// Writes the instruction's bytes and tells the debugger and the caches about the ones that made it to memory
+static inline xochip_result_t xochip_memory_store(xochip_t *emulator, const uint32_t address, const uint8_t *source,
+                                                  const uint32_t length)
+{
+    const uint32_t written = xochip_write_block(emulator, address, source, length);
+    xochip_memory_written(emulator, address, written);
+    return written == length ? XOCHIP_SUCCESS : XOCHIP_ERR_OUT_OF_PAGES;
+}
+
+// Bit n of value ends up in bits 2n and 2n + 1, so a row of low resolution pixels becomes a row twice as wide, and a
+// mask of low resolution rows the mask of the picture rows they're shown on
+static inline uint64_t xochip_double_bits(const uint32_t value)
+{
+    uint64_t bits = value;
+    bits = (bits | bits << 16) & 0x0000FFFF0000FFFFULL;
+    bits = (bits | bits << 8) & 0x00FF00FF00FF00FFULL;
+    bits = (bits | bits << 4) & 0x0F0F0F0F0F0F0F0FULL;
+    bits = (bits | bits << 2) & 0x3333333333333333ULL;
+    bits = (bits | bits << 1) & 0x5555555555555555ULL;
+    return bits | bits << 1;
+}
+
+// Rows and columns the current resolution has, both powers of two
+static inline uint8_t xochip_display_width(const xochip_display_t *display)
+{
+    return display->hires ? XOCHIP_DISPLAY_WIDTH : XOCHIP_LORES_WIDTH;
+}
+
+static inline uint8_t xochip_display_height(const xochip_display_t *display)
+{
+    return display->hires ? XOCHIP_DISPLAY_HEIGHT : XOCHIP_LORES_HEIGHT;
+}
+
+// Flags rows of the planes as changed, for the host and for an attached hash. The host sees them as rows of the 128x64
+// picture, the hash as rows of the planes.
+static inline void xochip_display_changed(xochip_t *emulator, const uint64_t rows)
 {
-    for (xochip_register_t reg = 0; reg <= emulator->registers[vx]; ++reg)
+    emulator->display.updated = true;
+    emulator->display.dirty_rows |= emulator->display.hires ? rows : xochip_double_bits((uint32_t)rows);
+    if (emulator->hash)
     {
-        emulator->memory[emulator->address] = emulator->registers[reg];
-        emulator->address++;
+        emulator->hash->stale_rows |= rows;
     }
-    return XOCHIP_SUCCESS;
 }
 
-static xochip_result_t xochip_op_ld_vx_i(xochip_t *emulator, const xochip_register_t vx)
+// Notes in the attached stats that the machine started waiting, only the first wait of a frame counts
+static inline void xochip_idle(xochip_t *emulator, const xochip_idle_t idle, const uint64_t since)
 {
-    for (xochip_register_t reg = 0; reg <= emulator->registers[vx]; ++reg)
+    xochip_frame_stats_t *stats = emulator->stats;
+    if (stats && stats->idle == XOCHIP_IDLE_NONE)
     {
-        emulator->registers[reg] = emulator->memory[emulator->address];
-        emulator->address++;
+        stats->idle = idle;
+        stats->idle_since = since;
     }
-    return XOCHIP_SUCCESS;
 }
 
-// =====================================================================================================================
-//    XO-CHIP EXTENSION OP-CODES
-// =====================================================================================================================
-
-static xochip_result_t xochip_op_save_vx_vy(xochip_t *emulator, const xochip_register_t vx, const xochip_register_t vy)
+// Notes in the attached stats that the delay timer was read from the Fx07 before counter. Reading it at the same place
+// twice while it's running means a whole trip around a loop that waits for it.
+static inline void xochip_delay_read(xochip_t *emulator, const uint16_t counter)
 {
-    const xochip_register_t start = min(vx, vy);
-    const xochip_register_t end = max(vx, vy);
+    xochip_frame_stats_t *stats = emulator->stats;
+    if (!stats)
+    {
+        return;
+    }
 
-    for (xochip_register_t reg = start; reg <= end; ++reg)
+    if (emulator->registers[XOCHIP_VDELAY] == 0)
     {
-        emulator->memory[emulator->address] = emulator->registers[reg];
-        emulator->address++;
+        stats->expired++;
+        stats->poll = 0;
+    }
+    else if (stats->poll == counter)
+    {
+        xochip_idle(emulator, XOCHIP_IDLE_DELAY, stats->poll_cycles);
+    }
+    else
+    {
+        stats->poll = counter;
+        stats->poll_cycles = emulator->cycles;
     }
-    return XOCHIP_SUCCESS;
 }
 
-static xochip_result_t xochip_op_load_vx_vy(xochip_t *emulator, const xochip_register_t vx, const xochip_register_t vy)
+// =====================================================================================================================
+//    OP CODE HANDLERS
+// =====================================================================================================================
+
+// Reads the 16-bit opcode at address
+static inline uint16_t xochip_fetch(const xochip_t *emulator, const uint16_t address)
 {
-    const xochip_register_t start = min(vx, vy);
-    const xochip_register_t end = max(vx, vy);
+    return (uint16_t)(xochip_read_byte(emulator, address) << 8 | xochip_read_byte(emulator, address + 1u));
+}
 
-    for (xochip_register_t reg = start; reg <= end; ++reg)
-    {
-        emulator->registers[reg] = emulator->memory[emulator->address];
-        emulator->address++;
-    }
+// Skips the next instruction, which is 4 bytes when it's XO-CHIP's F000 nnnn
+static void xochip_skip(xochip_t *emulator)
+{
+    const bool long_instruction = xochip_fetch(emulator, emulator->counter) == 0xF000;
+    emulator->counter += long_instruction ? 2 * XOCHIP_OPCODE_SIZE : XOCHIP_OPCODE_SIZE;
+}
+
+// clear the screen, in low resolution only its rows, the rest of the planes is blank anyway
+static xochip_result_t xochip_op_cls(xochip_t *emulator)
+{
+    const uint8_t height = xochip_display_height(&emulator->display);
+    memset(emulator->display.back_plane, 0, height * XOCHIP_DISPLAY_ROW_BYTES);
+    memset(emulator->display.fore_plane, 0, height * XOCHIP_DISPLAY_ROW_BYTES);
+    xochip_display_changed(emulator, UINT64_MAX);
     return XOCHIP_SUCCESS;
 }
 
-static xochip_result_t xochip_op_ld_i_long(xochip_t *emulator, const xochip_address_t addr)
+// 00FE and 00FF switch the resolution and, like in Octo, clear both planes whether they're selected or not
+static xochip_result_t xochip_op_resolution(xochip_t *emulator, const bool hires)
 {
-    emulator->address = addr;
+    memset(emulator->display.back_plane, 0, sizeof(emulator->display.back_plane));
+    memset(emulator->display.fore_plane, 0, sizeof(emulator->display.fore_plane));
+    emulator->display.hires = hires;
+    xochip_display_changed(emulator, UINT64_MAX);
     return XOCHIP_SUCCESS;
 }
 
-static xochip_result_t xochip_op_plane(xochip_t *emulator, const uint8_t plane)
+// scroll the selected planes down by rows, what scrolls in from the top is blank
+static xochip_result_t xochip_op_scd(xochip_t *emulator, const uint8_t rows)
 {
-    emulator->display.selected_plane = plane;
+    uint8_t *planes[2] = {emulator->display.back_plane, emulator->display.fore_plane};
+    const size_t size = xochip_display_height(&emulator->display) * XOCHIP_DISPLAY_ROW_BYTES;
+    const size_t shift = rows * XOCHIP_DISPLAY_ROW_BYTES;
+
+    for (uint8_t plane = 0; plane < 2; ++plane)
+    {
+        if (emulator->display.selected_plane & (1u << plane))
+        {
+            memmove(planes[plane] + shift, planes[plane], size - shift);
+            memset(planes[plane], 0, shift);
+        }
+    }
+
+    xochip_display_changed(emulator, UINT64_MAX);
     return XOCHIP_SUCCESS;
 }
 
-static xochip_result_t xochip_op_audio(xochip_t *emulator)
+// scroll the selected planes up by rows, what scrolls in from the bottom is blank
+static xochip_result_t xochip_op_scu(xochip_t *emulator, const uint8_t rows)
 {
-    memcpy(emulator->audio, &emulator->memory[emulator->address], sizeof(emulator->audio));
+    uint8_t *planes[2] = {emulator->display.back_plane, emulator->display.fore_plane};
+    const size_t shift = rows * XOCHIP_DISPLAY_ROW_BYTES;
+    const size_t kept = xochip_display_height(&emulator->display) * XOCHIP_DISPLAY_ROW_BYTES - shift;
+
+    for (uint8_t plane = 0; plane < 2; ++plane)
+    {
+        if (emulator->display.selected_plane & (1u << plane))
+        {
+            memmove(planes[plane], planes[plane] + shift, kept);
+            memset(planes[plane] + kept, 0, shift);
+        }
+    }
+
+    xochip_display_changed(emulator, UINT64_MAX);
     return XOCHIP_SUCCESS;
 }
 
-static xochip_result_t xochip_op_pitch(xochip_t *emulator, const xochip_register_t vx)
+// scroll the selected planes 4 pixels right, or left
+static xochip_result_t xochip_op_scroll_horizontal(xochip_t *emulator, const bool right)
 {
-    emulator->registers[XOCHIP_VPITCH] = emulator->registers[vx];
+    uint8_t *planes[2] = {emulator->display.back_plane, emulator->display.fore_plane};
+    const uint8_t height = xochip_display_height(&emulator->display);
+    const uint8_t row_bytes = xochip_display_width(&emulator->display) / 8;
+
+    for (uint8_t plane = 0; plane < 2; ++plane)
+    {
+        if (!(emulator->display.selected_plane & (1u << plane)))
+        {
+            continue;
+        }
+
+        for (uint8_t y = 0; y < height; ++y)
+        {
+            uint8_t *line = planes[plane] + y * XOCHIP_DISPLAY_ROW_BYTES;
+            if (right)
+            {
+                for (uint8_t byte = row_bytes - 1; byte > 0; --byte)
+                {
+                    line[byte] = (uint8_t)((line[byte] >> 4) | (line[byte - 1] << 4));
+                }
+                line[0] >>= 4;
+            }
+            else
+            {
+                for (uint8_t byte = 0; byte < row_bytes - 1; ++byte)
+                {
+                    line[byte] = (uint8_t)((line[byte] << 4) | (line[byte + 1] >> 4));
+                }
+                line[row_bytes - 1] = (uint8_t)(line[row_bytes - 1] << 4);
+            }
+        }
+    }
+
+    xochip_display_changed(emulator, UINT64_MAX);
     return XOCHIP_SUCCESS;
 }
 
-// =====================================================================================================================
-//    API IMPLEMENTATIONS
-// =====================================================================================================================
-xochip_result_t xochip_init(xochip_t *emulator) { return xochip_reset(emulator); }
+// return from a subroutine
+static xochip_result_t xochip_op_ret(xochip_t *emulator)
+{
+    return xochip_stack_pop(&emulator->stack, &emulator->counter);
+}
 
-xochip_result_t xochip_reset(xochip_t *emulator)
+// jump to an address
+// Every 16-bit address is in memory and fetches wrap like any other access, so the only targets that are off limits are
+// the interpreter's, below XOCHIP_ADDRESS_SPACE_START
+static xochip_result_t xochip_op_jp_addr(xochip_t *emulator, uint16_t address)
 {
-    if (!emulator)
+    if (address < XOCHIP_ADDRESS_SPACE_START)
     {
-        return XOCHIP_ERR_NULL_POINTER;
+        return XOCHIP_ERR_ADDRESS_UNDERFLOW;
     }
 
-    emulator->counter = 0;
-    emulator->address = 0;
-    emulator->pressed_keys = 0;
-    emulator->released_keys = 0;
-    emulator->stack.counter = 0;
-
-    memset(emulator->memory, 0, sizeof(emulator->memory));
-    memset(emulator->registers, 0, sizeof(emulator->registers));
-    memset(emulator->stack.addresses, 0, sizeof(emulator->stack.addresses));
-    memset(emulator->display.back_plane, 0, sizeof(emulator->display.back_plane));
-    memset(emulator->display.fore_plane, 0, sizeof(emulator->display.fore_plane));
+    // a jump to itself never goes anywhere again
+    if (address == (uint16_t)(emulator->counter - XOCHIP_OPCODE_SIZE))
+    {
+        xochip_idle(emulator, XOCHIP_IDLE_HALT, emulator->cycles);
+    }
 
+    emulator->counter = address;
     return XOCHIP_SUCCESS;
 }
 
-xochip_result_t xochip_load_rom(xochip_t *emulator, const uint8_t *data, uint16_t size)
+// call a subroutine at address
+static xochip_result_t xochip_op_call(xochip_t *emulator, uint16_t address)
 {
-    if (!emulator)
+    if (address < XOCHIP_ADDRESS_SPACE_START)
     {
-        return XOCHIP_ERR_NULL_POINTER;
+        return XOCHIP_ERR_ADDRESS_UNDERFLOW;
     }
 
-    if (size > XOCHIP_ADDRESS_SPACE_SIZE)
+    const xochip_result_t res = xochip_stack_push(&emulator->stack, emulator->counter);
+    if (res != XOCHIP_SUCCESS)
     {
-        return XOCHIP_ERR_ROM_TOO_LARGE;
+        return res;
     }
 
-    memset(emulator->memory, 0, sizeof(emulator->memory));
-    memcpy(emulator->memory, data, size);
+    emulator->counter = address;
     return XOCHIP_SUCCESS;
 }
 
-xochip_result_t xochip_write_rom(xochip_t *emulator, const uint8_t *data, uint16_t size, uint16_t address)
+static xochip_result_t xochip_op_se_vx_b(xochip_t *emulator, const xochip_register_t reg, const uint8_t byte)
 {
-    if (!emulator)
+    if (emulator->registers[reg] == byte)
     {
-        return XOCHIP_ERR_NULL_POINTER;
+        xochip_skip(emulator);
     }
+    return XOCHIP_SUCCESS;
+}
 
-    if (size > XOCHIP_ADDRESS_SPACE_SIZE)
+static xochip_result_t xochip_op_sne_vx_b(xochip_t *emulator, const xochip_register_t reg, const uint8_t byte)
+{
+    if (emulator->registers[reg] != byte)
     {
-        return XOCHIP_ERR_ROM_TOO_LARGE;
+        xochip_skip(emulator);
     }
+    return XOCHIP_SUCCESS;
+}
 
-    if ((address + size) > XOCHIP_ADDRESS_SPACE_SIZE)
+static xochip_result_t xochip_op_se_vx_vy(xochip_t *emulator, const xochip_register_t vx, const xochip_register_t vy)
+{
+    if (emulator->registers[vx] == emulator->registers[vy])
     {
-        return XOCHIP_ERR_ADDRESS_OVERFLOW;
+        xochip_skip(emulator);
     }
+    return XOCHIP_SUCCESS;
+}
 
-    memcpy(emulator->memory + address, data, size);
+static xochip_result_t xochip_op_ld_vx_b(xochip_t *emulator, const xochip_register_t vx, const uint8_t byte)
+{
+    emulator->registers[vx] = byte;
     return XOCHIP_SUCCESS;
 }
 
-// This trusts your emulator pointer is not null
-xochip_result_t xochip_cycle(xochip_t *emulator)
+static xochip_result_t xochip_op_add_vx_b(xochip_t *emulator, const xochip_register_t vx, const uint8_t byte)
 {
+    emulator->registers[vx] += byte;
+    return XOCHIP_SUCCESS;
+}
 
-    const uint16_t next_instruction =
-        (emulator->memory[emulator->counter] << 8) | (emulator->memory[emulator->counter + 1]);
+static xochip_result_t xochip_op_ld_vx_vy(xochip_t *emulator, const xochip_register_t vx, const xochip_register_t vy)
+{
+    emulator->registers[vx] = emulator->registers[vy];
+    return XOCHIP_SUCCESS;
+}
 
-    emulator->counter += XOCHIP_OPCODE_SIZE;
+static xochip_result_t xochip_op_or_xv_vy(xochip_t *emulator, const xochip_register_t vx, const xochip_register_t vy)
+{
+    emulator->registers[vx] |= emulator->registers[vy];
+    return XOCHIP_SUCCESS;
+}
 
-    xochip_result_t result = XOCHIP_SUCCESS;
+static xochip_result_t xochip_op_and_xv_vy(xochip_t *emulator, const xochip_register_t vx, const xochip_register_t vy)
+{
+    emulator->registers[vx] &= emulator->registers[vy];
+    return XOCHIP_SUCCESS;
+}
 
-    switch (OPCODE_N1(next_instruction))
-    {
-    case 0x0:
-    {
-        switch (next_instruction)
-        {
-        case 0x00E0:
-            result = xochip_op_cls(emulator);
-            break;
-        case 0x00EE:
-            result = xochip_op_ret(emulator);
-            break;
-        default:
-            // else this is a SYS command which we don't handle
-            break;
-        }
-    }
-    case 0x1:
-    {
-        const uint16_t address = OPCODE_NNN(next_instruction);
-        result = xochip_op_jp_addr(emulator, address);
+static xochip_result_t xochip_op_xor_xv_vy(xochip_t *emulator, const xochip_register_t vx, const xochip_register_t vy)
+{
+    emulator->registers[vx] ^= emulator->registers[vy];
+    return XOCHIP_SUCCESS;
+}
+
+static xochip_result_t xochip_op_add_xv_vy(xochip_t *emulator, const xochip_register_t vx, const xochip_register_t vy)
+{
+    // VF is written last, so it holds the flag even when it's also the destination
+    const uint16_t sum = (uint16_t)(emulator->registers[vx] + emulator->registers[vy]);
+    emulator->registers[vx] = (uint8_t)sum;
+    emulator->registers[XOCHIP_VF] = sum > 0xFF ? 1 : 0;
+    return XOCHIP_SUCCESS;
+}
+
+static xochip_result_t xochip_op_sub_xv_vy(xochip_t *emulator, const xochip_register_t vx, const xochip_register_t vy)
+{
+    // This one took more finesse to make the test ROMs happy
+    const uint8_t _vx = emulator->registers[vx];
+    const uint8_t _vy = emulator->registers[vy];
+    emulator->registers[vx] = _vx - _vy;
+    emulator->registers[XOCHIP_VF] = _vx >= _vy ? 1 : 0;
+    return XOCHIP_SUCCESS;
+}
+
+// There's some confusion on this one, SHR 1 or SHR VY? Neither, XO-CHIP (like the original) shifts VY by 1 into VX.
+static xochip_result_t xochip_op_shr_xv_vy(xochip_t *emulator, const xochip_register_t vx, const xochip_register_t vy)
+{
+    const uint8_t carry = emulator->registers[vy] & 0x1;
+    emulator->registers[vx] = emulator->registers[vy] >> 1;
+    emulator->registers[XOCHIP_VF] = carry;
+    return XOCHIP_SUCCESS;
+}
+
+static xochip_result_t xochip_op_subn_xv_vy(xochip_t *emulator, const xochip_register_t vx, const xochip_register_t vy)
+{
+    const uint8_t _vx = emulator->registers[vx];
+    const uint8_t _vy = emulator->registers[vy];
+    emulator->registers[vx] = _vy - _vx;
+    emulator->registers[XOCHIP_VF] = _vy >= _vx ? 1 : 0;
+    return XOCHIP_SUCCESS;
+}
+
+static xochip_result_t xochip_op_shl_xv_vy(xochip_t *emulator, const xochip_register_t vx, const xochip_register_t vy)
+{
+    const uint8_t carry = (emulator->registers[vy] & 0x80) >> 7;
+    emulator->registers[vx] = (uint8_t)(emulator->registers[vy] << 1);
+    emulator->registers[XOCHIP_VF] = carry;
+    return XOCHIP_SUCCESS;
+}
+
+static xochip_result_t xochip_op_sne_xv_vy(xochip_t *emulator, const xochip_register_t vx, const xochip_register_t vy)
+{
+    if (emulator->registers[vx] != emulator->registers[vy])
+    {
+        xochip_skip(emulator);
+    }
+    return XOCHIP_SUCCESS;
+}
+
+static xochip_result_t xochip_op_ld_i(xochip_t *emulator, const xochip_address_t address)
+{
+    emulator->address = address;
+    return XOCHIP_SUCCESS;
+}
+
+static xochip_result_t xochip_op_jp_v0_addr(xochip_t *emulator, const xochip_address_t address)
+{
+    emulator->counter = (uint16_t)(emulator->registers[XOCHIP_V0] + address);
+    return XOCHIP_SUCCESS;
+}
+
+static xochip_result_t xochip_op_rnd_vx_b(xochip_t *emulator, const xochip_register_t vx, const uint8_t byte)
+{
+    // xorshift32, cheap and good enough for games
+    uint32_t random = emulator->random;
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    emulator->random = random;
+
+    emulator->registers[vx] = (uint8_t)(random >> 24) & byte;
+    return XOCHIP_SUCCESS;
+}
+
+// Shifts a sprite's rows right by shift pixels, spreading each row over 3 bytes
+static void xochip_shift_sprite(const xochip_t *emulator, const uint16_t address, const uint8_t rows, const bool wide,
+                                const uint8_t shift, uint8_t *shifted)
+{
+    uint8_t sprite[2 * XOCHIP_SPRITE_MAX_ROWS];
+    xochip_read_block(emulator, address, sprite, rows * (wide ? 2u : 1u));
+
+    const uint8_t *source = sprite;
+    for (uint8_t row = 0; row < rows; ++row)
+    {
+        uint32_t bits = (uint32_t)*source++ << 16;
+        if (wide)
+        {
+            bits |= (uint32_t)*source++ << 8;
+        }
+
+        bits >>= shift;
+        shifted[row * 3 + 0] = (uint8_t)(bits >> 16);
+        shifted[row * 3 + 1] = (uint8_t)(bits >> 8);
+        shifted[row * 3 + 2] = (uint8_t)bits;
+    }
+}
+
+// Finds (or makes) a sprite in the cache and returns its rows shifted by shift. Returns NULL when the sprite can't be
+// cached because its rows wrap around the end of the address space.
+static const uint8_t *xochip_cached_sprite(xochip_t *emulator, const uint16_t address, const uint8_t rows,
+                                           const bool wide, const uint8_t shift)
+{
+    const uint32_t end = (uint32_t)address + rows * (wide ? 2u : 1u);
+    if (end > XOCHIP_ADDRESS_SPACE_SIZE)
+    {
+        return NULL;
+    }
+
+    xochip_sprite_cache_t *cache = emulator->sprite_cache;
+    const uint8_t index = (uint8_t)(((address >> 1) ^ (address >> 6) ^ rows) % XOCHIP_SPRITE_CACHE_SIZE);
+    xochip_sprite_entry_t *entry = &cache->entries[index];
+
+    if (entry->rows != rows || entry->address != address || entry->wide != wide)
+    {
+        entry->address = address;
+        entry->rows = rows;
+        entry->wide = wide;
+        entry->shifts = 0;
+
+        for (uint32_t page = address >> 8; page <= ((end - 1) >> 8); ++page)
+        {
+            cache->pages[page >> 3] |= (uint8_t)(1u << (page & 0x7));
+        }
+    }
+
+    if (!(entry->shifts & (1u << shift)))
+    {
+        xochip_shift_sprite(emulator, address, rows, wide, shift, entry->shifted[shift]);
+        entry->shifts |= (uint8_t)(1u << shift);
+    }
+
+    return entry->shifted[shift];
+}
+
+// Draws the sprite at I to every selected plane, wrapping around the edges of the display at its current resolution.
+// Each selected plane reads its own copy of the sprite, one after the other. VF is set when any pixel is turned off.
+static xochip_result_t xochip_op_drw_vx_vy_n(xochip_t *emulator, const xochip_register_t vx, const xochip_register_t vy,
+                                             const uint8_t height)
+{
+    const bool wide = height == 0;
+    const uint8_t rows = wide ? XOCHIP_SPRITE_MAX_ROWS : height;
+    const uint8_t sprite_bytes = wide ? 2 * rows : rows;
+
+    if (emulator->stats)
+    {
+        emulator->stats->draws++;
+    }
+
+    const uint8_t display_width = xochip_display_width(&emulator->display);
+    const uint8_t display_height = xochip_display_height(&emulator->display);
+    const uint8_t x = emulator->registers[vx] & (display_width - 1);
+    const uint8_t y = emulator->registers[vy] & (display_height - 1);
+    const uint8_t column = x >> 3;
+    const uint8_t shift = x & 0x7;
+
+    uint8_t *planes[2] = {emulator->display.back_plane, emulator->display.fore_plane};
+    uint16_t source = emulator->address;
+    uint8_t collision = 0;
+    uint32_t read = 0;
+    uint64_t dirty = 0;
+
+    for (uint8_t plane = 0; plane < 2; ++plane)
+    {
+        if (!(emulator->display.selected_plane & (1u << plane)))
+        {
+            continue;
+        }
+
+        uint8_t scratch[XOCHIP_SPRITE_MAX_ROWS * 3];
+        const uint8_t *shifted =
+            emulator->sprite_cache ? xochip_cached_sprite(emulator, source, rows, wide, shift) : NULL;
+
+        if (!shifted)
+        {
+            xochip_shift_sprite(emulator, source, rows, wide, shift, scratch);
+            shifted = scratch;
+        }
+
+        for (uint8_t row = 0; row < rows; ++row)
+        {
+            const uint8_t line_index = (y + row) & (display_height - 1);
+            uint8_t *line = planes[plane] + line_index * XOCHIP_DISPLAY_ROW_BYTES;
+            dirty |= (uint64_t)1 << line_index;
+
+            for (uint8_t byte = 0; byte < 3; ++byte)
+            {
+                const uint8_t bits = shifted[row * 3 + byte];
+                uint8_t *target = &line[(column + byte) & (display_width / 8 - 1)];
+                collision |= *target & bits;
+                *target ^= bits;
+            }
+        }
+
+        source += sprite_bytes;
+        read += sprite_bytes;
+    }
+
+    xochip_memory_read(emulator, emulator->address, read);
+    emulator->registers[XOCHIP_VF] = collision ? 1 : 0;
+    xochip_display_changed(emulator, dirty);
+    return XOCHIP_SUCCESS;
+}
+
+// There are only 16 keys, anything past them is never pressed
+static inline bool xochip_key_pressed(const xochip_t *emulator, const uint8_t key)
+{
+    return key < XOCHIP_KEYCOUNT && (emulator->pressed_keys >> key & 1u);
+}
+
+static xochip_result_t xochip_op_skp_vx(xochip_t *emulator, const xochip_register_t vx)
+{
+    if (xochip_key_pressed(emulator, emulator->registers[vx]))
+    {
+        xochip_skip(emulator);
+    }
+    return XOCHIP_SUCCESS;
+}
+
+static xochip_result_t xochip_op_skpn_vx(xochip_t *emulator, const xochip_register_t vx)
+{
+    if (!xochip_key_pressed(emulator, emulator->registers[vx]))
+    {
+        xochip_skip(emulator);
+    }
+    return XOCHIP_SUCCESS;
+}
+
+static xochip_result_t xochip_op_ld_vx_dt(xochip_t *emulator, const xochip_register_t vx)
+{
+    emulator->registers[vx] = emulator->registers[XOCHIP_VDELAY];
+    xochip_delay_read(emulator, emulator->counter);
+    return XOCHIP_SUCCESS;
+}
+
+static xochip_result_t xochip_op_ld_vx_k(xochip_t *emulator, const xochip_register_t vx)
+{
+    if (!(emulator->released_keys))
+    {
+        emulator->counter -= XOCHIP_OPCODE_SIZE;
+        xochip_idle(emulator, XOCHIP_IDLE_KEY, emulator->cycles);
+        return XOCHIP_SUCCESS;
+    }
+
+    // we wouldn't get here if emulator->released_keys wasn't 0, therefore, there should always be a set bit
+    emulator->registers[vx] = xochip_find_first_set_bit(emulator->released_keys);
+    return XOCHIP_SUCCESS;
+}
+
+static xochip_result_t xochip_op_ld_dt_vx(xochip_t *emulator, const xochip_register_t vx)
+{
+    emulator->registers[XOCHIP_VDELAY] = emulator->registers[vx];
+    return XOCHIP_SUCCESS;
+}
+
+static xochip_result_t xochip_op_ld_st_vx(xochip_t *emulator, const xochip_register_t vx)
+{
+    emulator->registers[XOCHIP_VSOUND] = emulator->registers[vx];
+    return XOCHIP_SUCCESS;
+}
+
+static xochip_result_t xochip_op_add_i_vx(xochip_t *emulator, const xochip_register_t vx)
+{
+    emulator->address += emulator->registers[vx];
+    return XOCHIP_SUCCESS;
+}
+
+static xochip_result_t xochip_op_ld_f_vx(xochip_t *emulator, const xochip_register_t vx)
+{
+    const uint8_t digit = emulator->registers[vx] & 0xF;
+    emulator->address = digit * XOCHIP_FONT_SIZE;
+    return XOCHIP_SUCCESS;
+}
+
+static xochip_result_t xochip_op_ld_hf_vx(xochip_t *emulator, const xochip_register_t vx)
+{
+    const uint8_t digit = emulator->registers[vx] & 0xF;
+    emulator->address = XOCHIP_BIG_FONT_ADDRESS + digit * XOCHIP_BIG_FONT_SIZE;
+    return XOCHIP_SUCCESS;
+}
+
+static xochip_result_t xochip_op_ld_r_vx(xochip_t *emulator, const xochip_register_t vx)
+{
+    memcpy(emulator->flags, emulator->registers, vx + 1u);
+    return XOCHIP_SUCCESS;
+}
+
+static xochip_result_t xochip_op_ld_vx_r(xochip_t *emulator, const xochip_register_t vx)
+{
+    memcpy(emulator->registers, emulator->flags, vx + 1u);
+    return XOCHIP_SUCCESS;
+}
+
+static xochip_result_t xochip_op_ld_b_vx(xochip_t *emulator, const xochip_register_t vx)
+{
+    const uint8_t value = emulator->registers[vx];
+    const uint8_t digits[3] = {(uint8_t)(value / 100), (uint8_t)(value / 10 % 10), (uint8_t)(value % 10)};
+    return xochip_memory_store(emulator, emulator->address, digits, sizeof(digits));
+}
+
+static xochip_result_t xochip_op_ld_i_vx(xochip_t *emulator, const xochip_register_t vx)
+{
+    const xochip_result_t result = xochip_memory_store(emulator, emulator->address, emulator->registers, vx + 1u);
+    emulator->address = (xochip_address_t)(emulator->address + vx + 1u);
+    return result;
+}
+
+static xochip_result_t xochip_op_ld_vx_i(xochip_t *emulator, const xochip_register_t vx)
+{
+    xochip_memory_read(emulator, emulator->address, vx + 1u);
+    xochip_read_block(emulator, emulator->address, emulator->registers, vx + 1u);
+    emulator->address = (xochip_address_t)(emulator->address + vx + 1u);
+    return XOCHIP_SUCCESS;
+}
+
+// =====================================================================================================================
+//    XO-CHIP EXTENSION OP-CODES
+// =====================================================================================================================
+
+static xochip_result_t xochip_op_save_vx_vy(xochip_t *emulator, const xochip_register_t vx, const xochip_register_t vy)
+{
+    const xochip_register_t start = vx < vy ? vx : vy;
+    const xochip_register_t end = vx < vy ? vy : vx;
+
+    const xochip_result_t result =
+        xochip_memory_store(emulator, emulator->address, emulator->registers + start, end - start + 1u);
+    emulator->address = (xochip_address_t)(emulator->address + end - start + 1u);
+    return result;
+}
+
+static xochip_result_t xochip_op_load_vx_vy(xochip_t *emulator, const xochip_register_t vx, const xochip_register_t vy)
+{
+    const xochip_register_t start = vx < vy ? vx : vy;
+    const xochip_register_t end = vx < vy ? vy : vx;
+
+    xochip_memory_read(emulator, emulator->address, end - start + 1u);
+    xochip_read_block(emulator, emulator->address, emulator->registers + start, end - start + 1u);
+    emulator->address = (xochip_address_t)(emulator->address + end - start + 1u);
+    return XOCHIP_SUCCESS;
+}
+
+static xochip_result_t xochip_op_ld_i_long(xochip_t *emulator, const xochip_address_t addr)
+{
+    emulator->address = addr;
+    return XOCHIP_SUCCESS;
+}
+
+static xochip_result_t xochip_op_plane(xochip_t *emulator, const uint8_t plane)
+{
+    emulator->display.selected_plane = plane;
+    return XOCHIP_SUCCESS;
+}
+
+static xochip_result_t xochip_op_audio(xochip_t *emulator)
+{
+    xochip_read_block(emulator, emulator->address, emulator->audio, sizeof(emulator->audio));
+    xochip_memory_read(emulator, emulator->address, sizeof(emulator->audio));
+    return XOCHIP_SUCCESS;
+}
+
+static xochip_result_t xochip_op_pitch(xochip_t *emulator, const xochip_register_t vx)
+{
+    emulator->registers[XOCHIP_VPITCH] = emulator->registers[vx];
+    return XOCHIP_SUCCESS;
+}
+
+// =====================================================================================================================
+//    API IMPLEMENTATIONS
+// =====================================================================================================================
+xochip_result_t xochip_init(xochip_t *emulator)
+{
+    if (!emulator)
+    {
+        return XOCHIP_ERR_NULL_POINTER;
+    }
+
+    // attachments survive xochip_reset, so they're only cleared here
+    emulator->debugger = NULL;
+    emulator->debugging = false;
+    emulator->decode_cache = NULL;
+    emulator->sprite_cache = NULL;
+    emulator->hash = NULL;
+    emulator->costs = NULL;
+    emulator->stats = NULL;
+
+    // memory could hold anything, so the first reset clears all of it
+    memset(emulator->dirty_pages, 0xFF, sizeof(emulator->dirty_pages));
+
+    return xochip_reset(emulator);
+}
+
+xochip_result_t xochip_reset(xochip_t *emulator)
+{
+    if (!emulator)
+    {
+        return XOCHIP_ERR_NULL_POINTER;
+    }
+
+    emulator->counter = XOCHIP_ADDRESS_SPACE_START;
+    emulator->address = 0;
+    emulator->pressed_keys = 0;
+    emulator->released_keys = 0;
+    emulator->stack.counter = 0;
+
+    xochip_clear_memory(emulator);
+    memset(emulator->registers, 0, sizeof(emulator->registers));
+    memset(emulator->flags, 0, sizeof(emulator->flags));
+    memset(emulator->stack.addresses, 0, sizeof(emulator->stack.addresses));
+    memset(emulator->audio, 0, sizeof(emulator->audio));
+    memset(emulator->display.back_plane, 0, sizeof(emulator->display.back_plane));
+    memset(emulator->display.fore_plane, 0, sizeof(emulator->display.fore_plane));
+    emulator->display.selected_plane = 0x1;
+    emulator->display.hires = false;
+    xochip_display_changed(emulator, UINT64_MAX);
+    emulator->random = XOCHIP_RANDOM_SEED;
+    emulator->cycles = 0;
+
+    return XOCHIP_SUCCESS;
+}
+
+xochip_result_t xochip_load_rom(xochip_t *emulator, const uint8_t *data, size_t size)
+{
+    if (!emulator || (!data && size > 0))
+    {
+        return XOCHIP_ERR_NULL_POINTER;
+    }
+
+    if (size > XOCHIP_ROM_SIZE_MAX)
+    {
+        return XOCHIP_ERR_ROM_TOO_LARGE;
+    }
+
+    xochip_clear_memory(emulator);
+#ifdef XOCHIP_XIP
+    emulator->rom = data;
+    emulator->rom_size = (uint32_t)size;
+#else
+    memcpy(emulator->memory + XOCHIP_ADDRESS_SPACE_START, data, size);
+#endif
+    xochip_memory_loaded(emulator, XOCHIP_ADDRESS_SPACE_START, (uint32_t)size);
+    return XOCHIP_SUCCESS;
+}
+
+xochip_result_t xochip_load_rom_reader(xochip_t *emulator, xochip_reader_t reader, void *context)
+{
+    if (!emulator || !reader)
+    {
+        return XOCHIP_ERR_NULL_POINTER;
+    }
+
+    xochip_clear_memory(emulator);
+
+#ifdef XOCHIP_XIP
+    // there's no memory[] to read into, each page is read on the stack and written like the ROM would
+    uint32_t address = XOCHIP_ADDRESS_SPACE_START;
+    while (address < XOCHIP_ADDRESS_SPACE_SIZE)
+    {
+        uint8_t chunk[XOCHIP_PAGE_SIZE];
+        const size_t size = XOCHIP_PAGE_SIZE - address % XOCHIP_PAGE_SIZE;
+        const size_t read = reader(context, chunk, size);
+        if (read == XOCHIP_READ_ERROR)
+        {
+            return XOCHIP_ERR_READ;
+        }
+        if (read == 0)
+        {
+            return XOCHIP_SUCCESS;
+        }
+        if (read > size)
+        {
+            return XOCHIP_ERR_ROM_TOO_LARGE;
+        }
+
+        const uint32_t written = xochip_write_block(emulator, address, chunk, (uint32_t)read);
+        xochip_memory_loaded(emulator, address, written);
+        if (written < read)
+        {
+            return XOCHIP_ERR_OUT_OF_PAGES;
+        }
+        address += (uint32_t)read;
+    }
+#else
+    uint8_t *destination = emulator->memory + XOCHIP_ADDRESS_SPACE_START;
+    size_t remaining = XOCHIP_ROM_SIZE_MAX;
+
+    while (remaining > 0)
+    {
+        const size_t read = reader(context, destination, remaining);
+        if (read == XOCHIP_READ_ERROR)
+        {
+            return XOCHIP_ERR_READ;
+        }
+
+        if (read == 0)
+        {
+            return XOCHIP_SUCCESS;
+        }
+
+        if (read > remaining)
+        {
+            // the reader ignored size, and already wrote past the end
+            xochip_memory_loaded(emulator, (uint32_t)(destination - emulator->memory), (uint32_t)remaining);
+            return XOCHIP_ERR_ROM_TOO_LARGE;
+        }
+
+        xochip_memory_loaded(emulator, (uint32_t)(destination - emulator->memory), (uint32_t)read);
+        destination += read;
+        remaining -= read;
+    }
+#endif
+
+    // memory is full, the ROM only fits if the reader is done too
+    uint8_t extra = 0;
+    const size_t read = reader(context, &extra, 1);
+    if (read == XOCHIP_READ_ERROR)
+    {
+        return XOCHIP_ERR_READ;
+    }
+
+    return read == 0 ? XOCHIP_SUCCESS : XOCHIP_ERR_ROM_TOO_LARGE;
+}
+
+xochip_result_t xochip_write_rom(xochip_t *emulator, const uint8_t *data, size_t size, uint16_t address)
+{
+    if (!emulator || !data)
+    {
+        return XOCHIP_ERR_NULL_POINTER;
+    }
+
+    if (size > XOCHIP_ADDRESS_SPACE_SIZE)
+    {
+        return XOCHIP_ERR_ROM_TOO_LARGE;
+    }
+
+    if ((address + size) > XOCHIP_ADDRESS_SPACE_SIZE)
+    {
+        return XOCHIP_ERR_ADDRESS_OVERFLOW;
+    }
+
+#ifdef XOCHIP_XIP
+    const uint32_t written = xochip_write_block(emulator, address, data, (uint32_t)size);
+#else
+    memcpy(emulator->memory + address, data, size);
+    const uint32_t written = (uint32_t)size;
+#endif
+    xochip_memory_loaded(emulator, address, written);
+    return written == size ? XOCHIP_SUCCESS : XOCHIP_ERR_OUT_OF_PAGES;
+}
+
+xochip_op_t xochip_decode(const uint16_t opcode)
+{
+    switch (OPCODE_N1(opcode))
+    {
+    case 0x0:
+        if ((opcode & 0xFFF0) == 0x00C0)
+        {
+            return XOCHIP_OP_SCD_N;
+        }
+
+        if ((opcode & 0xFFF0) == 0x00D0)
+        {
+            return XOCHIP_OP_SCU_N;
+        }
+
+        switch (opcode)
+        {
+        case 0x00E0:
+            return XOCHIP_OP_CLS;
+        case 0x00EE:
+            return XOCHIP_OP_RET;
+        case 0x00FB:
+            return XOCHIP_OP_SCR;
+        case 0x00FC:
+            return XOCHIP_OP_SCL;
+        case 0x00FD:
+            return XOCHIP_OP_EXIT;
+        case 0x00FE:
+            return XOCHIP_OP_LOW;
+        case 0x00FF:
+            return XOCHIP_OP_HIGH;
+        default:
+            return XOCHIP_OP_SYS;
+        }
+    case 0x1:
+        return XOCHIP_OP_JP_ADDR;
+    case 0x2:
+        return XOCHIP_OP_CALL;
+    case 0x3:
+        return XOCHIP_OP_SE_VX_BYTE;
+    case 0x4:
+        return XOCHIP_OP_SNE_VX_BYTE;
+    case 0x5:
+        switch (OPCODE_N(opcode))
+        {
+        case 0x0:
+            return XOCHIP_OP_SE_VX_VY;
+        case 0x2:
+            return XOCHIP_OP_SAVE_VX_VY;
+        case 0x3:
+            return XOCHIP_OP_LOAD_VX_VY;
+        default:
+            return XOCHIP_OP_INVALID;
+        }
+    case 0x6:
+        return XOCHIP_OP_LD_VX_BYTE;
+    case 0x7:
+        return XOCHIP_OP_ADD_VX_BYTE;
+    case 0x8:
+        switch (OPCODE_N(opcode))
+        {
+        case 0x0:
+            return XOCHIP_OP_LD_VX_VY;
+        case 0x1:
+            return XOCHIP_OP_OR_VX_VY;
+        case 0x2:
+            return XOCHIP_OP_AND_VX_VY;
+        case 0x3:
+            return XOCHIP_OP_XOR_VX_VY;
+        case 0x4:
+            return XOCHIP_OP_ADD_VX_VY;
+        case 0x5:
+            return XOCHIP_OP_SUB_VX_VY;
+        case 0x6:
+            return XOCHIP_OP_SHR_VX_VY;
+        case 0x7:
+            return XOCHIP_OP_SUBN_VX_VY;
+        case 0xE:
+            return XOCHIP_OP_SHL_VX_VY;
+        default:
+            return XOCHIP_OP_INVALID;
+        }
+    case 0x9:
+        return XOCHIP_OP_SNE_VX_VY;
+    case 0xA:
+        return XOCHIP_OP_LD_I_ADDR;
+    case 0xB:
+        return XOCHIP_OP_JP_V0_ADDR;
+    case 0xC:
+        return XOCHIP_OP_RND_VX_BYTE;
+    case 0xD:
+        return OPCODE_N(opcode) == 0 ? XOCHIP_OP_DRW_VX_VY_0 : XOCHIP_OP_DRW_VX_VY_N;
+    case 0xE:
+        switch (OPCODE_KK(opcode))
+        {
+        case 0x9E:
+            return XOCHIP_OP_SKP_VX;
+        case 0xA1:
+            return XOCHIP_OP_SKNP_VX;
+        default:
+            return XOCHIP_OP_INVALID;
+        }
+    case 0xF:
+        if (opcode == 0xF000)
+        {
+            return XOCHIP_OP_LD_I_LONG;
+        }
+
+        switch (OPCODE_KK(opcode))
+        {
+        case 0x01:
+            return XOCHIP_OP_PLANE;
+        case 0x02:
+            return XOCHIP_OP_AUDIO;
+        case 0x07:
+            return XOCHIP_OP_LD_VX_DT;
+        case 0x0A:
+            return XOCHIP_OP_LD_VX_K;
+        case 0x15:
+            return XOCHIP_OP_LD_DT_VX;
+        case 0x18:
+            return XOCHIP_OP_LD_ST_VX;
+        case 0x1E:
+            return XOCHIP_OP_ADD_I_VX;
+        case 0x29:
+            return XOCHIP_OP_LD_F_VX;
+        case 0x30:
+            return XOCHIP_OP_LD_HF_VX;
+        case 0x33:
+            return XOCHIP_OP_LD_B_VX;
+        case 0x3A:
+            return XOCHIP_OP_LD_PITCH_VX;
+        case 0x55:
+            return XOCHIP_OP_LD_I_VX;
+        case 0x65:
+            return XOCHIP_OP_LD_VX_I;
+        case 0x75:
+            return XOCHIP_OP_LD_R_VX;
+        case 0x85:
+            return XOCHIP_OP_LD_VX_R;
+        default:
+            return XOCHIP_OP_INVALID;
+        }
+    default:
+        return XOCHIP_OP_INVALID;
+    }
+}
+
+uint8_t xochip_op_size(const xochip_op_t op)
+{
+    return op == XOCHIP_OP_LD_I_LONG ? 2 * XOCHIP_OPCODE_SIZE : XOCHIP_OPCODE_SIZE;
+}
+
+const char *xochip_op_name(const xochip_op_t op)
+{
+    static const char *names[XOCHIP_OP_COUNT] = {
+        "SYS",
+        "CLS",
+        "RET",
+        "JP_ADDR",
+        "CALL",
+        "SE_VX_BYTE",
+        "SNE_VX_BYTE",
+        "SE_VX_VY",
+        "LD_VX_BYTE",
+        "ADD_VX_BYTE",
+        "LD_VX_VY",
+        "OR_VX_VY",
+        "AND_VX_VY",
+        "XOR_VX_VY",
+        "ADD_VX_VY",
+        "SUB_VX_VY",
+        "SHR_VX_VY",
+        "SUBN_VX_VY",
+        "SHL_VX_VY",
+        "SNE_VX_VY",
+        "LD_I_ADDR",
+        "JP_V0_ADDR",
+        "RND_VX_BYTE",
+        "DRW_VX_VY_N",
+        "SKP_VX",
+        "SKNP_VX",
+        "LD_VX_DT",
+        "LD_VX_K",
+        "LD_DT_VX",
+        "LD_ST_VX",
+        "ADD_I_VX",
+        "LD_F_VX",
+        "LD_B_VX",
+        "LD_I_VX",
+        "LD_VX_I",
+        "SCD_N",
+        "SCR",
+        "SCL",
+        "EXIT",
+        "LOW",
+        "HIGH",
+        "DRW_VX_VY_0",
+        "LD_HF_VX",
+        "LD_R_VX",
+        "LD_VX_R",
+        "SAVE_VX_VY",
+        "LOAD_VX_VY",
+        "LD_I_LONG",
+        "PLANE",
+        "AUDIO",
+        "LD_PITCH_VX",
+        "SCU_N",
+        "INVALID",
+    };
+
+    return op < XOCHIP_OP_COUNT ? names[op] : "INVALID";
+}
+
+// What an instruction costs according to a cost table, never 0
+static uint32_t xochip_cost(const xochip_cost_table_t *costs, const uint16_t instruction, const xochip_op_t op)
+{
+    uint32_t cost = costs->ops[op];
+
+    switch (op)
+    {
+    case XOCHIP_OP_DRW_VX_VY_N:
+        cost += (uint32_t)costs->sprite_row * OPCODE_N(instruction);
+        break;
+    case XOCHIP_OP_DRW_VX_VY_0:
+        cost += (uint32_t)costs->sprite_row * XOCHIP_SPRITE_MAX_ROWS;
+        break;
+    case XOCHIP_OP_LD_I_VX:
+    case XOCHIP_OP_LD_VX_I:
+        cost += (uint32_t)costs->register_copy * (OPCODE_X(instruction) + 1u);
+        break;
+    case XOCHIP_OP_SAVE_VX_VY:
+    case XOCHIP_OP_LOAD_VX_VY:
+    {
+        const uint8_t vx = OPCODE_X(instruction);
+        const uint8_t vy = OPCODE_Y(instruction);
+        cost += (uint32_t)costs->register_copy * ((vx < vy ? vy - vx : vx - vy) + 1u);
+        break;
+    }
+    default:
+        break;
+    }
+
+    return cost ? cost : 1;
+}
+
+// Runs a single decoded instruction, the counter must already point past it
+static xochip_result_t xochip_execute(xochip_t *emulator, const uint16_t next_instruction, const xochip_op_t op)
+{
+    const xochip_register_t vx = OPCODE_X(next_instruction);
+    const xochip_register_t vy = OPCODE_Y(next_instruction);
+    const uint8_t byte = OPCODE_KK(next_instruction);
+    const uint16_t address = OPCODE_NNN(next_instruction);
+
+    xochip_result_t result = XOCHIP_SUCCESS;
+    emulator->cycles += emulator->costs ? xochip_cost(emulator->costs, next_instruction, op) : 1;
+
+    switch (op)
+    {
+    case XOCHIP_OP_SYS:
+        // this is a SYS command which we don't handle
+        break;
+    case XOCHIP_OP_CLS:
+        result = xochip_op_cls(emulator);
+        break;
+    case XOCHIP_OP_RET:
+        result = xochip_op_ret(emulator);
+        break;
+    case XOCHIP_OP_JP_ADDR:
+        result = xochip_op_jp_addr(emulator, address);
+        break;
+    case XOCHIP_OP_CALL:
+        result = xochip_op_call(emulator, address);
+        break;
+    case XOCHIP_OP_SE_VX_BYTE:
+        result = xochip_op_se_vx_b(emulator, vx, byte);
+        break;
+    case XOCHIP_OP_SNE_VX_BYTE:
+        result = xochip_op_sne_vx_b(emulator, vx, byte);
+        break;
+    case XOCHIP_OP_SE_VX_VY:
+        result = xochip_op_se_vx_vy(emulator, vx, vy);
+        break;
+    case XOCHIP_OP_LD_VX_BYTE:
+        result = xochip_op_ld_vx_b(emulator, vx, byte);
+        break;
+    case XOCHIP_OP_ADD_VX_BYTE:
+        result = xochip_op_add_vx_b(emulator, vx, byte);
+        break;
+    case XOCHIP_OP_LD_VX_VY:
+        result = xochip_op_ld_vx_vy(emulator, vx, vy);
+        break;
+    case XOCHIP_OP_OR_VX_VY:
+        result = xochip_op_or_xv_vy(emulator, vx, vy);
+        break;
+    case XOCHIP_OP_AND_VX_VY:
+        result = xochip_op_and_xv_vy(emulator, vx, vy);
+        break;
+    case XOCHIP_OP_XOR_VX_VY:
+        result = xochip_op_xor_xv_vy(emulator, vx, vy);
+        break;
+    case XOCHIP_OP_ADD_VX_VY:
+        result = xochip_op_add_xv_vy(emulator, vx, vy);
+        break;
+    case XOCHIP_OP_SUB_VX_VY:
+        result = xochip_op_sub_xv_vy(emulator, vx, vy);
+        break;
+    case XOCHIP_OP_SHR_VX_VY:
+        result = xochip_op_shr_xv_vy(emulator, vx, vy);
+        break;
+    case XOCHIP_OP_SUBN_VX_VY:
+        result = xochip_op_subn_xv_vy(emulator, vx, vy);
+        break;
+    case XOCHIP_OP_SHL_VX_VY:
+        result = xochip_op_shl_xv_vy(emulator, vx, vy);
+        break;
+    case XOCHIP_OP_SNE_VX_VY:
+        result = xochip_op_sne_xv_vy(emulator, vx, vy);
+        break;
+    case XOCHIP_OP_LD_I_ADDR:
+        result = xochip_op_ld_i(emulator, address);
+        break;
+    case XOCHIP_OP_JP_V0_ADDR:
+        result = xochip_op_jp_v0_addr(emulator, address);
+        break;
+    case XOCHIP_OP_RND_VX_BYTE:
+        result = xochip_op_rnd_vx_b(emulator, vx, byte);
+        break;
+    case XOCHIP_OP_DRW_VX_VY_N:
+    case XOCHIP_OP_DRW_VX_VY_0:
+        result = xochip_op_drw_vx_vy_n(emulator, vx, vy, OPCODE_N(next_instruction));
+        break;
+    case XOCHIP_OP_SKP_VX:
+        result = xochip_op_skp_vx(emulator, vx);
+        break;
+    case XOCHIP_OP_SKNP_VX:
+        result = xochip_op_skpn_vx(emulator, vx);
+        break;
+    case XOCHIP_OP_LD_VX_DT:
+        result = xochip_op_ld_vx_dt(emulator, vx);
+        break;
+    case XOCHIP_OP_LD_VX_K:
+        result = xochip_op_ld_vx_k(emulator, vx);
+        break;
+    case XOCHIP_OP_LD_DT_VX:
+        result = xochip_op_ld_dt_vx(emulator, vx);
+        break;
+    case XOCHIP_OP_LD_ST_VX:
+        result = xochip_op_ld_st_vx(emulator, vx);
+        break;
+    case XOCHIP_OP_ADD_I_VX:
+        result = xochip_op_add_i_vx(emulator, vx);
+        break;
+    case XOCHIP_OP_LD_F_VX:
+        result = xochip_op_ld_f_vx(emulator, vx);
+        break;
+    case XOCHIP_OP_LD_B_VX:
+        result = xochip_op_ld_b_vx(emulator, vx);
+        break;
+    case XOCHIP_OP_LD_I_VX:
+        result = xochip_op_ld_i_vx(emulator, vx);
+        break;
+    case XOCHIP_OP_LD_VX_I:
+        result = xochip_op_ld_vx_i(emulator, vx);
+        break;
+    case XOCHIP_OP_LD_HF_VX:
+        result = xochip_op_ld_hf_vx(emulator, vx);
+        break;
+    case XOCHIP_OP_LD_R_VX:
+        result = xochip_op_ld_r_vx(emulator, vx);
+        break;
+    case XOCHIP_OP_LD_VX_R:
+        result = xochip_op_ld_vx_r(emulator, vx);
+        break;
+    case XOCHIP_OP_SCD_N:
+        result = xochip_op_scd(emulator, OPCODE_N(next_instruction));
+        break;
+    case XOCHIP_OP_SCU_N:
+        result = xochip_op_scu(emulator, OPCODE_N(next_instruction));
+        break;
+    case XOCHIP_OP_SCR:
+        result = xochip_op_scroll_horizontal(emulator, true);
+        break;
+    case XOCHIP_OP_SCL:
+        result = xochip_op_scroll_horizontal(emulator, false);
+        break;
+    case XOCHIP_OP_EXIT:
+        // stay on 00FD, so every cycle after this one exits again
+        emulator->counter -= XOCHIP_OPCODE_SIZE;
+        result = XOCHIP_EXITED;
+        break;
+    case XOCHIP_OP_LOW:
+        result = xochip_op_resolution(emulator, false);
+        break;
+    case XOCHIP_OP_HIGH:
+        result = xochip_op_resolution(emulator, true);
+        break;
+    case XOCHIP_OP_SAVE_VX_VY:
+        result = xochip_op_save_vx_vy(emulator, vx, vy);
+        break;
+    case XOCHIP_OP_LOAD_VX_VY:
+        result = xochip_op_load_vx_vy(emulator, vx, vy);
+        break;
+    case XOCHIP_OP_LD_I_LONG:
+    {
+        // the address is the next 2 bytes, which the counter is already pointing at
+        const uint16_t long_address = xochip_fetch(emulator, emulator->counter);
+        emulator->counter += XOCHIP_OPCODE_SIZE;
+        result = xochip_op_ld_i_long(emulator, long_address);
+        break;
+    }
+    case XOCHIP_OP_PLANE:
+        result = xochip_op_plane(emulator, vx);
+        break;
+    case XOCHIP_OP_AUDIO:
+        result = xochip_op_audio(emulator);
+        break;
+    case XOCHIP_OP_LD_PITCH_VX:
+        result = xochip_op_pitch(emulator, vx);
+        break;
+    case XOCHIP_OP_INVALID:
+    default:
+        result = XOCHIP_ERR_INVALID_INSTRUCTION;
+        break;
+    }
+
+    return result;
+}
+
+// This trusts your emulator pointer is not null
+xochip_result_t xochip_cycle(xochip_t *emulator)
+{
+    if (emulator->debugging)
+    {
+        xochip_debugger_t *debugger = emulator->debugger;
+        const bool resuming =
+            debugger->stop_reason == XOCHIP_STOP_BREAKPOINT && debugger->stop_address == emulator->counter;
+
+        debugger->stop_reason = XOCHIP_STOP_NONE;
+        if (!resuming && XOCHIP_BITMAP_TEST(debugger->breakpoints, emulator->counter))
+        {
+            debugger->stop_reason = XOCHIP_STOP_BREAKPOINT;
+            debugger->stop_address = emulator->counter;
+            return XOCHIP_STOPPED;
+        }
+    }
+
+    const uint16_t next_instruction = xochip_fetch(emulator, emulator->counter);
+    emulator->counter += XOCHIP_OPCODE_SIZE;
+
+    xochip_result_t result = xochip_execute(emulator, next_instruction, xochip_decode(next_instruction));
+
+    emulator->released_keys = 0;
+
+    if (emulator->debugging && result == XOCHIP_SUCCESS && emulator->debugger->stop_reason != XOCHIP_STOP_NONE)
+    {
+        result = XOCHIP_STOPPED;
+    }
+
+    return result;
+}
+
+// Recognizes the instruction sequences that have a fused handler, see xochip_fused_t
+static void xochip_predecode(const xochip_t *emulator, const uint16_t pc, xochip_decoded_t *entry)
+{
+    const uint16_t first = xochip_fetch(emulator, pc);
+    const uint16_t second = xochip_fetch(emulator, (uint16_t)(pc + XOCHIP_OPCODE_SIZE));
+    const xochip_op_t op = xochip_decode(first);
+
+    entry->opcode = first;
+    entry->handler = (uint8_t)op;
+    entry->length = 1;
+
+    switch (op)
+    {
+    case XOCHIP_OP_SE_VX_BYTE:
+    case XOCHIP_OP_SNE_VX_BYTE:
+        if (xochip_decode(second) == XOCHIP_OP_JP_ADDR)
+        {
+            entry->handler = XOCHIP_FUSED_SKIP_JP;
+            entry->length = 2;
+        }
+        break;
+    case XOCHIP_OP_LD_I_ADDR:
+        if (xochip_decode(second) == XOCHIP_OP_DRW_VX_VY_N || xochip_decode(second) == XOCHIP_OP_DRW_VX_VY_0)
+        {
+            entry->handler = XOCHIP_FUSED_LD_I_DRW;
+            entry->length = 2;
+        }
+        break;
+    case XOCHIP_OP_LD_VX_BYTE:
+    {
+        uint8_t length = 1;
+        while (length < XOCHIP_FUSED_MAX_LENGTH &&
+               xochip_decode(xochip_fetch(emulator, (uint16_t)(pc + length * XOCHIP_OPCODE_SIZE))) ==
+                   XOCHIP_OP_LD_VX_BYTE)
+        {
+            length++;
+        }
+
+        if (length > 1)
+        {
+            entry->handler = XOCHIP_FUSED_LD_VX_RUN;
+            entry->length = length;
+        }
+        break;
+    }
+    case XOCHIP_OP_LD_VX_DT:
+    {
+        // Fx07, 3x00, 1nnn back to the Fx07: spin until the delay timer runs out
+        const uint16_t third = xochip_fetch(emulator, (uint16_t)(pc + 2 * XOCHIP_OPCODE_SIZE));
+        if (second == (0x3000 | (OPCODE_X(first) << 8)) && xochip_decode(third) == XOCHIP_OP_JP_ADDR &&
+            OPCODE_NNN(third) == pc)
+        {
+            entry->handler = XOCHIP_FUSED_DELAY_LOOP;
+            entry->length = 3;
+        }
+        break;
+    }
+    default:
         break;
     }
-    case 0x2:
+}
+
+// Runs the fused handler in entry, the counter still points at its first instruction. Each handler does exactly what
+// the individual instructions would, and reports how many of them it ran.
+static xochip_result_t xochip_execute_fused(xochip_t *emulator, const xochip_decoded_t *entry, const uint32_t budget,
+                                            uint32_t *executed)
+{
+    const uint16_t pc = emulator->counter;
+    const uint16_t first = entry->opcode;
+
+    switch (entry->handler)
+    {
+    case XOCHIP_FUSED_SKIP_JP:
+    {
+        const bool equal = emulator->registers[OPCODE_X(first)] == OPCODE_KK(first);
+        const bool skip = OPCODE_N1(first) == 0x3 ? equal : !equal;
+
+        // skipping the 2 byte jump means only the skip ran
+        if (skip)
+        {
+            emulator->counter = (uint16_t)(pc + 2 * XOCHIP_OPCODE_SIZE);
+            *executed = 1;
+            return XOCHIP_SUCCESS;
+        }
+
+        const uint16_t jump = xochip_fetch(emulator, (uint16_t)(pc + XOCHIP_OPCODE_SIZE));
+        emulator->counter = (uint16_t)(pc + 2 * XOCHIP_OPCODE_SIZE);
+        *executed = 2;
+        return xochip_op_jp_addr(emulator, OPCODE_NNN(jump));
+    }
+    case XOCHIP_FUSED_LD_I_DRW:
+    {
+        const uint16_t draw = xochip_fetch(emulator, (uint16_t)(pc + XOCHIP_OPCODE_SIZE));
+        emulator->address = OPCODE_NNN(first);
+        emulator->counter = (uint16_t)(pc + 2 * XOCHIP_OPCODE_SIZE);
+        *executed = 2;
+        return xochip_op_drw_vx_vy_n(emulator, OPCODE_X(draw), OPCODE_Y(draw), OPCODE_N(draw));
+    }
+    case XOCHIP_FUSED_LD_VX_RUN:
+    {
+        for (uint8_t index = 0; index < entry->length; ++index)
+        {
+            const uint16_t load = xochip_fetch(emulator, (uint16_t)(pc + index * XOCHIP_OPCODE_SIZE));
+            emulator->registers[OPCODE_X(load)] = OPCODE_KK(load);
+        }
+        emulator->counter = (uint16_t)(pc + entry->length * XOCHIP_OPCODE_SIZE);
+        *executed = entry->length;
+        return XOCHIP_SUCCESS;
+    }
+    case XOCHIP_FUSED_DELAY_LOOP:
+    {
+        const uint8_t delay = emulator->registers[XOCHIP_VDELAY];
+        emulator->registers[OPCODE_X(first)] = delay;
+        xochip_delay_read(emulator, (uint16_t)(pc + XOCHIP_OPCODE_SIZE));
+        if (delay != 0)
+        {
+            // it goes around until the frame is over
+            xochip_idle(emulator, XOCHIP_IDLE_DELAY, emulator->cycles);
+        }
+
+        // the timer ran out, Fx07 and 3x00 run and the jump is skipped
+        if (delay == 0)
+        {
+            emulator->counter = (uint16_t)(pc + 3 * XOCHIP_OPCODE_SIZE);
+            *executed = 2;
+            return XOCHIP_SUCCESS;
+        }
+
+        // nothing changes the delay timer until the next xochip_tick, so every full trip around the loop is the same
+        emulator->counter = pc;
+        *executed = (budget / 3) * 3;
+        return XOCHIP_SUCCESS;
+    }
+    default:
+        *executed = 0;
+        return XOCHIP_ERR_INVALID_INSTRUCTION;
+    }
+}
+
+xochip_result_t xochip_run(xochip_t *emulator, const uint32_t cycles, uint32_t *executed)
+{
+    uint32_t count = 0;
+    xochip_result_t result = XOCHIP_SUCCESS;
+
+    // breakpoints and watchpoints need to see every instruction on its own
+    if (!emulator->decode_cache || emulator->debugging)
+    {
+        while (count < cycles && result == XOCHIP_SUCCESS)
+        {
+            result = xochip_cycle(emulator);
+            count += result == XOCHIP_STOPPED && emulator->debugger->stop_reason == XOCHIP_STOP_BREAKPOINT ? 0 : 1;
+        }
+
+        if (executed)
+        {
+            *executed = count;
+        }
+        return result;
+    }
+
+    xochip_decoded_t *entries = emulator->decode_cache->entries;
+
+    while (count < cycles && result == XOCHIP_SUCCESS)
+    {
+        const uint16_t pc = emulator->counter;
+        xochip_decoded_t *entry = &entries[pc];
+
+        if (entry->handler == XOCHIP_DECODE_EMPTY)
+        {
+            xochip_predecode(emulator, pc, entry);
+        }
+
+        // fused handlers that don't fit in what's left of the budget run one instruction at a time, and so does
+        // everything when each instruction has to be costed
+        if (entry->handler < XOCHIP_OP_COUNT)
+        {
+            emulator->counter += XOCHIP_OPCODE_SIZE;
+            result = xochip_execute(emulator, entry->opcode, (xochip_op_t)entry->handler);
+            count++;
+        }
+        else if (entry->length > cycles - count || emulator->costs)
+        {
+            // a fused entry only keeps what its first instruction is through its opcode
+            emulator->counter += XOCHIP_OPCODE_SIZE;
+            result = xochip_execute(emulator, entry->opcode, xochip_decode(entry->opcode));
+            count++;
+        }
+        else
+        {
+            uint32_t fused = 0;
+            result = xochip_execute_fused(emulator, entry, cycles - count, &fused);
+            count += fused;
+            emulator->cycles += fused;
+        }
+
+        emulator->released_keys = 0;
+    }
+
+    if (executed)
+    {
+        *executed = count;
+    }
+    return result;
+}
+
+void xochip_tick(xochip_t *emulator)
+{
+    if (emulator->registers[XOCHIP_VSOUND] > 0)
+    {
+        emulator->registers[XOCHIP_VSOUND]--;
+    }
+
+    if (emulator->registers[XOCHIP_VDELAY] > 0)
+    {
+        emulator->registers[XOCHIP_VDELAY]--;
+    }
+}
+
+xochip_result_t xochip_scheduler_init(xochip_scheduler_t *scheduler, const uint32_t cycles_per_tick,
+                                      const uint32_t audio_period)
+{
+    if (!scheduler)
+    {
+        return XOCHIP_ERR_NULL_POINTER;
+    }
+
+    if (cycles_per_tick == 0)
+    {
+        return XOCHIP_ERR_INVALID_ARGUMENT;
+    }
+
+    memset(scheduler, 0, sizeof(*scheduler));
+    scheduler->cycles_per_tick = cycles_per_tick;
+    scheduler->audio_period = audio_period;
+    return XOCHIP_SUCCESS;
+}
+
+xochip_result_t xochip_run_budget(xochip_t *emulator, xochip_scheduler_t *scheduler, const uint32_t budget,
+                                  uint32_t *consumed, xochip_yield_t *reason)
+{
+    if (!emulator || !scheduler)
+    {
+        return XOCHIP_ERR_NULL_POINTER;
+    }
+
+    uint32_t spent = 0;
+    xochip_result_t result = XOCHIP_SUCCESS;
+    xochip_yield_t yield = XOCHIP_YIELD_BUDGET;
+
+    while (spent < budget)
+    {
+        // run up to whichever boundary is closest, so xochip_run can batch everything in between
+        uint32_t chunk = budget - spent;
+        const uint32_t to_tick = scheduler->cycles_per_tick - scheduler->tick_phase;
+        chunk = to_tick < chunk ? to_tick : chunk;
+        if (scheduler->audio_period)
+        {
+            const uint32_t to_audio = scheduler->audio_period - scheduler->audio_phase;
+            chunk = to_audio < chunk ? to_audio : chunk;
+        }
+
+        // with a cost table the cost of an instruction isn't known up front, so step until the chunk is spent
+        const uint64_t before = emulator->cycles;
+        result = xochip_run(emulator, emulator->costs ? 1 : chunk, NULL);
+        const uint32_t executed = (uint32_t)(emulator->cycles - before);
+
+        spent += executed;
+        scheduler->cycles += executed;
+        scheduler->tick_phase += executed;
+        scheduler->audio_phase += executed;
+
+        if (result != XOCHIP_SUCCESS)
+        {
+            break;
+        }
+
+        if (scheduler->tick_phase >= scheduler->cycles_per_tick)
+        {
+            // one expensive instruction can span several ticks
+            while (scheduler->tick_phase >= scheduler->cycles_per_tick)
+            {
+                scheduler->tick_phase -= scheduler->cycles_per_tick;
+                scheduler->ticks++;
+                xochip_tick(emulator);
+            }
+
+            if (emulator->display.updated)
+            {
+                emulator->display.updated = false;
+                yield = XOCHIP_YIELD_FRAME;
+                break;
+            }
+        }
+
+        if (scheduler->audio_period && scheduler->audio_phase >= scheduler->audio_period)
+        {
+            scheduler->audio_phase %= scheduler->audio_period;
+            yield = XOCHIP_YIELD_AUDIO;
+            break;
+        }
+    }
+
+    if (consumed)
+    {
+        *consumed = spent;
+    }
+    if (reason)
+    {
+        *reason = yield;
+    }
+    return result;
+}
+
+xochip_result_t xochip_set_costs(xochip_t *emulator, const xochip_cost_table_t *costs)
+{
+    if (!emulator)
+    {
+        return XOCHIP_ERR_NULL_POINTER;
+    }
+
+    emulator->costs = costs;
+    return XOCHIP_SUCCESS;
+}
+
+const xochip_cost_table_t *xochip_cost_preset(const xochip_cost_preset_t preset)
+{
+    // Microseconds per instruction on the VIP's interpreter. Dxyn waits on the display and grows with the sprite, and
+    // everything the VIP doesn't have is left at the minimum.
+    static const xochip_cost_table_t vip = {
+        .ops =
+            {
+                [XOCHIP_OP_SYS] = 105,         [XOCHIP_OP_CLS] = 109,         [XOCHIP_OP_RET] = 105,
+                [XOCHIP_OP_JP_ADDR] = 105,     [XOCHIP_OP_CALL] = 105,        [XOCHIP_OP_SE_VX_BYTE] = 55,
+                [XOCHIP_OP_SNE_VX_BYTE] = 55,  [XOCHIP_OP_SE_VX_VY] = 73,     [XOCHIP_OP_LD_VX_BYTE] = 27,
+                [XOCHIP_OP_ADD_VX_BYTE] = 45,  [XOCHIP_OP_LD_VX_VY] = 200,    [XOCHIP_OP_OR_VX_VY] = 200,
+                [XOCHIP_OP_AND_VX_VY] = 200,   [XOCHIP_OP_XOR_VX_VY] = 200,   [XOCHIP_OP_ADD_VX_VY] = 200,
+                [XOCHIP_OP_SUB_VX_VY] = 200,   [XOCHIP_OP_SHR_VX_VY] = 200,   [XOCHIP_OP_SUBN_VX_VY] = 200,
+                [XOCHIP_OP_SHL_VX_VY] = 200,   [XOCHIP_OP_SNE_VX_VY] = 73,    [XOCHIP_OP_LD_I_ADDR] = 55,
+                [XOCHIP_OP_JP_V0_ADDR] = 105,  [XOCHIP_OP_RND_VX_BYTE] = 164, [XOCHIP_OP_DRW_VX_VY_N] = 2000,
+                [XOCHIP_OP_SKP_VX] = 73,       [XOCHIP_OP_SKNP_VX] = 73,      [XOCHIP_OP_LD_VX_DT] = 45,
+                [XOCHIP_OP_LD_VX_K] = 45,      [XOCHIP_OP_LD_DT_VX] = 45,     [XOCHIP_OP_LD_ST_VX] = 45,
+                [XOCHIP_OP_ADD_I_VX] = 86,     [XOCHIP_OP_LD_F_VX] = 91,      [XOCHIP_OP_LD_B_VX] = 927,
+                [XOCHIP_OP_LD_I_VX] = 64,      [XOCHIP_OP_LD_VX_I] = 64,
+            },
+        .sprite_row = 530,
+        .register_copy = 64,
+        .cycles_per_tick = 16667,
+    };
+    // In plain instructions, everything not listed is 1. The HP 48 redraws its LCD from the display buffer, so what
+    // touches all of it costs the most.
+    static const xochip_cost_table_t schip = {
+        .ops =
+            {
+                [XOCHIP_OP_CLS] = 4,       [XOCHIP_OP_RND_VX_BYTE] = 2,   [XOCHIP_OP_LD_B_VX] = 3,
+                [XOCHIP_OP_SCD_N] = 8,     [XOCHIP_OP_SCR] = 8,           [XOCHIP_OP_SCL] = 8,
+                [XOCHIP_OP_LOW] = 4,       [XOCHIP_OP_HIGH] = 4,          [XOCHIP_OP_LD_R_VX] = 4,
+                [XOCHIP_OP_LD_VX_R] = 4,
+            },
+        .sprite_row = 1,
+        .cycles_per_tick = 30,
+    };
+    // In plain instructions, everything not listed is 1. Clearing and scrolling go over both planes, and so do draws
+    // with both selected, which the table can't tell apart.
+    static const xochip_cost_table_t xochip = {
+        .ops =
+            {
+                [XOCHIP_OP_CLS] = 4,       [XOCHIP_OP_RND_VX_BYTE] = 2,   [XOCHIP_OP_LD_B_VX] = 3,
+                [XOCHIP_OP_SCD_N] = 8,     [XOCHIP_OP_SCU_N] = 8,         [XOCHIP_OP_SCR] = 8,
+                [XOCHIP_OP_SCL] = 8,       [XOCHIP_OP_LOW] = 4,           [XOCHIP_OP_HIGH] = 4,
+                [XOCHIP_OP_LD_I_LONG] = 2, [XOCHIP_OP_AUDIO] = 2,
+            },
+        .sprite_row = 1,
+        .cycles_per_tick = 1000,
+    };
+
+    switch (preset)
+    {
+    case XOCHIP_COST_VIP:
+        return &vip;
+    case XOCHIP_COST_SCHIP:
+        return &schip;
+    case XOCHIP_COST_XOCHIP:
+        return &xochip;
+    default:
+        return NULL;
+    }
+}
+
+void xochip_key_up(xochip_t *emulator, xochip_keys_t key)
+{
+    if (key < XOCHIP_KEYCOUNT)
+    {
+        emulator->released_keys |= XOCHIP_KEY(key);
+        emulator->pressed_keys &= ~XOCHIP_KEY(key);
+    }
+}
+
+void xochip_key_down(xochip_t *emulator, xochip_keys_t key)
+{
+    if (key < XOCHIP_KEYCOUNT)
+    {
+        emulator->pressed_keys |= XOCHIP_KEY(key);
+        emulator->released_keys &= ~XOCHIP_KEY(key);
+    }
+}
+
+uint8_t xochip_peek(const xochip_t *emulator, const uint16_t address)
+{
+    return xochip_read_byte(emulator, address);
+}
+
+xochip_result_t xochip_attach_debugger(xochip_t *emulator, xochip_debugger_t *debugger)
+{
+    if (!emulator)
+    {
+        return XOCHIP_ERR_NULL_POINTER;
+    }
+
+    if (debugger)
+    {
+        memset(debugger, 0, sizeof(*debugger));
+    }
+
+    emulator->debugger = debugger;
+    emulator->debugging = false;
+    return XOCHIP_SUCCESS;
+}
+
+xochip_result_t xochip_attach_decode_cache(xochip_t *emulator, xochip_decode_cache_t *cache)
+{
+    if (!emulator)
+    {
+        return XOCHIP_ERR_NULL_POINTER;
+    }
+
+    if (cache)
+    {
+        memset(cache->entries, XOCHIP_DECODE_EMPTY, sizeof(cache->entries));
+    }
+
+    emulator->decode_cache = cache;
+    return XOCHIP_SUCCESS;
+}
+
+xochip_result_t xochip_attach_sprite_cache(xochip_t *emulator, xochip_sprite_cache_t *cache)
+{
+    if (!emulator)
+    {
+        return XOCHIP_ERR_NULL_POINTER;
+    }
+
+    if (cache)
+    {
+        memset(cache, 0, sizeof(*cache));
+    }
+
+    emulator->sprite_cache = cache;
+    return XOCHIP_SUCCESS;
+}
+
+xochip_result_t xochip_attach_hash(xochip_t *emulator, xochip_hash_t *hash)
+{
+    if (!emulator)
+    {
+        return XOCHIP_ERR_NULL_POINTER;
+    }
+
+    if (hash)
+    {
+        // zeroed, the stored hashes and their XORs agree with each other, so marking everything stale is enough
+        memset(hash, 0, sizeof(*hash));
+        memset(hash->stale_pages, 0xFF, sizeof(hash->stale_pages));
+        hash->stale_rows = UINT64_MAX;
+    }
+
+    emulator->hash = hash;
+    return XOCHIP_SUCCESS;
+}
+
+// Mixes size bytes (a multiple of 8) into hash, read as little endian words so every host gets the same value
+static uint64_t xochip_hash_bytes(uint64_t hash, const uint8_t *data, const size_t size)
+{
+    for (size_t offset = 0; offset < size; offset += 8)
+    {
+        const uint8_t *bytes = data + offset;
+        const uint64_t word = (uint64_t)bytes[0] | (uint64_t)bytes[1] << 8 | (uint64_t)bytes[2] << 16 |
+                              (uint64_t)bytes[3] << 24 | (uint64_t)bytes[4] << 32 | (uint64_t)bytes[5] << 40 |
+                              (uint64_t)bytes[6] << 48 | (uint64_t)bytes[7] << 56;
+        hash = (hash ^ word) * 0xFF51AFD7ED558CCDULL;
+        hash ^= hash >> 32;
+    }
+    return hash;
+}
+
+// splitmix64's finalizer, so that every input bit reaches every output bit before hashes are XORed together
+static uint64_t xochip_hash_finish(uint64_t hash)
+{
+    hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+    return hash ^ (hash >> 31);
+}
+
+// Pages and rows are seeded with where they are, so the same bytes in two places don't cancel out
+static uint64_t xochip_hash_page(const xochip_t *emulator, const uint32_t page)
+{
+    uint8_t scratch[XOCHIP_PAGE_SIZE];
+    const uint8_t *bytes = xochip_page_bytes(emulator, page, scratch);
+    return xochip_hash_finish(xochip_hash_bytes(page + 1, bytes, XOCHIP_PAGE_SIZE));
+}
+
+static uint64_t xochip_hash_row(const xochip_display_t *display, const uint32_t row)
+{
+    const size_t offset = row * XOCHIP_DISPLAY_ROW_BYTES;
+    uint64_t hash = xochip_hash_bytes(XOCHIP_PAGE_COUNT + 1 + row, display->back_plane + offset,
+                                      XOCHIP_DISPLAY_ROW_BYTES);
+    hash = xochip_hash_bytes(hash, display->fore_plane + offset, XOCHIP_DISPLAY_ROW_BYTES);
+    return xochip_hash_finish(hash);
+}
+
+// Everything that isn't memory or the display, it's small enough to hash every time
+static uint64_t xochip_hash_registers(const xochip_t *emulator)
+{
+    uint8_t state[112] = {0};
+    uint8_t *cursor = state;
+    const uint16_t words[4] = {emulator->counter, emulator->address, emulator->pressed_keys, emulator->released_keys};
+    for (uint8_t word = 0; word < 4; ++word)
+    {
+        *cursor++ = (uint8_t)words[word];
+        *cursor++ = (uint8_t)(words[word] >> 8);
+    }
+
+    memcpy(cursor, emulator->registers, sizeof(emulator->registers));
+    cursor += sizeof(emulator->registers);
+    memcpy(cursor, emulator->flags, sizeof(emulator->flags));
+    cursor += sizeof(emulator->flags);
+    memcpy(cursor, emulator->audio, sizeof(emulator->audio));
+    cursor += sizeof(emulator->audio);
+    for (uint8_t shift = 0; shift < 32; shift += 8)
+    {
+        *cursor++ = (uint8_t)(emulator->random >> shift);
+    }
+    *cursor++ = emulator->display.selected_plane;
+    *cursor++ = emulator->display.hires;
+
+    // only the addresses that are on the stack, whatever a return left behind above them doesn't matter
+    const uint8_t depth = emulator->stack.counter < 16 ? emulator->stack.counter : 16;
+    *cursor++ = depth;
+    for (uint8_t entry = 0; entry < depth; ++entry)
+    {
+        *cursor++ = (uint8_t)emulator->stack.addresses[entry];
+        *cursor++ = (uint8_t)(emulator->stack.addresses[entry] >> 8);
+    }
+
+    return xochip_hash_finish(xochip_hash_bytes(0, state, sizeof(state)));
+}
+
+uint64_t xochip_state_hash(xochip_t *emulator)
+{
+    if (!emulator)
+    {
+        return 0;
+    }
+
+    xochip_hash_t *hash = emulator->hash;
+    if (!hash)
+    {
+        uint64_t whole = xochip_hash_registers(emulator);
+        for (uint32_t page = 0; page < XOCHIP_PAGE_COUNT; ++page)
+        {
+            whole ^= xochip_hash_page(emulator, page);
+        }
+        for (uint32_t row = 0; row < XOCHIP_DISPLAY_HEIGHT; ++row)
+        {
+            whole ^= xochip_hash_row(&emulator->display, row);
+        }
+        return whole;
+    }
+
+    for (uint32_t group = 0; group < sizeof(hash->stale_pages); ++group)
+    {
+        // a byte at a time, most of them are clear
+        for (uint8_t bit = 0; hash->stale_pages[group] && bit < 8; ++bit)
+        {
+            if (hash->stale_pages[group] & (1u << bit))
+            {
+                const uint32_t page = group * 8 + bit;
+                hash->memory ^= hash->pages[page];
+                hash->pages[page] = xochip_hash_page(emulator, page);
+                hash->memory ^= hash->pages[page];
+                hash->stale_pages[group] &= (uint8_t)~(1u << bit);
+            }
+        }
+    }
+
+    for (uint32_t row = 0; hash->stale_rows && row < XOCHIP_DISPLAY_HEIGHT; ++row)
+    {
+        if (hash->stale_rows & ((uint64_t)1 << row))
+        {
+            hash->display ^= hash->rows[row];
+            hash->rows[row] = xochip_hash_row(&emulator->display, row);
+            hash->display ^= hash->rows[row];
+            hash->stale_rows &= ~((uint64_t)1 << row);
+        }
+    }
+
+    return xochip_hash_registers(emulator) ^ hash->memory ^ hash->display;
+}
+
+// The state hash, mixed with everything outside the machine that shapes a frame: the scheduler's pacing and phases, the
+// cost table, and whether the display was already flagged as updated, since a frame that draws nothing leaves it as is
+static uint64_t xochip_memo_key(xochip_t *emulator, const xochip_scheduler_t *scheduler)
+{
+    const uint64_t words[4] = {
+        (uint64_t)(uintptr_t)emulator->costs,
+        scheduler ? (uint64_t)scheduler->cycles_per_tick << 32 | scheduler->audio_period : UINT64_MAX,
+        scheduler ? (uint64_t)scheduler->tick_phase << 32 | (scheduler->audio_period ? scheduler->audio_phase : 0)
+                  : UINT64_MAX,
+        emulator->display.updated,
+    };
+    uint8_t pacing[sizeof(words)];
+    for (size_t index = 0; index < sizeof(pacing); ++index)
     {
-        const uint16_t address = OPCODE_NNN(next_instruction);
-        result = xochip_op_call(emulator, address);
-        break;
+        pacing[index] = (uint8_t)(words[index / 8] >> (index % 8 * 8));
     }
-    case 0x3:
+
+    const uint64_t seed = XOCHIP_PAGE_COUNT + XOCHIP_DISPLAY_HEIGHT + 1;
+    return xochip_state_hash(emulator) ^ xochip_hash_finish(xochip_hash_bytes(seed, pacing, sizeof(pacing)));
+}
+
+xochip_result_t xochip_memo_init(xochip_memo_t *memo, xochip_memo_entry_t *entries, const size_t count)
+{
+    if (!memo || !entries)
     {
-        const xochip_register_t vx = OPCODE_X(next_instruction);
-        const uint8_t byte = OPCODE_KK(next_instruction);
-        result = xochip_op_se_vx_b(emulator, vx, byte);
-        break;
+        return XOCHIP_ERR_NULL_POINTER;
     }
-    case 0x4:
+    if (count == 0)
     {
-        const xochip_register_t vx = OPCODE_X(next_instruction);
-        const uint8_t byte = OPCODE_KK(next_instruction);
-        result = xochip_op_sne_vx_b(emulator, vx, byte);
-        break;
+        return XOCHIP_ERR_INVALID_ARGUMENT;
     }
-    case 0x5:
+
+    memset(memo, 0, sizeof(*memo));
+    memo->entries = entries;
+    memo->count = count;
+    for (size_t index = 0; index < count; ++index)
+    {
+        entries[index].valid = false;
+    }
+    return XOCHIP_SUCCESS;
+}
+
+// Whether the pages entry writes have somewhere to go, only XOCHIP_XIP builds can run out
+static bool xochip_memo_fits(const xochip_t *emulator, const xochip_memo_entry_t *entry)
+{
+#ifdef XOCHIP_XIP
+    uint32_t missing = 0;
+    for (uint8_t index = 0; index < entry->page_count; ++index)
+    {
+        missing += !emulator->page_slots[entry->pages[index]];
+    }
+    return emulator->pages_used + missing <= XOCHIP_XIP_PAGES;
+#else
+    (void)emulator;
+    (void)entry;
+    return true;
+#endif
+}
+
+bool xochip_memo_replay(xochip_memo_t *memo, xochip_t *emulator, xochip_scheduler_t *scheduler)
+{
+    if (!memo || !emulator)
+    {
+        return false;
+    }
+
+    memo->recording = false;
+    if (!emulator->hash || emulator->debugging)
+    {
+        return false;
+    }
+
+    const uint64_t key = xochip_memo_key(emulator, scheduler);
+    const xochip_memo_entry_t *entry = &memo->entries[key % memo->count];
+    if (!entry->valid || entry->key != key || !xochip_memo_fits(emulator, entry))
+    {
+        memo->misses++;
+        memo->recording = true;
+        memo->key = key;
+        memo->cycles = emulator->cycles;
+        memo->ticks = scheduler ? scheduler->ticks : 0;
+        return false;
+    }
+
+    memo->hits++;
+    if (emulator->stats)
+    {
+        // the stats see frames that ran, this one's cycles weren't
+        emulator->stats->start += entry->cycles;
+    }
+    emulator->counter = entry->counter;
+    emulator->address = entry->address;
+    emulator->pressed_keys = entry->pressed_keys;
+    emulator->released_keys = entry->released_keys;
+    memcpy(emulator->registers, entry->registers, sizeof(emulator->registers));
+    emulator->stack = entry->stack;
+    memcpy(emulator->audio, entry->audio, sizeof(emulator->audio));
+    emulator->random = entry->random;
+    memcpy(emulator->flags, entry->flags, sizeof(emulator->flags));
+    emulator->display.selected_plane = entry->selected_plane;
+    emulator->display.hires = entry->hires;
+    emulator->cycles += entry->cycles;
+
+    uint8_t pages[XOCHIP_PAGE_COUNT / 8] = {0};
+    for (uint8_t index = 0; index < entry->page_count; ++index)
     {
-        const xochip_register_t vx = OPCODE_X(next_instruction);
-        const xochip_register_t vy = OPCODE_Y(next_instruction);
+        const uint32_t page = entry->pages[index];
+        xochip_write_block(emulator, page * XOCHIP_PAGE_SIZE, entry->memory[index], XOCHIP_PAGE_SIZE);
+        xochip_mark_pages(pages, page * XOCHIP_PAGE_SIZE, XOCHIP_PAGE_SIZE);
+        xochip_mark_pages(emulator->dirty_pages, page * XOCHIP_PAGE_SIZE, XOCHIP_PAGE_SIZE);
+    }
+    xochip_pages_replaced(emulator, pages);
 
-        switch (OPCODE_N(next_instruction))
+    for (uint32_t row = 0; row < XOCHIP_DISPLAY_HEIGHT; ++row)
+    {
+        if (entry->rows & ((uint64_t)1 << row))
         {
-        case 0x0:
-            result = xochip_op_se_vx_vy(emulator, vx, vy);
-            break;
-        case 0x2:
-            result = xochip_op_save_vx_vy(emulator, vx, vy);
-            break;
-        case 0x3:
-            result = xochip_op_load_vx_vy(emulator, vx, vy);
-            break;
-        default:
-            result = XOCHIP_ERR_INVALID_INSTRUCTION;
-            break;
+            const size_t offset = row * XOCHIP_DISPLAY_ROW_BYTES;
+            memcpy(emulator->display.back_plane + offset, entry->back_plane + offset, XOCHIP_DISPLAY_ROW_BYTES);
+            memcpy(emulator->display.fore_plane + offset, entry->fore_plane + offset, XOCHIP_DISPLAY_ROW_BYTES);
         }
-        break;
     }
-    case 0x6:
+    if (entry->rows)
     {
-        const xochip_register_t vx = OPCODE_X(next_instruction);
-        const uint8_t byte = OPCODE_KK(next_instruction);
-        result = xochip_op_ld_vx_b(emulator, vx, byte);
-        break;
+        xochip_display_changed(emulator, entry->rows);
     }
-    case 0x7:
+    emulator->display.updated = entry->updated;
+
+    if (scheduler)
     {
-        const xochip_register_t vx = OPCODE_X(next_instruction);
-        const uint8_t byte = OPCODE_KK(next_instruction);
-        result = xochip_op_add_vx_b(emulator, vx, byte);
-        break;
+        scheduler->cycles += entry->cycles;
+        scheduler->ticks += entry->ticks;
+        scheduler->tick_phase = entry->tick_phase;
+        // without audio yields the audio phase just counts cycles
+        scheduler->audio_phase =
+            scheduler->audio_period ? entry->audio_phase : scheduler->audio_phase + (uint32_t)entry->cycles;
     }
-    case 0x8:
+    return true;
+}
+
+void xochip_memo_record(xochip_memo_t *memo, xochip_t *emulator, const xochip_scheduler_t *scheduler,
+                        const xochip_result_t result)
+{
+    if (!memo || !emulator || !memo->recording)
+    {
+        return;
+    }
+
+    memo->recording = false;
+    const xochip_hash_t *hash = emulator->hash;
+    if (result != XOCHIP_SUCCESS || !hash)
     {
-        const xochip_register_t vx = OPCODE_X(next_instruction);
-        const xochip_register_t vy = OPCODE_Y(next_instruction);
+        return;
+    }
 
-        switch (OPCODE_N(next_instruction))
+    // the hash was brought up to date when the frame started, so whatever is stale now is what the frame touched
+    uint8_t written[XOCHIP_MEMO_PAGES];
+    uint8_t page_count = 0;
+    for (uint32_t page = 0; page < XOCHIP_PAGE_COUNT; ++page)
+    {
+        if (XOCHIP_BITMAP_TEST(hash->stale_pages, page))
         {
-        case 0x0:
-            result = xochip_op_ld_vx_vy(emulator, vx, vy);
-            break;
-        case 0x1:
-            result = xochip_op_or_xv_vy(emulator, vx, vy);
-            break;
-        case 0x2:
-            result = xochip_op_and_xv_vy(emulator, vx, vy);
-            break;
-        case 0x3:
-            result = xochip_op_xor_xv_vy(emulator, vx, vy);
-            break;
-        case 0x4:
-            result = xochip_op_add_xv_vy(emulator, vx, vy);
-            break;
-        case 0x5:
-            result = xochip_op_sub_xv_vy(emulator, vx, vy);
-            break;
-        case 0x6:
-            result = xochip_op_shr_xv_vy(emulator, vx, vy);
-            break;
-        case 0x7:
-            result = xochip_op_subn_xv_vy(emulator, vx, vy);
-            break;
-        case 0xE:
-            result = xochip_op_shl_xv_vy(emulator, vx, vy);
-            break;
-        default:
-            result = XOCHIP_ERR_INVALID_INSTRUCTION;
-            break;
+            if (page_count == XOCHIP_MEMO_PAGES)
+            {
+                return;
+            }
+            written[page_count++] = (uint8_t)page;
         }
-        break;
     }
-    case 0x9:
+
+    xochip_memo_entry_t *entry = &memo->entries[memo->key % memo->count];
+    entry->key = memo->key;
+    entry->valid = true;
+    entry->counter = emulator->counter;
+    entry->address = emulator->address;
+    entry->pressed_keys = emulator->pressed_keys;
+    entry->released_keys = emulator->released_keys;
+    memcpy(entry->registers, emulator->registers, sizeof(entry->registers));
+    entry->stack = emulator->stack;
+    memcpy(entry->audio, emulator->audio, sizeof(entry->audio));
+    entry->random = emulator->random;
+    memcpy(entry->flags, emulator->flags, sizeof(entry->flags));
+    entry->selected_plane = emulator->display.selected_plane;
+    entry->hires = emulator->display.hires;
+    entry->updated = emulator->display.updated;
+
+    entry->cycles = emulator->cycles - memo->cycles;
+    entry->ticks = scheduler ? scheduler->ticks - memo->ticks : 0;
+    entry->tick_phase = scheduler ? scheduler->tick_phase : 0;
+    entry->audio_phase = scheduler ? scheduler->audio_phase : 0;
+
+    entry->rows = hash->stale_rows;
+    for (uint32_t row = 0; row < XOCHIP_DISPLAY_HEIGHT; ++row)
     {
-        const xochip_register_t vx = OPCODE_X(next_instruction);
-        const xochip_register_t vy = OPCODE_Y(next_instruction);
-        result = xochip_op_sne_xv_vy(emulator, vx, vy);
-        break;
+        if (entry->rows & ((uint64_t)1 << row))
+        {
+            const size_t offset = row * XOCHIP_DISPLAY_ROW_BYTES;
+            memcpy(entry->back_plane + offset, emulator->display.back_plane + offset, XOCHIP_DISPLAY_ROW_BYTES);
+            memcpy(entry->fore_plane + offset, emulator->display.fore_plane + offset, XOCHIP_DISPLAY_ROW_BYTES);
+        }
     }
-    case 0xA:
+
+    entry->page_count = page_count;
+    for (uint8_t index = 0; index < page_count; ++index)
     {
-        result = xochip_op_ld_i(emulator, OPCODE_NNN(next_instruction));
-        break;
+        entry->pages[index] = written[index];
+        xochip_read_block(emulator, written[index] * XOCHIP_PAGE_SIZE, entry->memory[index], XOCHIP_PAGE_SIZE);
     }
-    case 0xB:
+}
+
+xochip_result_t xochip_attach_stats(xochip_t *emulator, xochip_frame_stats_t *stats)
+{
+    if (!emulator)
     {
-        result = xochip_op_jp_v0_addr(emulator, OPCODE_NNN(next_instruction));
-        break;
+        return XOCHIP_ERR_NULL_POINTER;
     }
-    case 0xC:
+
+    emulator->stats = stats;
+    xochip_stats_begin(emulator);
+    return XOCHIP_SUCCESS;
+}
+
+void xochip_stats_begin(xochip_t *emulator)
+{
+    if (!emulator || !emulator->stats)
     {
-        const xochip_register_t vx = OPCODE_X(next_instruction);
-        const uint8_t byte = OPCODE_KK(next_instruction);
-        result = xochip_op_rnd_vx_b(emulator, vx, byte);
-        break;
+        return;
     }
-    case 0xD:
+
+    memset(emulator->stats, 0, sizeof(*emulator->stats));
+    emulator->stats->start = emulator->cycles;
+}
+
+xochip_result_t xochip_calibrator_init(xochip_calibrator_t *calibrator, const uint32_t minimum, const uint32_t maximum,
+                                       const uint32_t initial)
+{
+    if (!calibrator)
     {
-        const xochip_register_t vx = OPCODE_X(next_instruction);
-        const xochip_register_t vy = OPCODE_X(next_instruction);
-        const uint8_t height = OPCODE_N4(next_instruction);
-        result = xochip_op_drw_vx_vy_n(emulator, vx, vy, height);
-        break;
+        return XOCHIP_ERR_NULL_POINTER;
     }
-    case 0xE:
+    if (minimum == 0 || initial < minimum || initial > maximum)
     {
-        const xochip_register_t vx = OPCODE_X(next_instruction);
+        return XOCHIP_ERR_INVALID_ARGUMENT;
+    }
 
-        switch (OPCODE_KK(next_instruction))
+    calibrator->minimum = minimum;
+    calibrator->maximum = maximum;
+    calibrator->cycles_per_tick = initial;
+    calibrator->peak = 0;
+    calibrator->keeps_time = false;
+    return XOCHIP_SUCCESS;
+}
+
+uint32_t xochip_calibrate(xochip_calibrator_t *calibrator, xochip_t *emulator, xochip_scheduler_t *scheduler)
+{
+    const xochip_frame_stats_t *stats = emulator ? emulator->stats : NULL;
+    uint32_t cycles = calibrator->cycles_per_tick;
+
+    // a frame that didn't run, e.g. a replayed one, says nothing
+    if (stats && emulator->cycles > stats->start)
+    {
+        if (stats->idle != XOCHIP_IDLE_NONE)
         {
-        case 0x9E:
-            result = xochip_op_skp_vx(emulator, vx);
-            break;
-        case 0xA1:
-            result = xochip_op_skpn_vx(emulator, vx);
-            break;
-        default:
-            result = XOCHIP_ERR_INVALID_INSTRUCTION;
-            break;
+            calibrator->keeps_time = true;
+
+            // frames that draw are the ones that need to keep up, the rest e.g. wait out a title screen
+            const uint64_t busy = stats->idle_since > stats->start ? stats->idle_since - stats->start : 0;
+            if (stats->draws > 0 || stats->idle == XOCHIP_IDLE_HALT)
+            {
+                // rounded up, so a peak nothing needs any more fades all the way to 0
+                const uint32_t faded = calibrator->peak - (calibrator->peak + 63) / 64;
+                calibrator->peak = busy > faded ? (uint32_t)(busy < UINT32_MAX ? busy : UINT32_MAX) : faded;
+            }
+
+            uint64_t target = (uint64_t)calibrator->peak + calibrator->peak / 4 + 2;
+            target = target < calibrator->minimum ? calibrator->minimum : target;
+            target = target > calibrator->maximum ? calibrator->maximum : target;
+
+            // catch up at once, slow down gently and only once there's plenty to spare, a pick that keeps changing
+            // would keep xochip_memo_replay from ever seeing the same frame twice
+            if (target > cycles)
+            {
+                cycles = (uint32_t)target;
+            }
+            else if (target < cycles - cycles / 8)
+            {
+                const uint32_t eased = cycles - (cycles >= 16 ? cycles / 16 : 1);
+                cycles = target > eased ? (uint32_t)target : eased;
+            }
+        }
+        else if (calibrator->keeps_time || stats->expired > 0)
+        {
+            // a game that waits and didn't, or found the delay timer already run out, fell behind. Once it was seen
+            // waiting after drawing, catching up stops at 4 times what that needed, so one frame that takes much
+            // longer, e.g. one that loads a level, doesn't send the pick to the maximum. Falling behind at that
+            // ceiling too means the game needs more now, and it doubles past it.
+            uint64_t ceiling = calibrator->maximum;
+            const uint64_t needed = (uint64_t)calibrator->peak + calibrator->peak / 4 + 2;
+            if (calibrator->peak > 0 && 4 * needed > cycles)
+            {
+                ceiling = 4 * needed < ceiling ? 4 * needed : ceiling;
+            }
+            const uint64_t doubled = (uint64_t)cycles * 2 < ceiling ? (uint64_t)cycles * 2 : ceiling;
+            cycles = doubled > cycles ? (uint32_t)doubled : cycles;
         }
-        break;
     }
-    case 0xF:
+
+    cycles = cycles < calibrator->minimum ? calibrator->minimum : cycles;
+    calibrator->cycles_per_tick = cycles;
+
+    if (scheduler)
+    {
+        scheduler->cycles_per_tick = cycles > scheduler->tick_phase ? cycles : scheduler->tick_phase + 1;
+    }
+    xochip_stats_begin(emulator);
+    return cycles;
+}
+
+xochip_result_t xochip_set_breakpoint(xochip_t *emulator, const xochip_address_t address)
+{
+    if (!emulator || !emulator->debugger)
+    {
+        return XOCHIP_ERR_NULL_POINTER;
+    }
+
+    xochip_debugger_t *debugger = emulator->debugger;
+    debugger->count += xochip_bitmap_update(debugger->breakpoints, address, true);
+    emulator->debugging = debugger->count > 0;
+    return XOCHIP_SUCCESS;
+}
+
+xochip_result_t xochip_clear_breakpoint(xochip_t *emulator, const xochip_address_t address)
+{
+    if (!emulator || !emulator->debugger)
+    {
+        return XOCHIP_ERR_NULL_POINTER;
+    }
+
+    xochip_debugger_t *debugger = emulator->debugger;
+    debugger->count -= xochip_bitmap_update(debugger->breakpoints, address, false);
+    emulator->debugging = debugger->count > 0;
+    return XOCHIP_SUCCESS;
+}
+
+static xochip_result_t xochip_update_watchpoint(xochip_t *emulator, const xochip_address_t address,
+                                                const uint32_t length, const uint8_t flags, const bool set)
+{
+    if (!emulator || !emulator->debugger)
+    {
+        return XOCHIP_ERR_NULL_POINTER;
+    }
+
+    if ((uint32_t)address + length > XOCHIP_ADDRESS_SPACE_SIZE)
+    {
+        return XOCHIP_ERR_ADDRESS_OVERFLOW;
+    }
+
+    xochip_debugger_t *debugger = emulator->debugger;
+    for (uint32_t watched = address; watched < (uint32_t)address + length; ++watched)
     {
-        if (next_instruction == 0xF000)
+        if (flags & XOCHIP_WATCH_READ)
         {
-            emulator->counter += XOCHIP_OPCODE_SIZE;
-            const uint16_t new_addr =
-                (emulator->memory[emulator->counter] << 8) | (emulator->memory[emulator->counter + 1]);
-            result = xochip_op_ld_i_long(emulator, new_addr);
-            break;
+            const uint32_t changed = xochip_bitmap_update(debugger->read_watch, watched, set);
+            debugger->count = set ? debugger->count + changed : debugger->count - changed;
         }
 
-        const xochip_register_t vx = OPCODE_X(next_instruction);
-
-        switch (OPCODE_KK(next_instruction))
+        if (flags & XOCHIP_WATCH_WRITE)
         {
-        case 0x01:
-            result = xochip_op_plane(emulator, OPCODE_X(next_instruction));
-            break;
-        case 0x02:
-            result = xochip_op_audio(emulator);
-            break;
-        case 0x07:
-            result = xochip_op_ld_vx_dt(emulator, vx);
-            break;
-        case 0x0A:
-            result = xochip_op_ld_vx_k(emulator, vx);
-            break;
-        case 0x15:
-            result = xochip_op_ld_dt_vx(emulator, vx);
-            break;
-        case 0x18:
-            result = xochip_op_ld_st_vx(emulator, vx);
-            break;
-        case 0x1E:
-            result = xochip_op_add_i_vx(emulator, vx);
-            break;
-        case 0x29:
-            result = xochip_op_ld_f_vx(emulator, vx);
-            break;
-        case 0x3a:
-            result = xochip_op_pitch(emulator, vx);
-            break;
-        case 0x33:
-            result = xochip_op_ld_b_vx(emulator, vx);
-            break;
-        case 0x55:
-            result = xochip_op_ld_i_vx(emulator, vx);
-            break;
-        case 0x65:
-            result = xochip_op_ld_vx_i(emulator, vx);
-            break;
-        default:
-            result = XOCHIP_ERR_INVALID_INSTRUCTION;
-            break;
+            const uint32_t changed = xochip_bitmap_update(debugger->write_watch, watched, set);
+            debugger->count = set ? debugger->count + changed : debugger->count - changed;
         }
-        break;
     }
-    default:
-        result = XOCHIP_ERR_INVALID_INSTRUCTION;
-        break;
+
+    emulator->debugging = debugger->count > 0;
+    return XOCHIP_SUCCESS;
+}
+
+xochip_result_t xochip_set_watchpoint(xochip_t *emulator, const xochip_address_t address, const uint32_t length,
+                                      const uint8_t flags)
+{
+    return xochip_update_watchpoint(emulator, address, length, flags, true);
+}
+
+xochip_result_t xochip_clear_watchpoint(xochip_t *emulator, const xochip_address_t address, const uint32_t length,
+                                        const uint8_t flags)
+{
+    return xochip_update_watchpoint(emulator, address, length, flags, false);
+}
+
+const uint8_t *xochip_display_row(const xochip_display_t *display, const uint8_t plane, const uint8_t y,
+                                  uint8_t *scratch)
+{
+    const uint8_t *planes[2] = {display->back_plane, display->fore_plane};
+    if (display->hires)
+    {
+        return planes[plane & 1] + (y % XOCHIP_DISPLAY_HEIGHT) * XOCHIP_DISPLAY_ROW_BYTES;
     }
 
-    emulator->released_keys = 0;
-    return result;
+    const uint8_t *line = planes[plane & 1] + (y % XOCHIP_DISPLAY_HEIGHT / 2) * XOCHIP_DISPLAY_ROW_BYTES;
+    for (uint8_t byte = 0; byte < XOCHIP_LORES_WIDTH / 8; ++byte)
+    {
+        const uint16_t doubled = (uint16_t)xochip_double_bits(line[byte]);
+        scratch[2 * byte] = (uint8_t)(doubled >> 8);
+        scratch[2 * byte + 1] = (uint8_t)doubled;
+    }
+    return scratch;
 }
 
-void xochip_tick(xochip_t *emulator)
+void xochip_display_expand(const xochip_display_t *display, uint8_t *back_plane, uint8_t *fore_plane)
 {
-    if (emulator->registers[XOCHIP_VSOUND] > 0)
+    uint8_t *planes[2] = {back_plane, fore_plane};
+    for (uint8_t plane = 0; plane < 2; ++plane)
     {
-        emulator->registers[XOCHIP_VSOUND]--;
+        for (uint8_t y = 0; y < XOCHIP_DISPLAY_HEIGHT; ++y)
+        {
+            uint8_t *out = planes[plane] + y * XOCHIP_DISPLAY_ROW_BYTES;
+            const uint8_t *row = xochip_display_row(display, plane, y, out);
+            if (row != out)
+            {
+                memcpy(out, row, XOCHIP_DISPLAY_ROW_BYTES);
+            }
+        }
     }
+}
 
-    if (emulator->registers[XOCHIP_VDELAY] > 0)
+xochip_result_t xochip_save_state(const xochip_t *emulator, xochip_state_t *state)
+{
+    if (!emulator || !state)
     {
-        emulator->registers[XOCHIP_VDELAY]--;
+        return XOCHIP_ERR_NULL_POINTER;
     }
+
+    memcpy(&state->machine, emulator, sizeof(state->machine));
+    state->machine.debugger = NULL;
+    state->machine.debugging = false;
+    state->machine.decode_cache = NULL;
+    state->machine.sprite_cache = NULL;
+    state->machine.hash = NULL;
+    state->machine.costs = NULL;
+    state->machine.stats = NULL;
+    return XOCHIP_SUCCESS;
 }
 
-void xochip_key_up(xochip_t *emulator, xochip_keys_t key)
+xochip_result_t xochip_load_state(xochip_t *emulator, const xochip_state_t *state)
 {
-    if (key < XOCHIP_KEYCOUNT)
+    if (!emulator || !state)
     {
-        emulator->released_keys |= XOCHIP_KEY(key);
-        emulator->pressed_keys &= ~XOCHIP_KEY(key);
+        return XOCHIP_ERR_NULL_POINTER;
     }
+
+    xochip_debugger_t *debugger = emulator->debugger;
+    const bool debugging = emulator->debugging;
+    xochip_decode_cache_t *decode_cache = emulator->decode_cache;
+    xochip_sprite_cache_t *sprite_cache = emulator->sprite_cache;
+    xochip_hash_t *hash = emulator->hash;
+    const xochip_cost_table_t *costs = emulator->costs;
+    xochip_frame_stats_t *stats = emulator->stats;
+
+    // a page that's clean on both sides holds the same bytes on both sides, so only pages either one wrote are copied
+    uint8_t pages[sizeof(emulator->dirty_pages)];
+    for (size_t index = 0; index < sizeof(pages); ++index)
+    {
+        pages[index] = emulator->dirty_pages[index] | state->machine.dirty_pages[index];
+    }
+
+#ifdef XOCHIP_XIP
+    // without memory[] the whole machine is only a few kb
+    memcpy(emulator, &state->machine, sizeof(*emulator));
+#else
+    const size_t memory_start = offsetof(xochip_t, memory);
+    const size_t memory_end = memory_start + sizeof(emulator->memory);
+    memcpy(emulator, &state->machine, memory_start);
+    memcpy((uint8_t *)emulator + memory_end, (const uint8_t *)&state->machine + memory_end,
+           sizeof(*emulator) - memory_end);
+
+    for (uint32_t page = 0; page < XOCHIP_PAGE_COUNT; ++page)
+    {
+        if (XOCHIP_BITMAP_TEST(pages, page))
+        {
+            memcpy(emulator->memory + page * XOCHIP_PAGE_SIZE, state->machine.memory + page * XOCHIP_PAGE_SIZE,
+                   XOCHIP_PAGE_SIZE);
+        }
+    }
+#endif
+
+    emulator->debugger = debugger;
+    emulator->debugging = debugging;
+    emulator->decode_cache = decode_cache;
+    emulator->sprite_cache = sprite_cache;
+    emulator->hash = hash;
+    emulator->costs = costs;
+    emulator->stats = stats;
+
+    xochip_pages_replaced(emulator, pages);
+    xochip_display_changed(emulator, UINT64_MAX);
+    return XOCHIP_SUCCESS;
 }
 
-void xochip_key_down(xochip_t *emulator, xochip_keys_t key)
+void xochip_seed_random(xochip_t *emulator, const uint32_t seed)
 {
-    if (key < XOCHIP_KEYCOUNT)
+    if (emulator)
     {
-        emulator->pressed_keys |= XOCHIP_KEY(key);
-        emulator->released_keys &= ~XOCHIP_KEY(key);
+        emulator->random = seed ? seed : XOCHIP_RANDOM_SEED;
     }
 }
 
@@ -1112,6 +4030,20 @@ const char *xochip_strerror(const xochip_result_t err)
         return "STACK OVERFLOW";
     case XOCHIP_ERR_NULL_POINTER:
         return "NULL POINTER";
+    case XOCHIP_STOPPED:
+        return "STOPPED";
+    case XOCHIP_ERR_READ:
+        return "READ ERROR";
+    case XOCHIP_ERR_INVALID_ARGUMENT:
+        return "INVALID ARGUMENT";
+    case XOCHIP_ERR_STACK_UNDERFLOW:
+        return "STACK UNDERFLOW";
+    case XOCHIP_EXITED:
+        return "EXITED";
+    case XOCHIP_ERR_WRITE:
+        return "WRITE ERROR";
+    case XOCHIP_ERR_OUT_OF_PAGES:
+        return "OUT OF PAGES";
     }
     return "UNKNOWN";
 }
@@ -0,0 +1,362 @@
+//
+// Optional C++17 wrapper, for C++ hosts. xo::Machine<Profile, Quirks, Hooks> owns an xochip_t and whatever the
+// profile attaches to it, and picks its execution loop at compile time: without an on_instruction hook the rest of a
+// frame is handed to xochip_run as one batch, with one it steps xochip_cycle and calls the hook after every
+// instruction. Both keep the scheduler the way xochip_run_budget does and end in the same state, the hook-free loop
+// just doesn't stop at every instruction to check for one. Everything goes through the C API, the raw xochip_t is
+// always one get() away.
+//
+// It lives in namespace xo, the C API already calls the machine struct xochip.
+//
+// The core is C, it uses designated initializers C++17 doesn't have. Define XOCHIP_IMPLEMENTATION in exactly one .c
+// file as usual, and include this from C++:
+//
+//     // xochip_impl.c
+//     #define XOCHIP_IMPLEMENTATION
+//     #include "xochip.h"
+//
+//     // main.cpp
+//     #include "xochip.hpp"
+//     xo::Machine<xo::profile::Fast, xo::quirks::XoChip> machine;
+//     machine.load(rom); // a std::vector<uint8_t>, std::array, std::span, ... or a pointer and a size
+//     while (machine.run_frame() == XOCHIP_SUCCESS) { draw(machine.display()); }
+//
+// With XOCHIP_XIP the ROM is read where it lies, so load() refuses temporaries.
+//
+
+#ifndef XOCHIP_HPP
+#define XOCHIP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "xochip.h"
+
+namespace xo
+{
+
+// =====================================================================================================================
+//    PROFILES
+// =====================================================================================================================
+
+// Which attachments a machine owns, allocated with it and attached for its whole life
+namespace profile
+{
+
+// The machine alone, the least memory
+struct Minimal
+{
+    static constexpr bool decode_cache = false;
+    static constexpr bool sprite_cache = false;
+    static constexpr bool hash = false;
+};
+
+// Instructions decoded once and sprites shifted once, the fastest way to play
+struct Fast
+{
+    static constexpr bool decode_cache = true;
+    static constexpr bool sprite_cache = true;
+    static constexpr bool hash = false;
+};
+
+// Fast, plus a state hash kept up to date piece by piece, for tools that compare or memoize states
+struct Tooling
+{
+    static constexpr bool decode_cache = true;
+    static constexpr bool sprite_cache = true;
+    static constexpr bool hash = true;
+};
+
+} // namespace profile
+
+// =====================================================================================================================
+//    QUIRKS
+// =====================================================================================================================
+
+// The platforms XO-CHIP grew out of, as far as the core tells them apart: by what their instructions cost, see
+// xochip_cost_preset. Octo counts every instruction as one, so XoChip runs without the preset's table and keeps the
+// fused handlers, and only takes its instructions per frame from it.
+namespace quirks
+{
+
+struct XoChip
+{
+    static constexpr xochip_cost_preset_t preset = XOCHIP_COST_XOCHIP;
+    static constexpr bool costed = false;
+};
+
+struct Schip
+{
+    static constexpr xochip_cost_preset_t preset = XOCHIP_COST_SCHIP;
+    static constexpr bool costed = true;
+};
+
+struct Vip
+{
+    static constexpr xochip_cost_preset_t preset = XOCHIP_COST_VIP;
+    static constexpr bool costed = true;
+};
+
+} // namespace quirks
+
+// =====================================================================================================================
+//    HOOKS
+// =====================================================================================================================
+
+// No hooks, the default. Hook types are empty classes or hold whatever the host needs, with any of:
+//
+//     void on_instruction(const xochip_t &machine); // after every instruction, switches to stepping
+//     void on_frame(const xochip_t &machine, bool updated); // after every frame, updated when the display changed
+struct NoHooks
+{
+};
+
+namespace detail
+{
+
+template <typename Hooks, typename = void>
+struct has_on_instruction : std::false_type
+{
+};
+
+template <typename Hooks>
+struct has_on_instruction<
+    Hooks, std::void_t<decltype(std::declval<Hooks &>().on_instruction(std::declval<const xochip_t &>()))>>
+    : std::true_type
+{
+};
+
+template <typename Hooks, typename = void>
+struct has_on_frame : std::false_type
+{
+};
+
+template <typename Hooks>
+struct has_on_frame<
+    Hooks, std::void_t<decltype(std::declval<Hooks &>().on_frame(std::declval<const xochip_t &>(), bool()))>>
+    : std::true_type
+{
+};
+
+// Owns an attachment when enabled, holds nothing otherwise. Attaching clears it, so it's allocated as it is.
+template <typename T, bool Enabled>
+class Owned
+{
+public:
+    T *get() const noexcept
+    {
+        return owned_.get();
+    }
+
+private:
+    std::unique_ptr<T> owned_{new T};
+};
+
+template <typename T>
+class Owned<T, false>
+{
+public:
+    T *get() const noexcept
+    {
+        return nullptr;
+    }
+};
+
+} // namespace detail
+
+// =====================================================================================================================
+//    MACHINE
+// =====================================================================================================================
+
+/**
+ * An emulator with its attachments and its pacing, set up by Profile and Quirks and watched by Hooks. Moves, doesn't
+ * copy, a moved-from machine can only be destroyed or assigned to.
+ */
+template <typename Profile = profile::Fast, typename Quirks = quirks::XoChip, typename Hooks = NoHooks>
+class Machine : private Hooks
+{
+public:
+    explicit Machine(Hooks hooks = Hooks()) : Hooks(std::move(hooks)), machine_(new xochip_t)
+    {
+        xochip_init(machine_.get());
+        xochip_attach_decode_cache(machine_.get(), decode_cache_.get());
+        xochip_attach_sprite_cache(machine_.get(), sprite_cache_.get());
+        xochip_attach_hash(machine_.get(), hash_.get());
+
+        const xochip_cost_table_t *costs = xochip_cost_preset(Quirks::preset);
+        xochip_set_costs(machine_.get(), Quirks::costed ? costs : nullptr);
+        xochip_scheduler_init(&scheduler_, costs->cycles_per_tick, 0);
+    }
+
+    Machine(Machine &&) = default;
+    Machine &operator=(Machine &&) = default;
+    Machine(const Machine &) = delete;
+    Machine &operator=(const Machine &) = delete;
+
+    /**
+     * @brief Load a ROM, see xochip_load_rom. With XOCHIP_XIP it's read from data until the next load or reset.
+     */
+    [[nodiscard]] xochip_result_t load(const std::uint8_t *data, std::size_t size) noexcept
+    {
+        return xochip_load_rom(machine_.get(), data, size);
+    }
+
+    /**
+     * @brief Load a ROM from anything contiguous with data() and size() in bytes, e.g. a std::vector, std::array or
+     * std::span.
+     */
+    template <typename Bytes>
+    [[nodiscard]] auto load(const Bytes &rom) noexcept
+        -> decltype(std::data(rom), std::size(rom), xochip_result_t())
+    {
+        static_assert(sizeof(*std::data(rom)) == 1, "a ROM is bytes");
+        return load(reinterpret_cast<const std::uint8_t *>(std::data(rom)), std::size(rom));
+    }
+
+#ifdef XOCHIP_XIP
+    // the ROM is read in place, a temporary would be gone before the first instruction
+    template <typename Bytes>
+    xochip_result_t load(const Bytes &&rom) = delete;
+#endif
+
+    /**
+     * @brief Reset the machine, see xochip_reset. The pacing starts over too.
+     */
+    [[nodiscard]] xochip_result_t reset() noexcept
+    {
+        xochip_scheduler_init(&scheduler_, scheduler_.cycles_per_tick, scheduler_.audio_period);
+        return xochip_reset(machine_.get());
+    }
+
+    /**
+     * @brief Run until the timers tick once, calling the hooks along the way. The scheduler ends where
+     * xochip_run_budget would leave it, but frames don't stop for audio.
+     * @return Success or error, see xochip_cycle
+     */
+    xochip_result_t run_frame() noexcept
+    {
+        xochip_t *machine = machine_.get();
+        xochip_result_t result = XOCHIP_SUCCESS;
+
+        while (result == XOCHIP_SUCCESS && scheduler_.tick_phase < scheduler_.cycles_per_tick)
+        {
+            const std::uint64_t before = machine->cycles;
+            if constexpr (detail::has_on_instruction<Hooks>::value)
+            {
+                result = xochip_cycle(machine);
+                if (result == XOCHIP_SUCCESS)
+                {
+                    hooks().on_instruction(*machine);
+                }
+            }
+            else
+            {
+                // what an instruction costs with a table is only known once it ran, without one the rest of the tick
+                // is one batch
+                const std::uint32_t rest = scheduler_.cycles_per_tick - scheduler_.tick_phase;
+                result = xochip_run(machine, machine->costs ? 1 : rest, nullptr);
+            }
+
+            const std::uint64_t executed = machine->cycles - before;
+            scheduler_.cycles += executed;
+            scheduler_.tick_phase += static_cast<std::uint32_t>(executed);
+            scheduler_.audio_phase += static_cast<std::uint32_t>(executed);
+            if (scheduler_.audio_period)
+            {
+                scheduler_.audio_phase %= scheduler_.audio_period;
+            }
+        }
+        if (result != XOCHIP_SUCCESS)
+        {
+            return result;
+        }
+
+        // one expensive instruction can span several ticks
+        while (scheduler_.tick_phase >= scheduler_.cycles_per_tick)
+        {
+            scheduler_.tick_phase -= scheduler_.cycles_per_tick;
+            scheduler_.ticks++;
+            xochip_tick(machine);
+        }
+
+        const bool updated = machine->display.updated;
+        machine->display.updated = false;
+        if constexpr (detail::has_on_frame<Hooks>::value)
+        {
+            hooks().on_frame(*machine, updated);
+        }
+        return result;
+    }
+
+    void key_down(const xochip_keys_t key) noexcept
+    {
+        xochip_key_down(machine_.get(), key);
+    }
+
+    void key_up(const xochip_keys_t key) noexcept
+    {
+        xochip_key_up(machine_.get(), key);
+    }
+
+    /**
+     * @brief Take a snapshot, see xochip_save_state. The pacing isn't part of it.
+     */
+    xochip_result_t save(xochip_state_t &state) const noexcept
+    {
+        return xochip_save_state(machine_.get(), &state);
+    }
+
+    xochip_result_t restore(const xochip_state_t &state) noexcept
+    {
+        return xochip_load_state(machine_.get(), &state);
+    }
+
+    /**
+     * @brief See xochip_state_hash, incremental with profile::Tooling.
+     */
+    std::uint64_t state_hash() noexcept
+    {
+        return xochip_state_hash(machine_.get());
+    }
+
+    const xochip_display_t &display() const noexcept
+    {
+        return machine_->display;
+    }
+
+    xochip_scheduler_t &scheduler() noexcept
+    {
+        return scheduler_;
+    }
+
+    Hooks &hooks() noexcept
+    {
+        return *this;
+    }
+
+    xochip_t *get() noexcept
+    {
+        return machine_.get();
+    }
+
+    const xochip_t *get() const noexcept
+    {
+        return machine_.get();
+    }
+
+private:
+    // 64kb without XOCHIP_XIP, too big to keep wherever the machine itself ends up
+    std::unique_ptr<xochip_t> machine_;
+    detail::Owned<xochip_decode_cache_t, Profile::decode_cache> decode_cache_;
+    detail::Owned<xochip_sprite_cache_t, Profile::sprite_cache> sprite_cache_;
+    detail::Owned<xochip_hash_t, Profile::hash> hash_;
+    xochip_scheduler_t scheduler_;
+};
+
+} // namespace xo
+
+#endif // XOCHIP_HPP
@@ -0,0 +1,521 @@
+//
+// Static ROM analysis: a disassembler and a control-flow graph builder. Instructions are decoded with xochip_decode, the
+// same table xochip_cycle dispatches on, so what you see here is what the emulator runs.
+//
+// The CFG is built by following every path from the 0x200 entry point through jumps (1nnn), calls (2nnn) and skips.
+// Bytes that are never reached are classified as data. Bnnn jumps depend on V0 at runtime, so they end the search.
+//
+// Like xochip.h, include this wherever you need it and define XOCHIP_IMPLEMENTATION in exactly one translation unit.
+// Everything works on a ROM image as it would be loaded at XOCHIP_ADDRESS_SPACE_START, so you can pass either the ROM
+// file's bytes or emulator->memory + XOCHIP_ADDRESS_SPACE_START.
+//
+
+#ifndef XOCHIP_DISASM_H
+#define XOCHIP_DISASM_H
+
+#include "xochip.h"
+
+// =====================================================================================================================
+//    DEFINES
+// =====================================================================================================================
+
+// Every block holds at least one instruction, so this is enough for any ROM that doesn't jump into the middle of its
+// own instructions. xochip_cfg_t.truncated is set if a ROM manages it anyway.
+#define XOCHIP_CFG_MAX_BLOCKS (XOCHIP_ROM_SIZE_MAX / XOCHIP_OPCODE_SIZE)
+
+// Flags for xochip_block_t
+#define XOCHIP_BLOCK_ENTRY 0x01       // starts at the entry point, 0x200
+#define XOCHIP_BLOCK_CALL_TARGET 0x02 // called with 2nnn somewhere
+#define XOCHIP_BLOCK_CALL 0x04        // ends with a 2nnn, the second successor is where it returns to
+#define XOCHIP_BLOCK_RETURN 0x08      // ends with 00EE
+#define XOCHIP_BLOCK_EXIT 0x10        // ends with 00FD
+#define XOCHIP_BLOCK_INDIRECT 0x20    // ends with Bnnn, where it goes depends on V0
+#define XOCHIP_BLOCK_INVALID 0x40     // ends with an invalid instruction, or runs off the end of the ROM
+
+// =====================================================================================================================
+//    TYPES
+// =====================================================================================================================
+
+/**
+ * A single decoded instruction.
+ */
+typedef struct xochip_instruction
+{
+    xochip_address_t address;
+    uint16_t opcode;
+    uint16_t operand; // nnnn for F000 nnnn, 0 for everything else
+    xochip_op_t op;
+    uint8_t size;
+} xochip_instruction_t;
+
+/**
+ * A basic block, a run of instructions that always execute one after the other.
+ */
+typedef struct xochip_block
+{
+    xochip_address_t start;            // address of the first instruction
+    xochip_address_t last;             // address of the last instruction
+    uint16_t instruction_count;        // instructions in the block
+    xochip_address_t successors[2];    // where execution can go next
+    uint8_t successor_count;           // 0 for returns, exits, indirect jumps and invalid instructions
+    uint8_t flags;                     // XOCHIP_BLOCK_*
+} xochip_block_t;
+
+/**
+ * The control-flow graph of a ROM, one bit per address for the classification bitmaps. This is big (~500kb), allocate
+ * it somewhere other than the stack.
+ */
+typedef struct xochip_cfg
+{
+    uint8_t code[XOCHIP_ADDRESS_SPACE_SIZE / 8];         // bytes that belong to a reachable instruction
+    uint8_t instructions[XOCHIP_ADDRESS_SPACE_SIZE / 8]; // addresses where a reachable instruction starts
+    uint8_t leaders[XOCHIP_ADDRESS_SPACE_SIZE / 8];      // addresses where a basic block starts
+    uint8_t call_targets[XOCHIP_ADDRESS_SPACE_SIZE / 8]; // addresses called with 2nnn
+
+    xochip_block_t blocks[XOCHIP_CFG_MAX_BLOCKS]; // sorted by start address
+    size_t block_count;
+    bool truncated; // ran out of blocks, the graph is incomplete
+
+    xochip_address_t worklist[XOCHIP_ADDRESS_SPACE_SIZE]; // scratch space for the search
+} xochip_cfg_t;
+
+// =====================================================================================================================
+//    API
+// =====================================================================================================================
+
+/**
+ * @brief Decode the instruction at a guest address.
+ * @param rom The ROM image, as loaded at XOCHIP_ADDRESS_SPACE_START
+ * @param size Size of the ROM image
+ * @param address Guest address of the instruction
+ * @param instruction Receives the decoded instruction
+ * @return false when the instruction doesn't fit inside the ROM image
+ */
+bool xochip_disasm_decode(const uint8_t *rom, size_t size, xochip_address_t address, xochip_instruction_t *instruction);
+
+/**
+ * @brief Format an instruction as assembly, e.g. "DRW V1, V2, 5". Mnemonics follow the list at the top of xochip.h.
+ * @param instruction A decoded instruction
+ * @param buffer Where to write the text, always null terminated
+ * @param size Size of buffer
+ * @return The length the text would have, like snprintf
+ */
+int xochip_disasm_format(const xochip_instruction_t *instruction, char *buffer, size_t size);
+
+/**
+ * @brief Find all code reachable from the entry point and split it into basic blocks.
+ * @param cfg Receives the graph
+ * @param rom The ROM image, as loaded at XOCHIP_ADDRESS_SPACE_START
+ * @param size Size of the ROM image
+ * @return Success or error:
+ * - XOCHIP_SUCCESS when ok
+ * - XOCHIP_ERR_NULL_POINTER when cfg or rom is null
+ * - XOCHIP_ERR_ROM_TOO_LARGE when ROM is larger than XOCHIP_ROM_SIZE_MAX
+ */
+xochip_result_t xochip_cfg_build(xochip_cfg_t *cfg, const uint8_t *rom, size_t size);
+
+/**
+ * @param cfg A graph built by xochip_cfg_build
+ * @param address A guest address
+ * @return true when the byte at address belongs to reachable code, false when it's data
+ */
+bool xochip_cfg_is_code(const xochip_cfg_t *cfg, xochip_address_t address);
+
+// =====================================================================================================================
+//    IMPLEMENTATION
+// =====================================================================================================================
+
+#ifdef XOCHIP_IMPLEMENTATION
+
+#include <stdio.h>
+
+#define XOCHIP_BITMAP_SET(bitmap, bit) ((bitmap)[(bit) >> 3] |= (uint8_t)(1u << ((bit) & 0x7)))
+
+bool xochip_disasm_decode(const uint8_t *rom, const size_t size, const xochip_address_t address,
+                          xochip_instruction_t *instruction)
+{
+    if (address < XOCHIP_ADDRESS_SPACE_START)
+    {
+        return false;
+    }
+
+    const size_t offset = address - XOCHIP_ADDRESS_SPACE_START;
+    if (offset + XOCHIP_OPCODE_SIZE > size)
+    {
+        return false;
+    }
+
+    instruction->address = address;
+    instruction->opcode = (uint16_t)((rom[offset] << 8) | rom[offset + 1]);
+    instruction->operand = 0;
+    instruction->op = xochip_decode(instruction->opcode);
+    instruction->size = xochip_op_size(instruction->op);
+
+    if (instruction->op == XOCHIP_OP_LD_I_LONG)
+    {
+        if (offset + instruction->size > size)
+        {
+            return false;
+        }
+        instruction->operand = (uint16_t)((rom[offset + 2] << 8) | rom[offset + 3]);
+    }
+
+    return true;
+}
+
+int xochip_disasm_format(const xochip_instruction_t *instruction, char *buffer, const size_t size)
+{
+    const uint16_t opcode = instruction->opcode;
+    const unsigned x = OPCODE_X(opcode);
+    const unsigned y = OPCODE_Y(opcode);
+    const unsigned n = OPCODE_N(opcode);
+    const unsigned kk = OPCODE_KK(opcode);
+    const unsigned nnn = OPCODE_NNN(opcode);
+
+    switch (instruction->op)
+    {
+    case XOCHIP_OP_SYS:
+        return snprintf(buffer, size, "SYS 0x%03X", nnn);
+    case XOCHIP_OP_CLS:
+        return snprintf(buffer, size, "CLS");
+    case XOCHIP_OP_RET:
+        return snprintf(buffer, size, "RET");
+    case XOCHIP_OP_JP_ADDR:
+        return snprintf(buffer, size, "JP 0x%03X", nnn);
+    case XOCHIP_OP_CALL:
+        return snprintf(buffer, size, "CALL 0x%03X", nnn);
+    case XOCHIP_OP_SE_VX_BYTE:
+        return snprintf(buffer, size, "SE V%X, 0x%02X", x, kk);
+    case XOCHIP_OP_SNE_VX_BYTE:
+        return snprintf(buffer, size, "SNE V%X, 0x%02X", x, kk);
+    case XOCHIP_OP_SE_VX_VY:
+        return snprintf(buffer, size, "SE V%X, V%X", x, y);
+    case XOCHIP_OP_LD_VX_BYTE:
+        return snprintf(buffer, size, "LD V%X, 0x%02X", x, kk);
+    case XOCHIP_OP_ADD_VX_BYTE:
+        return snprintf(buffer, size, "ADD V%X, 0x%02X", x, kk);
+    case XOCHIP_OP_LD_VX_VY:
+        return snprintf(buffer, size, "LD V%X, V%X", x, y);
+    case XOCHIP_OP_OR_VX_VY:
+        return snprintf(buffer, size, "OR V%X, V%X", x, y);
+    case XOCHIP_OP_AND_VX_VY:
+        return snprintf(buffer, size, "AND V%X, V%X", x, y);
+    case XOCHIP_OP_XOR_VX_VY:
+        return snprintf(buffer, size, "XOR V%X, V%X", x, y);
+    case XOCHIP_OP_ADD_VX_VY:
+        return snprintf(buffer, size, "ADD V%X, V%X", x, y);
+    case XOCHIP_OP_SUB_VX_VY:
+        return snprintf(buffer, size, "SUB V%X, V%X", x, y);
+    case XOCHIP_OP_SHR_VX_VY:
+        return snprintf(buffer, size, "SHR V%X, V%X", x, y);
+    case XOCHIP_OP_SUBN_VX_VY:
+        return snprintf(buffer, size, "SUBN V%X, V%X", x, y);
+    case XOCHIP_OP_SHL_VX_VY:
+        return snprintf(buffer, size, "SHL V%X, V%X", x, y);
+    case XOCHIP_OP_SNE_VX_VY:
+        return snprintf(buffer, size, "SNE V%X, V%X", x, y);
+    case XOCHIP_OP_LD_I_ADDR:
+        return snprintf(buffer, size, "LD I, 0x%03X", nnn);
+    case XOCHIP_OP_JP_V0_ADDR:
+        return snprintf(buffer, size, "JP V0, 0x%03X", nnn);
+    case XOCHIP_OP_RND_VX_BYTE:
+        return snprintf(buffer, size, "RND V%X, 0x%02X", x, kk);
+    case XOCHIP_OP_DRW_VX_VY_N:
+    case XOCHIP_OP_DRW_VX_VY_0:
+        return snprintf(buffer, size, "DRW V%X, V%X, %u", x, y, n);
+    case XOCHIP_OP_SKP_VX:
+        return snprintf(buffer, size, "SKP V%X", x);
+    case XOCHIP_OP_SKNP_VX:
+        return snprintf(buffer, size, "SKNP V%X", x);
+    case XOCHIP_OP_LD_VX_DT:
+        return snprintf(buffer, size, "LD V%X, DT", x);
+    case XOCHIP_OP_LD_VX_K:
+        return snprintf(buffer, size, "LD V%X, K", x);
+    case XOCHIP_OP_LD_DT_VX:
+        return snprintf(buffer, size, "LD DT, V%X", x);
+    case XOCHIP_OP_LD_ST_VX:
+        return snprintf(buffer, size, "LD ST, V%X", x);
+    case XOCHIP_OP_ADD_I_VX:
+        return snprintf(buffer, size, "ADD I, V%X", x);
+    case XOCHIP_OP_LD_F_VX:
+        return snprintf(buffer, size, "LD F, V%X", x);
+    case XOCHIP_OP_LD_B_VX:
+        return snprintf(buffer, size, "LD B, V%X", x);
+    case XOCHIP_OP_LD_I_VX:
+        return snprintf(buffer, size, "LD [I], V%X", x);
+    case XOCHIP_OP_LD_VX_I:
+        return snprintf(buffer, size, "LD V%X, [I]", x);
+    case XOCHIP_OP_SCD_N:
+        return snprintf(buffer, size, "SCD %u", n);
+    case XOCHIP_OP_SCU_N:
+        return snprintf(buffer, size, "SCU %u", n);
+    case XOCHIP_OP_SCR:
+        return snprintf(buffer, size, "SCR");
+    case XOCHIP_OP_SCL:
+        return snprintf(buffer, size, "SCL");
+    case XOCHIP_OP_EXIT:
+        return snprintf(buffer, size, "EXIT");
+    case XOCHIP_OP_LOW:
+        return snprintf(buffer, size, "LOW");
+    case XOCHIP_OP_HIGH:
+        return snprintf(buffer, size, "HIGH");
+    case XOCHIP_OP_LD_HF_VX:
+        return snprintf(buffer, size, "LD HF, V%X", x);
+    case XOCHIP_OP_LD_R_VX:
+        return snprintf(buffer, size, "LD R, V%X", x);
+    case XOCHIP_OP_LD_VX_R:
+        return snprintf(buffer, size, "LD V%X, R", x);
+    case XOCHIP_OP_SAVE_VX_VY:
+        return snprintf(buffer, size, "SAVE V%X - V%X", x, y);
+    case XOCHIP_OP_LOAD_VX_VY:
+        return snprintf(buffer, size, "LOAD V%X - V%X", x, y);
+    case XOCHIP_OP_LD_I_LONG:
+        return snprintf(buffer, size, "LD I, 0x%04X", instruction->operand);
+    case XOCHIP_OP_PLANE:
+        return snprintf(buffer, size, "PLANE %u", x);
+    case XOCHIP_OP_AUDIO:
+        return snprintf(buffer, size, "AUDIO");
+    case XOCHIP_OP_LD_PITCH_VX:
+        return snprintf(buffer, size, "PITCH V%X", x);
+    case XOCHIP_OP_INVALID:
+    default:
+        return snprintf(buffer, size, "DW 0x%04X", opcode);
+    }
+}
+
+static bool xochip_is_skip(const xochip_op_t op)
+{
+    switch (op)
+    {
+    case XOCHIP_OP_SE_VX_BYTE:
+    case XOCHIP_OP_SNE_VX_BYTE:
+    case XOCHIP_OP_SE_VX_VY:
+    case XOCHIP_OP_SNE_VX_VY:
+    case XOCHIP_OP_SKP_VX:
+    case XOCHIP_OP_SKNP_VX:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Marks an address as the start of a block, and queues it for the search the first time around
+static void xochip_cfg_add_leader(xochip_cfg_t *cfg, size_t *pending, const xochip_address_t address)
+{
+    if (XOCHIP_BITMAP_TEST(cfg->leaders, address))
+    {
+        return;
+    }
+
+    XOCHIP_BITMAP_SET(cfg->leaders, address);
+    cfg->worklist[(*pending)++] = address;
+}
+
+// Where a skip at address lands when it skips, i.e. past the next instruction, however long that one is
+static xochip_address_t xochip_cfg_skip_target(const uint8_t *rom, const size_t size, const xochip_address_t address)
+{
+    const xochip_address_t next = (xochip_address_t)(address + XOCHIP_OPCODE_SIZE);
+    xochip_instruction_t skipped;
+
+    if (!xochip_disasm_decode(rom, size, next, &skipped))
+    {
+        return (xochip_address_t)(next + XOCHIP_OPCODE_SIZE);
+    }
+
+    return (xochip_address_t)(next + skipped.size);
+}
+
+// Follows straight-line code from a leader, marking instructions as it goes and queueing every branch target
+static void xochip_cfg_walk(xochip_cfg_t *cfg, size_t *pending, const uint8_t *rom, const size_t size,
+                            xochip_address_t address)
+{
+    xochip_instruction_t instruction;
+
+    // ends at the first instruction that doesn't fall through, or when running off the end of the ROM
+    while (xochip_disasm_decode(rom, size, address, &instruction))
+    {
+        // we fell through into code that was already walked from somewhere else, so control flow merges here
+        if (XOCHIP_BITMAP_TEST(cfg->instructions, address))
+        {
+            XOCHIP_BITMAP_SET(cfg->leaders, address);
+            return;
+        }
+
+        XOCHIP_BITMAP_SET(cfg->instructions, address);
+        for (uint8_t byte = 0; byte < instruction.size; ++byte)
+        {
+            const xochip_address_t covered = (xochip_address_t)(address + byte);
+            XOCHIP_BITMAP_SET(cfg->code, covered);
+        }
+
+        const xochip_address_t next = (xochip_address_t)(address + instruction.size);
+
+        switch (instruction.op)
+        {
+        case XOCHIP_OP_JP_ADDR:
+            xochip_cfg_add_leader(cfg, pending, OPCODE_NNN(instruction.opcode));
+            return;
+        case XOCHIP_OP_CALL:
+            XOCHIP_BITMAP_SET(cfg->call_targets, OPCODE_NNN(instruction.opcode));
+            xochip_cfg_add_leader(cfg, pending, OPCODE_NNN(instruction.opcode));
+            xochip_cfg_add_leader(cfg, pending, next);
+            return;
+        case XOCHIP_OP_RET:
+        case XOCHIP_OP_EXIT:
+        case XOCHIP_OP_JP_V0_ADDR:
+        case XOCHIP_OP_INVALID:
+            return;
+        default:
+            break;
+        }
+
+        if (xochip_is_skip(instruction.op))
+        {
+            xochip_cfg_add_leader(cfg, pending, next);
+            xochip_cfg_add_leader(cfg, pending, xochip_cfg_skip_target(rom, size, address));
+            return;
+        }
+
+        address = next;
+    }
+}
+
+// Builds the block starting at a leader by following instructions until the next leader or branch
+static void xochip_cfg_add_block(xochip_cfg_t *cfg, const uint8_t *rom, const size_t size,
+                                 const xochip_address_t leader)
+{
+    if (cfg->block_count >= XOCHIP_CFG_MAX_BLOCKS)
+    {
+        cfg->truncated = true;
+        return;
+    }
+
+    xochip_block_t *block = &cfg->blocks[cfg->block_count++];
+    memset(block, 0, sizeof(*block));
+    block->start = leader;
+
+    if (leader == XOCHIP_ADDRESS_SPACE_START)
+    {
+        block->flags |= XOCHIP_BLOCK_ENTRY;
+    }
+
+    if (XOCHIP_BITMAP_TEST(cfg->call_targets, leader))
+    {
+        block->flags |= XOCHIP_BLOCK_CALL_TARGET;
+    }
+
+    xochip_address_t address = leader;
+    xochip_instruction_t instruction;
+
+    for (;;)
+    {
+        // leaders are always reachable, but their first instruction may not fit in the ROM
+        if (!xochip_disasm_decode(rom, size, address, &instruction))
+        {
+            block->flags |= XOCHIP_BLOCK_INVALID;
+            return;
+        }
+
+        block->last = address;
+        block->instruction_count++;
+
+        const xochip_address_t next = (xochip_address_t)(address + instruction.size);
+
+        switch (instruction.op)
+        {
+        case XOCHIP_OP_JP_ADDR:
+            block->successors[block->successor_count++] = OPCODE_NNN(instruction.opcode);
+            return;
+        case XOCHIP_OP_CALL:
+            block->flags |= XOCHIP_BLOCK_CALL;
+            block->successors[block->successor_count++] = OPCODE_NNN(instruction.opcode);
+            block->successors[block->successor_count++] = next;
+            return;
+        case XOCHIP_OP_RET:
+            block->flags |= XOCHIP_BLOCK_RETURN;
+            return;
+        case XOCHIP_OP_EXIT:
+            block->flags |= XOCHIP_BLOCK_EXIT;
+            return;
+        case XOCHIP_OP_JP_V0_ADDR:
+            block->flags |= XOCHIP_BLOCK_INDIRECT;
+            return;
+        case XOCHIP_OP_INVALID:
+            block->flags |= XOCHIP_BLOCK_INVALID;
+            return;
+        default:
+            break;
+        }
+
+        if (xochip_is_skip(instruction.op))
+        {
+            block->successors[block->successor_count++] = next;
+            block->successors[block->successor_count++] = xochip_cfg_skip_target(rom, size, address);
+            return;
+        }
+
+        if (!XOCHIP_BITMAP_TEST(cfg->instructions, next))
+        {
+            block->flags |= XOCHIP_BLOCK_INVALID; // fell off the end of the ROM
+            return;
+        }
+
+        if (XOCHIP_BITMAP_TEST(cfg->leaders, next))
+        {
+            block->successors[block->successor_count++] = next;
+            return;
+        }
+
+        address = next;
+    }
+}
+
+xochip_result_t xochip_cfg_build(xochip_cfg_t *cfg, const uint8_t *rom, const size_t size)
+{
+    if (!cfg || !rom)
+    {
+        return XOCHIP_ERR_NULL_POINTER;
+    }
+
+    if (size > XOCHIP_ROM_SIZE_MAX)
+    {
+        return XOCHIP_ERR_ROM_TOO_LARGE;
+    }
+
+    memset(cfg->code, 0, sizeof(cfg->code));
+    memset(cfg->instructions, 0, sizeof(cfg->instructions));
+    memset(cfg->leaders, 0, sizeof(cfg->leaders));
+    memset(cfg->call_targets, 0, sizeof(cfg->call_targets));
+    cfg->block_count = 0;
+    cfg->truncated = false;
+
+    // every address is queued at most once, because it's marked as a leader when it's queued
+    size_t pending = 0;
+    xochip_cfg_add_leader(cfg, &pending, XOCHIP_ADDRESS_SPACE_START);
+
+    while (pending > 0)
+    {
+        const xochip_address_t address = cfg->worklist[--pending];
+        xochip_cfg_walk(cfg, &pending, rom, size, address);
+    }
+
+    // all leaders are known now, so blocks can be cut in address order
+    for (uint32_t address = XOCHIP_ADDRESS_SPACE_START; address < XOCHIP_ADDRESS_SPACE_SIZE; ++address)
+    {
+        if (XOCHIP_BITMAP_TEST(cfg->leaders, address) && XOCHIP_BITMAP_TEST(cfg->instructions, address))
+        {
+            xochip_cfg_add_block(cfg, rom, size, (xochip_address_t)address);
+        }
+    }
+
+    return XOCHIP_SUCCESS;
+}
+
+bool xochip_cfg_is_code(const xochip_cfg_t *cfg, const xochip_address_t address)
+{
+    return XOCHIP_BITMAP_TEST(cfg->code, address) != 0;
+}
+
+#endif
+
+#endif // XOCHIP_DISASM_H
@@ -0,0 +1,897 @@
+//
+// Optional vectorized environment for reinforcement learning. Runs a batch of emulators over the same ROM and steps
+// all of them with one call: every instance takes an action (a set of keys held for the whole step), runs a number of
+// frames, and reports a reward read from its RAM, whether its episode ended, and its display. An instance whose
+// episode ended is reset on the spot, so the batch never stalls on one game over.
+//
+// Observations are written straight into the caller's batch tensor, one slot per instance, in the layout the model
+// wants: the packed planes as they are, one byte per pixel and plane, or one colour index byte per pixel, optionally
+// downsampled to 64x32 or 32x16 and stacked with the frames of the previous steps. Unpacking bits into bytes uses
+// SSE2/NEON where available, define XOCHIP_NO_SIMD to force the portable path.
+//
+// Every episode starts from a snapshot taken right after the ROM was loaded. Thanks to the dirty page tracking a reset
+// only copies the memory the game actually wrote, which is what makes auto-reset cheap enough to do in the step.
+//
+// Like xochip.h, include this wherever you need it and define XOCHIP_IMPLEMENTATION in exactly one translation unit.
+//
+
+#ifndef XOCHIP_ENV_H
+#define XOCHIP_ENV_H
+
+#include "xochip.h"
+
+// =====================================================================================================================
+//    DEFINES
+// =====================================================================================================================
+
+// Enough for every key on its own plus a handful of combinations
+#define XOCHIP_ENV_ACTIONS_MAX 32
+
+#define XOCHIP_ENV_REWARDS_MAX 4
+
+// Frames an observation can stack
+#define XOCHIP_ENV_STACK_MAX 4
+
+// Both display planes, packed
+#define XOCHIP_ENV_FRAME_SIZE (2 * (XOCHIP_DISPLAY_PIXELS / 8))
+
+// =====================================================================================================================
+//    TYPES
+// =====================================================================================================================
+
+/**
+ * How a value is read out of the machine. CHIP-8 games keep their score wherever they like, these cover the usual
+ * places.
+ */
+typedef enum xochip_env_value_kind
+{
+    XOCHIP_ENV_VALUE_NONE,     // not used
+    XOCHIP_ENV_VALUE_BYTE,     // memory[address]
+    XOCHIP_ENV_VALUE_WORD,     // memory[address] and memory[address + 1], big endian like the CHIP-8 itself
+    XOCHIP_ENV_VALUE_BCD,      // 3 decimal digits at address, the way Fx33 stores them for drawing
+    XOCHIP_ENV_VALUE_REGISTER, // register V[address & 0xF]
+} xochip_env_value_kind_t;
+
+typedef struct xochip_env_value
+{
+    xochip_env_value_kind_t kind;
+    uint16_t address;
+} xochip_env_value_t;
+
+/**
+ * A reward source. Each step rewards scale times how much the value changed over the step.
+ */
+typedef struct xochip_env_reward
+{
+    xochip_env_value_t value;
+    float scale;
+} xochip_env_reward_t;
+
+/**
+ * Why an instance's episode ended, written to the dones of xochip_env_step.
+ */
+typedef enum xochip_env_status
+{
+    XOCHIP_ENV_RUNNING,    // not done
+    XOCHIP_ENV_TERMINATED, // the done value matched, the ROM exited with 00FD, or it jumped to itself to halt
+    XOCHIP_ENV_TRUNCATED,  // max_frames ran out
+    XOCHIP_ENV_ERROR,      // the emulator returned an error, xochip_env_instance_t.last_result says which
+} xochip_env_status_t;
+
+/**
+ * How an observation frame is laid out. Pixels are row major, planes (where there are two) one after the other.
+ */
+typedef enum xochip_env_layout
+{
+    XOCHIP_ENV_LAYOUT_PACKED, // 1 bit per pixel, MSB first, back plane then fore plane, like xochip_display_t
+    XOCHIP_ENV_LAYOUT_PLANES, // 1 byte per pixel, 0 or 1, back plane then fore plane
+    XOCHIP_ENV_LAYOUT_COLOUR, // 1 byte per pixel, the colour index 0-3: back plane in bit 0, fore plane in bit 1
+} xochip_env_layout_t;
+
+/**
+ * What an observation looks like. All zeros is the packed full display, 2 KB per frame.
+ */
+typedef struct xochip_env_observation
+{
+    xochip_env_layout_t layout;
+    uint8_t downsample; // 1 (or 0) for 128x64, 2 for 64x32, 4 for 32x16
+    bool max_pool;      // a downsampled pixel is set when any pixel of its block is, instead of just the top left one
+    uint8_t stack;      // frames per observation (0 counts as 1), the oldest first, up to XOCHIP_ENV_STACK_MAX
+} xochip_env_observation_t;
+
+/**
+ * Describes the environment, it's copied by xochip_env_init.
+ */
+typedef struct xochip_env_config
+{
+    const uint8_t *rom;        // only read by xochip_env_init
+    size_t rom_size;
+    uint32_t cycles_per_frame; // instructions per 60 Hz frame
+    uint32_t max_frames;       // frames before an episode is truncated, 0 never truncates
+    uint32_t seed;             // Cxkk's seed, mixed with the instance and episode so no two episodes draw alike
+
+    uint8_t action_count;
+    uint16_t actions[XOCHIP_ENV_ACTIONS_MAX]; // XOCHIP_KEY() masks, the keys held while the action is taken
+
+    uint8_t reward_count;
+    xochip_env_reward_t rewards[XOCHIP_ENV_REWARDS_MAX];
+
+    xochip_env_value_t done; // the episode terminates when this reads done_equals, XOCHIP_ENV_VALUE_NONE never does
+    int32_t done_equals;
+
+    xochip_env_observation_t observation;
+} xochip_env_config_t;
+
+/**
+ * One emulator of the batch. Attachments set on machine after xochip_env_init, e.g. a decode cache, survive resets.
+ */
+typedef struct xochip_env_instance
+{
+    xochip_t machine;
+    xochip_scheduler_t scheduler;
+    xochip_result_t result;                 // what the emulator last returned
+    uint32_t episode;                       // episodes started, counting the current one
+    uint32_t frames;                        // frames into the current episode
+    float episode_return;                   // rewards so far in the current episode
+    int32_t values[XOCHIP_ENV_REWARDS_MAX]; // reward values at the end of the last step
+
+    // the packed display at the end of the last steps, a ring for stacking observations
+    uint8_t history[XOCHIP_ENV_STACK_MAX][XOCHIP_ENV_FRAME_SIZE];
+    uint8_t newest; // where in history the last frame is
+
+    // the episode that ended last, for logging since the instance has already been reset when the step returns
+    xochip_env_status_t last_status;
+    xochip_result_t last_result;
+    uint32_t last_frames;
+    float last_return;
+} xochip_env_instance_t;
+
+/**
+ * The environment. The start snapshot makes it about 70 KB, and each instance about as much again, so both usually
+ * want to be static or on the heap.
+ */
+typedef struct xochip_env
+{
+    xochip_env_config_t config;
+    xochip_state_t start;             // every episode starts from here
+    xochip_env_instance_t *instances; // owned by the host
+    uint32_t count;
+    size_t observation_size; // bytes per instance in observations, see xochip_env_observation_size
+} xochip_env_t;
+
+// =====================================================================================================================
+//    API
+// =====================================================================================================================
+
+/**
+ * @brief The size of one observation, frame stack included.
+ * @param observation The observation's description
+ * @return Bytes per observation, or 0 when the description is out of range
+ */
+size_t xochip_env_observation_size(const xochip_env_observation_t *observation);
+
+/**
+ * @brief Export one frame of a display, e.g. to observe a machine that isn't part of an environment.
+ * @param display The display to export
+ * @param observation The layout, its stack is ignored
+ * @param out xochip_env_observation_size bytes of a stack of 1
+ * @return Success or error:
+ * - XOCHIP_SUCCESS when ok
+ * - XOCHIP_ERR_NULL_POINTER when display, observation or out is null
+ * - XOCHIP_ERR_INVALID_ARGUMENT when the description is out of range
+ */
+xochip_result_t xochip_env_export(const xochip_display_t *display, const xochip_env_observation_t *observation,
+                                  uint8_t *out);
+
+/**
+ * @brief Set up an environment and start the first episode of every instance.
+ * @param env The environment to set up
+ * @param config What to run and how to score it
+ * @param instances count instances, initialized here
+ * @param count Number of instances
+ * @return Success or error:
+ * - XOCHIP_SUCCESS when ok
+ * - XOCHIP_ERR_NULL_POINTER when env, config or instances is null, or config->rom is null with a rom_size
+ * - XOCHIP_ERR_INVALID_ARGUMENT when count, cycles_per_frame or action_count is 0, a count is above its maximum, or
+ *   the observation is out of range
+ * - XOCHIP_ERR_ROM_TOO_LARGE when the ROM doesn't fit
+ */
+xochip_result_t xochip_env_init(xochip_env_t *env, const xochip_env_config_t *config, xochip_env_instance_t *instances,
+                                uint32_t count);
+
+/**
+ * @brief Start a new episode on every instance.
+ * @param env An initialized environment
+ * @param observations Optional, count * env->observation_size bytes for the first frame of every instance
+ * @return Success or error:
+ * - XOCHIP_SUCCESS when ok
+ * - XOCHIP_ERR_NULL_POINTER when env is null
+ */
+xochip_result_t xochip_env_reset(xochip_env_t *env, uint8_t *observations);
+
+/**
+ * @brief Step every instance. Instances whose episode ends are reset before this returns, so their observation is
+ * the first frame of the next episode and the reward is the last one of the episode that ended.
+ * @param env An initialized environment
+ * @param actions count indices into config.actions, one per instance
+ * @param frames Frames to run each instance for, holding its action (frame skip)
+ * @param rewards Optional, count rewards
+ * @param dones Optional, count xochip_env_status_t, XOCHIP_ENV_RUNNING unless the episode ended during this step
+ * @param observations Optional, count * env->observation_size bytes for the display of every instance
+ * @return Success or error:
+ * - XOCHIP_SUCCESS when ok, emulator errors only end the episode of their instance
+ * - XOCHIP_ERR_NULL_POINTER when env or actions is null
+ * - XOCHIP_ERR_INVALID_ARGUMENT when frames is 0 or an action is out of range, nothing was stepped
+ */
+xochip_result_t xochip_env_step(xochip_env_t *env, const uint8_t *actions, uint32_t frames, float *rewards,
+                                uint8_t *dones, uint8_t *observations);
+
+// =====================================================================================================================
+//    IMPLEMENTATION
+// =====================================================================================================================
+
+#ifdef XOCHIP_IMPLEMENTATION
+
+#if !defined(XOCHIP_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define XOCHIP_ENV_SSE2
+#include <emmintrin.h>
+#elif !defined(XOCHIP_NO_SIMD) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define XOCHIP_ENV_NEON
+#include <arm_neon.h>
+#endif
+
+static int32_t xochip_env_read(const xochip_t *machine, const xochip_env_value_t *value)
+{
+    const uint16_t address = value->address;
+
+    switch (value->kind)
+    {
+    case XOCHIP_ENV_VALUE_BYTE:
+        return xochip_peek(machine, address);
+    case XOCHIP_ENV_VALUE_WORD:
+        return (int32_t)(xochip_peek(machine, address) << 8 | xochip_peek(machine, (uint16_t)(address + 1)));
+    case XOCHIP_ENV_VALUE_BCD:
+        return xochip_peek(machine, address) * 100 + xochip_peek(machine, (uint16_t)(address + 1)) * 10 +
+               xochip_peek(machine, (uint16_t)(address + 2));
+    case XOCHIP_ENV_VALUE_REGISTER:
+        return machine->registers[address & 0xF];
+    case XOCHIP_ENV_VALUE_NONE:
+    default:
+        return 0;
+    }
+}
+
+static uint8_t xochip_env_factor(const xochip_env_observation_t *observation)
+{
+    return observation->downsample ? observation->downsample : 1;
+}
+
+static uint8_t xochip_env_stack(const xochip_env_observation_t *observation)
+{
+    return observation->stack ? observation->stack : 1;
+}
+
+// Downsampling shrinks a row of factor x factor blocks of a plane to one packed bit per block, that's
+// XOCHIP_DISPLAY_ROW_BYTES / factor bytes. Pooling ORs the block's rows together, then ORs every bit into the first one
+// of its block. The first bits of the blocks are then squeezed together with shifts and masks, 4 (factor 2) or 2
+// (factor 4) bits per input byte. The SIMD shifts work on 16 bit lanes, the masks drop whatever crosses between bytes.
+
+#if defined(XOCHIP_ENV_SSE2)
+
+static void xochip_env_reduce(const uint8_t *plane, const uint32_t y, const uint8_t factor, const bool max_pool,
+                              uint8_t *out)
+{
+    const uint8_t *row = plane + y * factor * XOCHIP_DISPLAY_ROW_BYTES;
+    __m128i pixels = _mm_loadu_si128((const __m128i *)row);
+    if (max_pool)
+    {
+        for (uint8_t below = 1; below < factor; ++below)
+        {
+            pixels = _mm_or_si128(pixels, _mm_loadu_si128((const __m128i *)(row + below * XOCHIP_DISPLAY_ROW_BYTES)));
+        }
+    }
+
+    if (factor == 2)
+    {
+        if (max_pool)
+        {
+            pixels = _mm_or_si128(pixels, _mm_slli_epi16(pixels, 1));
+        }
+        pixels = _mm_and_si128(_mm_srli_epi16(pixels, 1), _mm_set1_epi8(0x55));
+        pixels = _mm_and_si128(_mm_or_si128(pixels, _mm_srli_epi16(pixels, 1)), _mm_set1_epi8(0x33));
+        pixels = _mm_and_si128(_mm_or_si128(pixels, _mm_srli_epi16(pixels, 2)), _mm_set1_epi8(0x0F));
+
+        // nibble pairs to bytes
+        pixels = _mm_or_si128(_mm_slli_epi16(pixels, 4), _mm_srli_epi16(pixels, 8));
+        pixels = _mm_and_si128(pixels, _mm_set1_epi16(0x00FF));
+        _mm_storel_epi64((__m128i *)out, _mm_packus_epi16(pixels, pixels));
+    }
+    else
+    {
+        if (max_pool)
+        {
+            pixels = _mm_or_si128(pixels, _mm_slli_epi16(pixels, 1));
+            pixels = _mm_or_si128(pixels, _mm_slli_epi16(pixels, 2));
+        }
+        pixels = _mm_and_si128(_mm_srli_epi16(pixels, 3), _mm_set1_epi8(0x11));
+        pixels = _mm_and_si128(_mm_or_si128(pixels, _mm_srli_epi16(pixels, 3)), _mm_set1_epi8(0x03));
+
+        // 2 bit pairs to nibbles, then nibble pairs to bytes
+        pixels = _mm_or_si128(_mm_slli_epi16(pixels, 2), _mm_srli_epi16(pixels, 8));
+        pixels = _mm_and_si128(pixels, _mm_set1_epi16(0x000F));
+        pixels = _mm_packus_epi16(pixels, pixels);
+        pixels = _mm_or_si128(_mm_slli_epi16(pixels, 4), _mm_srli_epi16(pixels, 8));
+        pixels = _mm_and_si128(pixels, _mm_set1_epi16(0x00FF));
+        const uint32_t packed = (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(pixels, pixels));
+        memcpy(out, &packed, sizeof(packed));
+    }
+}
+
+// 2 packed bytes to 16 lanes, 0xFF where the pixel is set
+static inline __m128i xochip_env_spread(const uint8_t *packed)
+{
+    const __m128i bits = _mm_set_epi8(1, 2, 4, 8, 16, 32, 64, (char)0x80, 1, 2, 4, 8, 16, 32, 64, (char)0x80);
+    __m128i lanes = _mm_cvtsi32_si128(packed[0] | packed[1] << 8);
+    lanes = _mm_unpacklo_epi8(lanes, lanes);
+    lanes = _mm_unpacklo_epi16(lanes, lanes);
+    lanes = _mm_unpacklo_epi32(lanes, lanes);
+    return _mm_cmpeq_epi8(_mm_and_si128(lanes, bits), bits);
+}
+
+static void xochip_env_unpack(const uint8_t *packed, const uint32_t bytes, uint8_t *out)
+{
+    const __m128i one = _mm_set1_epi8(1);
+    for (uint32_t byte = 0; byte < bytes; byte += 2)
+    {
+        _mm_storeu_si128((__m128i *)(out + byte * 8), _mm_and_si128(xochip_env_spread(packed + byte), one));
+    }
+}
+
+static void xochip_env_unpack_colour(const uint8_t *back, const uint8_t *fore, const uint32_t bytes, uint8_t *out)
+{
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i two = _mm_set1_epi8(2);
+    for (uint32_t byte = 0; byte < bytes; byte += 2)
+    {
+        const __m128i colour = _mm_or_si128(_mm_and_si128(xochip_env_spread(back + byte), one),
+                                            _mm_and_si128(xochip_env_spread(fore + byte), two));
+        _mm_storeu_si128((__m128i *)(out + byte * 8), colour);
+    }
+}
+
+#elif defined(XOCHIP_ENV_NEON)
+
+static void xochip_env_reduce(const uint8_t *plane, const uint32_t y, const uint8_t factor, const bool max_pool,
+                              uint8_t *out)
+{
+    const uint8_t *row = plane + y * factor * XOCHIP_DISPLAY_ROW_BYTES;
+    uint8x16_t merged = vld1q_u8(row);
+    if (max_pool)
+    {
+        for (uint8_t below = 1; below < factor; ++below)
+        {
+            merged = vorrq_u8(merged, vld1q_u8(row + below * XOCHIP_DISPLAY_ROW_BYTES));
+        }
+    }
+
+    uint16x8_t pixels = vreinterpretq_u16_u8(merged);
+    if (factor == 2)
+    {
+        if (max_pool)
+        {
+            pixels = vorrq_u16(pixels, vshlq_n_u16(pixels, 1));
+        }
+        pixels = vandq_u16(vshrq_n_u16(pixels, 1), vdupq_n_u16(0x5555));
+        pixels = vandq_u16(vorrq_u16(pixels, vshrq_n_u16(pixels, 1)), vdupq_n_u16(0x3333));
+        pixels = vandq_u16(vorrq_u16(pixels, vshrq_n_u16(pixels, 2)), vdupq_n_u16(0x0F0F));
+
+        // nibble pairs to bytes
+        pixels = vorrq_u16(vshlq_n_u16(pixels, 4), vshrq_n_u16(pixels, 8));
+        vst1_u8(out, vmovn_u16(pixels));
+    }
+    else
+    {
+        if (max_pool)
+        {
+            pixels = vorrq_u16(pixels, vshlq_n_u16(pixels, 1));
+            pixels = vorrq_u16(pixels, vshlq_n_u16(pixels, 2));
+        }
+        pixels = vandq_u16(vshrq_n_u16(pixels, 3), vdupq_n_u16(0x1111));
+        pixels = vandq_u16(vorrq_u16(pixels, vshrq_n_u16(pixels, 3)), vdupq_n_u16(0x0303));
+
+        // 2 bit pairs to nibbles, then nibble pairs to bytes
+        pixels = vorrq_u16(vshlq_n_u16(pixels, 2), vshrq_n_u16(pixels, 8));
+        uint16x4_t nibbles = vreinterpret_u16_u8(vmovn_u16(pixels));
+        nibbles = vorr_u16(vshl_n_u16(nibbles, 4), vshr_n_u16(nibbles, 8));
+
+        uint8_t packed[8];
+        vst1_u8(packed, vmovn_u16(vcombine_u16(nibbles, nibbles)));
+        memcpy(out, packed, 4);
+    }
+}
+
+static inline uint8x16_t xochip_env_spread(const uint8_t *packed)
+{
+    static const uint8_t lanes[16] = {0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+                                      0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01};
+    return vtstq_u8(vcombine_u8(vdup_n_u8(packed[0]), vdup_n_u8(packed[1])), vld1q_u8(lanes));
+}
+
+static void xochip_env_unpack(const uint8_t *packed, const uint32_t bytes, uint8_t *out)
+{
+    const uint8x16_t one = vdupq_n_u8(1);
+    for (uint32_t byte = 0; byte < bytes; byte += 2)
+    {
+        vst1q_u8(out + byte * 8, vandq_u8(xochip_env_spread(packed + byte), one));
+    }
+}
+
+static void xochip_env_unpack_colour(const uint8_t *back, const uint8_t *fore, const uint32_t bytes, uint8_t *out)
+{
+    const uint8x16_t one = vdupq_n_u8(1);
+    const uint8x16_t two = vdupq_n_u8(2);
+    for (uint32_t byte = 0; byte < bytes; byte += 2)
+    {
+        const uint8x16_t colour = vorrq_u8(vandq_u8(xochip_env_spread(back + byte), one),
+                                           vandq_u8(xochip_env_spread(fore + byte), two));
+        vst1q_u8(out + byte * 8, colour);
+    }
+}
+
+#else
+
+static void xochip_env_reduce(const uint8_t *plane, const uint32_t y, const uint8_t factor, const bool max_pool,
+                              uint8_t *out)
+{
+    const uint8_t *row = plane + y * factor * XOCHIP_DISPLAY_ROW_BYTES;
+    uint8_t merged[XOCHIP_DISPLAY_ROW_BYTES];
+    memcpy(merged, row, sizeof(merged));
+
+    if (max_pool)
+    {
+        for (uint8_t below = 1; below < factor; ++below)
+        {
+            for (uint8_t byte = 0; byte < XOCHIP_DISPLAY_ROW_BYTES; ++byte)
+            {
+                merged[byte] |= row[below * XOCHIP_DISPLAY_ROW_BYTES + byte];
+            }
+        }
+    }
+
+    const uint8_t inputs = factor; // bytes per output byte
+    for (uint8_t byte = 0; byte < XOCHIP_DISPLAY_ROW_BYTES / factor; ++byte)
+    {
+        uint32_t packed = 0;
+        for (uint8_t input = 0; input < inputs; ++input)
+        {
+            uint32_t pixels = merged[byte * inputs + input];
+            if (factor == 2)
+            {
+                pixels |= max_pool ? pixels << 1 : 0;
+                pixels = (pixels >> 1) & 0x55; // bits 7, 5, 3, 1 to 6, 4, 2, 0
+                pixels = (pixels | pixels >> 1) & 0x33;
+                packed = packed << 4 | ((pixels | pixels >> 2) & 0x0F);
+            }
+            else
+            {
+                pixels |= max_pool ? pixels << 1 : 0;
+                pixels |= max_pool ? pixels << 2 : 0;
+                pixels = (pixels >> 3) & 0x11; // bits 7, 3 to 4, 0
+                packed = packed << 2 | ((pixels | pixels >> 3) & 0x03);
+            }
+        }
+        out[byte] = (uint8_t)packed;
+    }
+}
+
+// Each nibble's 4 pixels, one byte each
+static const uint8_t xochip_env_nibbles[16][4] = {
+    {0, 0, 0, 0}, {0, 0, 0, 1}, {0, 0, 1, 0}, {0, 0, 1, 1}, {0, 1, 0, 0}, {0, 1, 0, 1}, {0, 1, 1, 0}, {0, 1, 1, 1},
+    {1, 0, 0, 0}, {1, 0, 0, 1}, {1, 0, 1, 0}, {1, 0, 1, 1}, {1, 1, 0, 0}, {1, 1, 0, 1}, {1, 1, 1, 0}, {1, 1, 1, 1},
+};
+
+static void xochip_env_unpack(const uint8_t *packed, const uint32_t bytes, uint8_t *out)
+{
+    for (uint32_t byte = 0; byte < bytes; ++byte, out += 8)
+    {
+        memcpy(out, xochip_env_nibbles[packed[byte] >> 4], 4);
+        memcpy(out + 4, xochip_env_nibbles[packed[byte] & 0x0F], 4);
+    }
+}
+
+static void xochip_env_unpack_colour(const uint8_t *back, const uint8_t *fore, const uint32_t bytes, uint8_t *out)
+{
+    for (uint32_t byte = 0; byte < bytes; ++byte)
+    {
+        for (uint8_t half = 0; half < 2; ++half, out += 4)
+        {
+            const uint8_t shift = half ? 0 : 4;
+            uint32_t back_pixels;
+            uint32_t fore_pixels;
+            memcpy(&back_pixels, xochip_env_nibbles[(back[byte] >> shift) & 0x0F], 4);
+            memcpy(&fore_pixels, xochip_env_nibbles[(fore[byte] >> shift) & 0x0F], 4);
+
+            // every byte is 0 or 1, so the shift can't carry into the next one
+            const uint32_t colours = back_pixels | fore_pixels << 1;
+            memcpy(out, &colours, 4);
+        }
+    }
+}
+
+#endif
+
+// Writes one frame in the observation's layout and returns how many bytes that took
+static size_t xochip_env_write_frame(const uint8_t *back, const uint8_t *fore,
+                                     const xochip_env_observation_t *observation, uint8_t *out)
+{
+    const uint8_t factor = xochip_env_factor(observation);
+    const uint32_t width = XOCHIP_DISPLAY_WIDTH / factor;
+    const uint32_t height = XOCHIP_DISPLAY_HEIGHT / factor;
+    const uint32_t row_bytes = XOCHIP_DISPLAY_ROW_BYTES / factor;
+    const size_t plane_size = observation->layout == XOCHIP_ENV_LAYOUT_PACKED ? row_bytes * height : width * height;
+
+    uint8_t reduced[2][XOCHIP_DISPLAY_ROW_BYTES];
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        const uint8_t *back_row = back + y * XOCHIP_DISPLAY_ROW_BYTES;
+        const uint8_t *fore_row = fore + y * XOCHIP_DISPLAY_ROW_BYTES;
+        if (factor > 1)
+        {
+            xochip_env_reduce(back, y, factor, observation->max_pool, reduced[0]);
+            xochip_env_reduce(fore, y, factor, observation->max_pool, reduced[1]);
+            back_row = reduced[0];
+            fore_row = reduced[1];
+        }
+
+        switch (observation->layout)
+        {
+        case XOCHIP_ENV_LAYOUT_PACKED:
+            memcpy(out + y * row_bytes, back_row, row_bytes);
+            memcpy(out + plane_size + y * row_bytes, fore_row, row_bytes);
+            break;
+        case XOCHIP_ENV_LAYOUT_PLANES:
+            xochip_env_unpack(back_row, row_bytes, out + y * width);
+            xochip_env_unpack(fore_row, row_bytes, out + plane_size + y * width);
+            break;
+        case XOCHIP_ENV_LAYOUT_COLOUR:
+        default:
+            xochip_env_unpack_colour(back_row, fore_row, row_bytes, out + y * width);
+            break;
+        }
+    }
+
+    return observation->layout == XOCHIP_ENV_LAYOUT_COLOUR ? plane_size : 2 * plane_size;
+}
+
+// Writes the display as the 128x64 picture, a low resolution one is doubled first
+static size_t xochip_env_write_display(const xochip_display_t *display, const xochip_env_observation_t *observation,
+                                       uint8_t *out)
+{
+    if (display->hires)
+    {
+        return xochip_env_write_frame(display->back_plane, display->fore_plane, observation, out);
+    }
+
+    uint8_t frame[XOCHIP_ENV_FRAME_SIZE];
+    xochip_display_expand(display, frame, frame + XOCHIP_ENV_FRAME_SIZE / 2);
+    return xochip_env_write_frame(frame, frame + XOCHIP_ENV_FRAME_SIZE / 2, observation, out);
+}
+
+// Keeps the display for stacking, only needed when observations stack more than one frame
+static void xochip_env_remember(const xochip_env_t *env, xochip_env_instance_t *instance)
+{
+    if (xochip_env_stack(&env->config.observation) > 1)
+    {
+        const xochip_display_t *display = &instance->machine.display;
+        instance->newest = (uint8_t)((instance->newest + 1) % XOCHIP_ENV_STACK_MAX);
+        xochip_display_expand(display, instance->history[instance->newest],
+                              instance->history[instance->newest] + XOCHIP_ENV_FRAME_SIZE / 2);
+    }
+}
+
+// Writes the observation, the oldest stacked frame first
+static void xochip_env_observe(const xochip_env_t *env, const xochip_env_instance_t *instance, uint8_t *out)
+{
+    const xochip_env_observation_t *observation = &env->config.observation;
+    const uint8_t stack = xochip_env_stack(observation);
+
+    if (stack == 1)
+    {
+        xochip_env_write_display(&instance->machine.display, observation, out);
+        return;
+    }
+
+    for (uint8_t frame = 0; frame < stack; ++frame)
+    {
+        const uint8_t *history = instance->history[(instance->newest + XOCHIP_ENV_STACK_MAX - (stack - 1 - frame)) %
+                                                   XOCHIP_ENV_STACK_MAX];
+        out += xochip_env_write_frame(history, history + XOCHIP_ENV_FRAME_SIZE / 2, observation, out);
+    }
+}
+
+// A jump to itself is how most CHIP-8 games stop for good, there's nothing left to run after it
+static bool xochip_env_halted(const xochip_t *machine)
+{
+    const uint16_t counter = machine->counter;
+    const uint16_t opcode =
+        (uint16_t)(xochip_peek(machine, counter) << 8 | xochip_peek(machine, (uint16_t)(counter + 1)));
+    return xochip_decode(opcode) == XOCHIP_OP_JP_ADDR && OPCODE_NNN(opcode) == counter;
+}
+
+static void xochip_env_start(xochip_env_t *env, const uint32_t index)
+{
+    xochip_env_instance_t *instance = &env->instances[index];
+
+    xochip_load_state(&instance->machine, &env->start);
+    instance->episode++;
+    const uint32_t seed = env->config.seed ^ (index * 0x9E3779B9u) ^ (instance->episode * 0x85EBCA6Bu);
+    xochip_seed_random(&instance->machine, seed);
+    xochip_scheduler_init(&instance->scheduler, env->config.cycles_per_frame, 0);
+    instance->result = XOCHIP_SUCCESS;
+    instance->frames = 0;
+    instance->episode_return = 0.0f;
+
+    for (uint8_t reward = 0; reward < env->config.reward_count; ++reward)
+    {
+        instance->values[reward] = xochip_env_read(&instance->machine, &env->config.rewards[reward].value);
+    }
+
+    // there's nothing before the first frame, so it fills the whole stack
+    for (uint8_t frame = 0; frame < xochip_env_stack(&env->config.observation); ++frame)
+    {
+        xochip_env_remember(env, instance);
+    }
+}
+
+// Runs one frame, up to the next timer tick, and tells whether the episode is over
+static xochip_env_status_t xochip_env_frame(const xochip_env_t *env, xochip_env_instance_t *instance)
+{
+    xochip_t *machine = &instance->machine;
+    xochip_scheduler_t *scheduler = &instance->scheduler;
+
+    const uint64_t ticks = scheduler->ticks;
+    xochip_result_t result = XOCHIP_SUCCESS;
+    while (result == XOCHIP_SUCCESS && scheduler->ticks == ticks)
+    {
+        result = xochip_run_budget(machine, scheduler, scheduler->cycles_per_tick - scheduler->tick_phase, NULL, NULL);
+    }
+
+    instance->result = result;
+    instance->frames++;
+
+    if (result == XOCHIP_EXITED)
+    {
+        return XOCHIP_ENV_TERMINATED;
+    }
+    if (result != XOCHIP_SUCCESS)
+    {
+        return XOCHIP_ENV_ERROR;
+    }
+    if (env->config.done.kind != XOCHIP_ENV_VALUE_NONE &&
+        xochip_env_read(machine, &env->config.done) == env->config.done_equals)
+    {
+        return XOCHIP_ENV_TERMINATED;
+    }
+    if (xochip_env_halted(machine))
+    {
+        return XOCHIP_ENV_TERMINATED;
+    }
+    if (env->config.max_frames && instance->frames >= env->config.max_frames)
+    {
+        return XOCHIP_ENV_TRUNCATED;
+    }
+    return XOCHIP_ENV_RUNNING;
+}
+
+size_t xochip_env_observation_size(const xochip_env_observation_t *observation)
+{
+    if (!observation)
+    {
+        return 0;
+    }
+
+    const uint8_t factor = xochip_env_factor(observation);
+    if ((factor != 1 && factor != 2 && factor != 4) || observation->stack > XOCHIP_ENV_STACK_MAX)
+    {
+        return 0;
+    }
+
+    const size_t pixels = XOCHIP_DISPLAY_PIXELS / (factor * factor);
+    size_t frame = 0;
+    switch (observation->layout)
+    {
+    case XOCHIP_ENV_LAYOUT_PACKED:
+        frame = 2 * pixels / 8;
+        break;
+    case XOCHIP_ENV_LAYOUT_PLANES:
+        frame = 2 * pixels;
+        break;
+    case XOCHIP_ENV_LAYOUT_COLOUR:
+        frame = pixels;
+        break;
+    default:
+        return 0;
+    }
+
+    return frame * xochip_env_stack(observation);
+}
+
+xochip_result_t xochip_env_export(const xochip_display_t *display, const xochip_env_observation_t *observation,
+                                  uint8_t *out)
+{
+    if (!display || !observation || !out)
+    {
+        return XOCHIP_ERR_NULL_POINTER;
+    }
+
+    if (xochip_env_observation_size(observation) == 0)
+    {
+        return XOCHIP_ERR_INVALID_ARGUMENT;
+    }
+
+    xochip_env_write_display(display, observation, out);
+    return XOCHIP_SUCCESS;
+}
+
+xochip_result_t xochip_env_init(xochip_env_t *env, const xochip_env_config_t *config, xochip_env_instance_t *instances,
+                                const uint32_t count)
+{
+    if (!env || !config || !instances || (!config->rom && config->rom_size > 0))
+    {
+        return XOCHIP_ERR_NULL_POINTER;
+    }
+
+    if (count == 0 || config->cycles_per_frame == 0 || config->action_count == 0 ||
+        config->action_count > XOCHIP_ENV_ACTIONS_MAX || config->reward_count > XOCHIP_ENV_REWARDS_MAX ||
+        xochip_env_observation_size(&config->observation) == 0)
+    {
+        return XOCHIP_ERR_INVALID_ARGUMENT;
+    }
+
+    env->config = *config;
+    env->config.rom = NULL;
+    env->instances = instances;
+    env->count = count;
+    env->observation_size = xochip_env_observation_size(&config->observation);
+
+    // the first instance doubles as scratch space to build the start snapshot in
+    xochip_t *machine = &instances[0].machine;
+    xochip_init(machine);
+    const xochip_result_t result = xochip_load_rom(machine, config->rom, config->rom_size);
+    if (result != XOCHIP_SUCCESS)
+    {
+        return result;
+    }
+    xochip_save_state(machine, &env->start);
+
+    for (uint32_t index = 0; index < count; ++index)
+    {
+        xochip_env_instance_t *instance = &instances[index];
+        if (index > 0)
+        {
+            xochip_init(&instance->machine);
+        }
+        instance->episode = 0;
+        instance->newest = 0;
+        instance->last_status = XOCHIP_ENV_RUNNING;
+        instance->last_result = XOCHIP_SUCCESS;
+        instance->last_frames = 0;
+        instance->last_return = 0.0f;
+        xochip_env_start(env, index);
+    }
+
+    return XOCHIP_SUCCESS;
+}
+
+xochip_result_t xochip_env_reset(xochip_env_t *env, uint8_t *observations)
+{
+    if (!env)
+    {
+        return XOCHIP_ERR_NULL_POINTER;
+    }
+
+    for (uint32_t index = 0; index < env->count; ++index)
+    {
+        xochip_env_start(env, index);
+        if (observations)
+        {
+            xochip_env_observe(env, &env->instances[index], observations + index * env->observation_size);
+        }
+    }
+
+    return XOCHIP_SUCCESS;
+}
+
+xochip_result_t xochip_env_step(xochip_env_t *env, const uint8_t *actions, const uint32_t frames, float *rewards,
+                                uint8_t *dones, uint8_t *observations)
+{
+    if (!env || !actions)
+    {
+        return XOCHIP_ERR_NULL_POINTER;
+    }
+
+    if (frames == 0)
+    {
+        return XOCHIP_ERR_INVALID_ARGUMENT;
+    }
+
+    // checked up front, so a bad batch doesn't leave half the instances stepped
+    for (uint32_t index = 0; index < env->count; ++index)
+    {
+        if (actions[index] >= env->config.action_count)
+        {
+            return XOCHIP_ERR_INVALID_ARGUMENT;
+        }
+    }
+
+    for (uint32_t index = 0; index < env->count; ++index)
+    {
+        xochip_env_instance_t *instance = &env->instances[index];
+        xochip_t *machine = &instance->machine;
+
+        // only keys that change go through key_up/key_down, so a held key isn't released and pressed again
+        const uint16_t keys = env->config.actions[actions[index]];
+        const uint16_t changed = machine->pressed_keys ^ keys;
+        for (uint8_t key = 0; key < XOCHIP_KEYCOUNT; ++key)
+        {
+            if (changed & XOCHIP_KEY(key))
+            {
+                if (keys & XOCHIP_KEY(key))
+                {
+                    xochip_key_down(machine, (xochip_keys_t)key);
+                }
+                else
+                {
+                    xochip_key_up(machine, (xochip_keys_t)key);
+                }
+            }
+        }
+
+        xochip_env_status_t status = XOCHIP_ENV_RUNNING;
+        for (uint32_t frame = 0; frame < frames && status == XOCHIP_ENV_RUNNING; ++frame)
+        {
+            status = xochip_env_frame(env, instance);
+        }
+
+        float reward = 0.0f;
+        for (uint8_t source = 0; source < env->config.reward_count; ++source)
+        {
+            const int32_t value = xochip_env_read(machine, &env->config.rewards[source].value);
+            reward += env->config.rewards[source].scale * (float)(value - instance->values[source]);
+            instance->values[source] = value;
+        }
+        instance->episode_return += reward;
+
+        if (status != XOCHIP_ENV_RUNNING)
+        {
+            instance->last_status = status;
+            instance->last_result = instance->result;
+            instance->last_frames = instance->frames;
+            instance->last_return = instance->episode_return;
+            xochip_env_start(env, index);
+        }
+        else
+        {
+            xochip_env_remember(env, instance);
+        }
+
+        if (rewards)
+        {
+            rewards[index] = reward;
+        }
+        if (dones)
+        {
+            dones[index] = (uint8_t)status;
+        }
+        if (observations)
+        {
+            xochip_env_observe(env, instance, observations + index * env->observation_size);
+        }
+    }
+
+    return XOCHIP_SUCCESS;
+}
+
+#endif
+
+#endif // XOCHIP_ENV_H
@@ -0,0 +1,255 @@
+//
+// Optional ROM file loading for desktop and headless hosts. The file is memory mapped (mmap on POSIX, file mappings on
+// Windows) and copied straight into the emulator, so there's no heap copy of the ROM and every instance launched from
+// the same file shares the OS page cache. Platforms without either get a plain stdio fallback.
+//
+// Like xochip.h, include this wherever you need it and define XOCHIP_IMPLEMENTATION in exactly one translation unit.
+//
+
+#ifndef XOCHIP_FILE_H
+#define XOCHIP_FILE_H
+
+#include "xochip.h"
+
+// =====================================================================================================================
+//    TYPES
+// =====================================================================================================================
+
+/**
+ * A read-only view of a ROM file. data/size are public, the rest belongs to the platform.
+ */
+typedef struct xochip_rom_file
+{
+    const uint8_t *data;
+    size_t size;
+    void *handle; // mapping handle on Windows, heap buffer for the stdio fallback
+} xochip_rom_file_t;
+
+// =====================================================================================================================
+//    API
+// =====================================================================================================================
+
+/**
+ * @brief Map a ROM file into memory read-only. Release it with xochip_unmap_rom_file when you're done with it.
+ * @param path Path to the ROM
+ * @param file Receives the mapped data
+ * @return Success or error:
+ * - XOCHIP_SUCCESS when ok
+ * - XOCHIP_ERR_NULL_POINTER when path or file is null
+ * - XOCHIP_ERR_READ when the file can't be opened or mapped
+ * - XOCHIP_ERR_ROM_TOO_LARGE when the file is larger than XOCHIP_ROM_SIZE_MAX
+ */
+xochip_result_t xochip_map_rom_file(const char *path, xochip_rom_file_t *file);
+
+/**
+ * @brief Release a file mapped with xochip_map_rom_file. Safe to call on an already released file.
+ * @param file The file to release
+ */
+void xochip_unmap_rom_file(xochip_rom_file_t *file);
+
+#ifndef XOCHIP_XIP
+/**
+ * @brief Map a ROM file, load it with xochip_load_rom and release the mapping again. Not in XOCHIP_XIP builds, where
+ * the ROM is read from the mapping, so keep one from xochip_map_rom_file around instead.
+ * @param emulator A non-null pointer to an emulator
+ * @param path Path to the ROM
+ * @return Success or error, see xochip_map_rom_file and xochip_load_rom
+ */
+xochip_result_t xochip_load_rom_file(xochip_t *emulator, const char *path);
+#endif
+
+// =====================================================================================================================
+//    IMPLEMENTATION
+// =====================================================================================================================
+
+#ifdef XOCHIP_IMPLEMENTATION
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#endif
+
+xochip_result_t xochip_map_rom_file(const char *path, xochip_rom_file_t *file)
+{
+    if (!path || !file)
+    {
+        return XOCHIP_ERR_NULL_POINTER;
+    }
+
+    file->data = NULL;
+    file->size = 0;
+    file->handle = NULL;
+
+#if defined(_WIN32)
+    HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        return XOCHIP_ERR_READ;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size))
+    {
+        CloseHandle(handle);
+        return XOCHIP_ERR_READ;
+    }
+
+    if (size.QuadPart > XOCHIP_ROM_SIZE_MAX)
+    {
+        CloseHandle(handle);
+        return XOCHIP_ERR_ROM_TOO_LARGE;
+    }
+
+    // an empty file can't be mapped, but it's a valid (if boring) ROM
+    if (size.QuadPart == 0)
+    {
+        CloseHandle(handle);
+        return XOCHIP_SUCCESS;
+    }
+
+    HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(handle); // the mapping keeps the file open
+    if (!mapping)
+    {
+        return XOCHIP_ERR_READ;
+    }
+
+    const void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view)
+    {
+        CloseHandle(mapping);
+        return XOCHIP_ERR_READ;
+    }
+
+    file->data = view;
+    file->size = (size_t)size.QuadPart;
+    file->handle = mapping;
+    return XOCHIP_SUCCESS;
+#elif defined(__unix__) || defined(__APPLE__)
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return XOCHIP_ERR_READ;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        close(fd);
+        return XOCHIP_ERR_READ;
+    }
+
+    if (info.st_size > XOCHIP_ROM_SIZE_MAX)
+    {
+        close(fd);
+        return XOCHIP_ERR_ROM_TOO_LARGE;
+    }
+
+    // an empty file can't be mapped, but it's a valid (if boring) ROM
+    if (info.st_size == 0)
+    {
+        close(fd);
+        return XOCHIP_SUCCESS;
+    }
+
+    void *view = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file open
+    if (view == MAP_FAILED)
+    {
+        return XOCHIP_ERR_READ;
+    }
+
+    file->data = view;
+    file->size = (size_t)info.st_size;
+    return XOCHIP_SUCCESS;
+#else
+    FILE *stream = fopen(path, "rb");
+    if (!stream)
+    {
+        return XOCHIP_ERR_READ;
+    }
+
+    // read one byte past the limit so oversized files are caught without seeking
+    uint8_t *buffer = malloc(XOCHIP_ROM_SIZE_MAX + 1);
+    if (!buffer)
+    {
+        fclose(stream);
+        return XOCHIP_ERR_READ;
+    }
+
+    const size_t size = fread(buffer, 1, XOCHIP_ROM_SIZE_MAX + 1, stream);
+    const bool failed = ferror(stream) != 0;
+    fclose(stream);
+
+    if (failed || size > XOCHIP_ROM_SIZE_MAX)
+    {
+        free(buffer);
+        return failed ? XOCHIP_ERR_READ : XOCHIP_ERR_ROM_TOO_LARGE;
+    }
+
+    file->data = buffer;
+    file->size = size;
+    file->handle = buffer;
+    return XOCHIP_SUCCESS;
+#endif
+}
+
+void xochip_unmap_rom_file(xochip_rom_file_t *file)
+{
+    if (!file)
+    {
+        return;
+    }
+
+#if defined(_WIN32)
+    if (file->data)
+    {
+        UnmapViewOfFile(file->data);
+        CloseHandle(file->handle);
+    }
+#elif defined(__unix__) || defined(__APPLE__)
+    if (file->data)
+    {
+        munmap((void *)file->data, file->size);
+    }
+#else
+    free(file->handle);
+#endif
+
+    file->data = NULL;
+    file->size = 0;
+    file->handle = NULL;
+}
+
+#ifndef XOCHIP_XIP
+xochip_result_t xochip_load_rom_file(xochip_t *emulator, const char *path)
+{
+    if (!emulator)
+    {
+        return XOCHIP_ERR_NULL_POINTER;
+    }
+
+    xochip_rom_file_t file;
+    const xochip_result_t map_result = xochip_map_rom_file(path, &file);
+    if (map_result != XOCHIP_SUCCESS)
+    {
+        return map_result;
+    }
+
+    const xochip_result_t load_result = xochip_load_rom(emulator, file.data, file.size);
+    xochip_unmap_rom_file(&file);
+    return load_result;
+}
+#endif
+
+#endif
+
+#endif // XOCHIP_FILE_H
@@ -0,0 +1,489 @@
+//
+// Optional framebuffer exporters. Converts the two packed display planes into the pixel formats panels and textures
+// actually want, with a 4 colour palette and integer scaling. Conversion is table-driven: a nibble of each plane indexes
+// a table holding the 4 finished pixels, and on SSE2/NEON targets the 16 and 32 bit formats are converted 8 pixels at a
+// time with compare-and-select instead. Only rows flagged in the dirty mask are touched, so a host pushing to an SPI
+// panel can convert and send just what changed.
+//
+// Like xochip.h, include this wherever you need it and define XOCHIP_IMPLEMENTATION in exactly one translation unit.
+// Define XOCHIP_NO_SIMD to force the portable path.
+//
+
+#ifndef XOCHIP_PIXELS_H
+#define XOCHIP_PIXELS_H
+
+#include "xochip.h"
+
+// =====================================================================================================================
+//    DEFINES
+// =====================================================================================================================
+
+#define XOCHIP_PIXELS_SCALE_MAX 16
+
+// =====================================================================================================================
+//    TYPES
+// =====================================================================================================================
+
+/**
+ * Output formats. Multi-byte formats are written in the byte order given here, regardless of the host's endianness.
+ */
+typedef enum xochip_pixel_format
+{
+    XOCHIP_PIXELS_RGB565,    // 16 bits per pixel, host byte order
+    XOCHIP_PIXELS_RGB565_BE, // 16 bits per pixel, big endian, what most SPI panels expect on the wire
+    XOCHIP_PIXELS_RGB888,    // 24 bits per pixel, bytes R, G, B
+    XOCHIP_PIXELS_RGBA8888,  // 32 bits per pixel, bytes R, G, B, A
+    XOCHIP_PIXELS_MONO,      // 1 bit per pixel, MSB first, set when the palette colour is bright
+    XOCHIP_PIXELS_GRAY2,     // 2 bits per pixel, MSB first, the palette colour's luminance
+    XOCHIP_PIXELS_FORMAT_COUNT,
+} xochip_pixel_format_t;
+
+/**
+ * A prepared converter. Set it up once with xochip_pixels_init, it's read-only afterwards and can be shared.
+ */
+typedef struct xochip_pixels
+{
+    xochip_pixel_format_t format;
+    uint8_t scale;
+    uint8_t bytes_per_pixel;  // 0 for the sub-byte formats
+    uint8_t levels[4];        // MONO/GRAY2 level of each colour index
+    uint8_t planes[2];        // MONO/GRAY2 bit planes of the levels, a 4 bit truth table indexed by colour
+    uint8_t colours[4][4];    // each colour index in the output format
+    uint8_t table[256][16];   // (back nibble << 4 | fore nibble) -> 4 output pixels
+    uint16_t spread[256];     // bit n moved to bit 2n, for GRAY2
+} xochip_pixels_t;
+
+// =====================================================================================================================
+//    API
+// =====================================================================================================================
+
+/**
+ * @brief Prepare a converter.
+ * @param pixels The converter to fill in
+ * @param format Output format
+ * @param palette 4 colours as 0xRRGGBB, indexed by (fore_plane bit << 1 | back_plane bit)
+ * @param scale Integer scale factor, 1 to XOCHIP_PIXELS_SCALE_MAX
+ * @return Success or error:
+ * - XOCHIP_SUCCESS when ok
+ * - XOCHIP_ERR_NULL_POINTER when pixels or palette is null
+ * - XOCHIP_ERR_INVALID_ARGUMENT when format or scale is out of range
+ */
+xochip_result_t xochip_pixels_init(xochip_pixels_t *pixels, xochip_pixel_format_t format, const uint32_t palette[4],
+                                   uint8_t scale);
+
+/**
+ * @brief The number of bytes one scaled output row takes up, the smallest pitch xochip_pixels_convert accepts.
+ * @param pixels A prepared converter
+ * @return Bytes per output row
+ */
+size_t xochip_pixels_row_size(const xochip_pixels_t *pixels);
+
+/**
+ * @brief Convert display rows into a framebuffer of XOCHIP_DISPLAY_WIDTH * scale by XOCHIP_DISPLAY_HEIGHT * scale
+ * pixels. Rows not in the mask are left alone.
+ * @param pixels A prepared converter
+ * @param display The display to read
+ * @param rows Bit n converts display row n, pass display->dirty_rows (and clear it) or UINT64_MAX for everything
+ * @param destination The framebuffer
+ * @param pitch Bytes between the starts of two output rows, at least xochip_pixels_row_size
+ */
+void xochip_pixels_convert(const xochip_pixels_t *pixels, const xochip_display_t *display, uint64_t rows,
+                           void *destination, size_t pitch);
+
+// =====================================================================================================================
+//    IMPLEMENTATION
+// =====================================================================================================================
+
+#ifdef XOCHIP_IMPLEMENTATION
+
+#if !defined(XOCHIP_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define XOCHIP_PIXELS_SSE2
+#include <emmintrin.h>
+#elif !defined(XOCHIP_NO_SIMD) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define XOCHIP_PIXELS_NEON
+#include <arm_neon.h>
+#endif
+
+static void xochip_pixels_colour(const xochip_pixel_format_t format, const uint32_t rgb, uint8_t *out)
+{
+    const uint8_t r = (uint8_t)(rgb >> 16);
+    const uint8_t g = (uint8_t)(rgb >> 8);
+    const uint8_t b = (uint8_t)rgb;
+    const uint16_t rgb565 = (uint16_t)(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+
+    switch (format)
+    {
+    case XOCHIP_PIXELS_RGB565:
+        memcpy(out, &rgb565, sizeof(rgb565));
+        break;
+    case XOCHIP_PIXELS_RGB565_BE:
+        out[0] = (uint8_t)(rgb565 >> 8);
+        out[1] = (uint8_t)rgb565;
+        break;
+    case XOCHIP_PIXELS_RGB888:
+    case XOCHIP_PIXELS_RGBA8888:
+        out[0] = r;
+        out[1] = g;
+        out[2] = b;
+        out[3] = 0xFF;
+        break;
+    default:
+        break;
+    }
+}
+
+xochip_result_t xochip_pixels_init(xochip_pixels_t *pixels, const xochip_pixel_format_t format,
+                                   const uint32_t palette[4], const uint8_t scale)
+{
+    if (!pixels || !palette)
+    {
+        return XOCHIP_ERR_NULL_POINTER;
+    }
+
+    if ((unsigned)format >= XOCHIP_PIXELS_FORMAT_COUNT || scale == 0 || scale > XOCHIP_PIXELS_SCALE_MAX)
+    {
+        return XOCHIP_ERR_INVALID_ARGUMENT;
+    }
+
+    static const uint8_t sizes[XOCHIP_PIXELS_FORMAT_COUNT] = {2, 2, 3, 4, 0, 0};
+
+    memset(pixels, 0, sizeof(*pixels));
+    pixels->format = format;
+    pixels->scale = scale;
+    pixels->bytes_per_pixel = sizes[format];
+
+    for (uint8_t colour = 0; colour < 4; ++colour)
+    {
+        xochip_pixels_colour(format, palette[colour], pixels->colours[colour]);
+
+        // integer Rec. 601 luma, good enough to pick 2 or 4 shades
+        const uint32_t rgb = palette[colour];
+        const uint32_t luma = (((rgb >> 16) & 0xFF) * 77 + ((rgb >> 8) & 0xFF) * 150 + (rgb & 0xFF) * 29) >> 8;
+        pixels->levels[colour] = (uint8_t)(format == XOCHIP_PIXELS_MONO ? luma >> 7 : luma >> 6);
+        pixels->planes[0] |= (uint8_t)((pixels->levels[colour] & 1) << colour);
+        pixels->planes[1] |= (uint8_t)(((pixels->levels[colour] >> 1) & 1) << colour);
+    }
+
+    for (uint32_t index = 0; index < 256; ++index)
+    {
+        const uint8_t back = (uint8_t)(index >> 4);
+        const uint8_t fore = (uint8_t)(index & 0xF);
+
+        for (uint8_t pixel = 0; pixel < 4; ++pixel)
+        {
+            const uint8_t bit = (uint8_t)(3 - pixel);
+            const uint8_t colour = (uint8_t)(((fore >> bit) & 1) << 1 | ((back >> bit) & 1));
+            memcpy(&pixels->table[index][pixel * pixels->bytes_per_pixel], pixels->colours[colour],
+                   pixels->bytes_per_pixel);
+        }
+
+        uint16_t spread = 0;
+        for (uint8_t bit = 0; bit < 8; ++bit)
+        {
+            spread |= (uint16_t)(((index >> bit) & 1) << (bit * 2));
+        }
+        pixels->spread[index] = spread;
+    }
+
+    return XOCHIP_SUCCESS;
+}
+
+size_t xochip_pixels_row_size(const xochip_pixels_t *pixels)
+{
+    const size_t width = (size_t)XOCHIP_DISPLAY_WIDTH * pixels->scale;
+
+    switch (pixels->format)
+    {
+    case XOCHIP_PIXELS_MONO:
+        return (width + 7) / 8;
+    case XOCHIP_PIXELS_GRAY2:
+        return (width + 3) / 4;
+    default:
+        return width * pixels->bytes_per_pixel;
+    }
+}
+
+/**
+ * @brief Evaluate a 4 entry truth table (bit n is the result for colour n) for 8 pixels at once.
+ */
+static inline uint8_t xochip_pixels_select(const uint8_t table, const uint8_t back, const uint8_t fore)
+{
+    const uint8_t m0 = (table & 1) ? 0xFF : 0;
+    const uint8_t m1 = (table & 2) ? 0xFF : 0;
+    const uint8_t m2 = (table & 4) ? 0xFF : 0;
+    const uint8_t m3 = (table & 8) ? 0xFF : 0;
+    return (uint8_t)((~back & ~fore & m0) | (back & ~fore & m1) | (~back & fore & m2) | (back & fore & m3));
+}
+
+#if defined(XOCHIP_PIXELS_SSE2)
+
+static void xochip_pixels_row_16(const xochip_pixels_t *pixels, const uint8_t *back, const uint8_t *fore,
+                                 uint8_t *out)
+{
+    uint16_t colours[4];
+    for (uint8_t colour = 0; colour < 4; ++colour)
+    {
+        memcpy(&colours[colour], pixels->colours[colour], sizeof(uint16_t));
+    }
+
+    const __m128i bits = _mm_set_epi16(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80);
+    const __m128i c0 = _mm_set1_epi16((short)colours[0]);
+    const __m128i c1 = _mm_set1_epi16((short)colours[1]);
+    const __m128i c2 = _mm_set1_epi16((short)colours[2]);
+    const __m128i c3 = _mm_set1_epi16((short)colours[3]);
+
+    for (uint8_t byte = 0; byte < XOCHIP_DISPLAY_ROW_BYTES; ++byte)
+    {
+        const __m128i mb = _mm_cmpeq_epi16(_mm_and_si128(_mm_set1_epi16(back[byte]), bits), bits);
+        const __m128i mf = _mm_cmpeq_epi16(_mm_and_si128(_mm_set1_epi16(fore[byte]), bits), bits);
+        const __m128i low = _mm_or_si128(_mm_and_si128(mb, c1), _mm_andnot_si128(mb, c0));
+        const __m128i high = _mm_or_si128(_mm_and_si128(mb, c3), _mm_andnot_si128(mb, c2));
+        const __m128i result = _mm_or_si128(_mm_and_si128(mf, high), _mm_andnot_si128(mf, low));
+        _mm_storeu_si128((__m128i *)(out + byte * 16), result);
+    }
+}
+
+static void xochip_pixels_row_32(const xochip_pixels_t *pixels, const uint8_t *back, const uint8_t *fore,
+                                 uint8_t *out)
+{
+    uint32_t colours[4];
+    for (uint8_t colour = 0; colour < 4; ++colour)
+    {
+        memcpy(&colours[colour], pixels->colours[colour], sizeof(uint32_t));
+    }
+
+    const __m128i bits_left = _mm_set_epi32(0x10, 0x20, 0x40, 0x80);
+    const __m128i bits_right = _mm_set_epi32(0x01, 0x02, 0x04, 0x08);
+    const __m128i c0 = _mm_set1_epi32((int)colours[0]);
+    const __m128i c1 = _mm_set1_epi32((int)colours[1]);
+    const __m128i c2 = _mm_set1_epi32((int)colours[2]);
+    const __m128i c3 = _mm_set1_epi32((int)colours[3]);
+
+    for (uint8_t byte = 0; byte < XOCHIP_DISPLAY_ROW_BYTES; ++byte)
+    {
+        const __m128i vb = _mm_set1_epi32(back[byte]);
+        const __m128i vf = _mm_set1_epi32(fore[byte]);
+
+        for (uint8_t half = 0; half < 2; ++half)
+        {
+            const __m128i bits = half ? bits_right : bits_left;
+            const __m128i mb = _mm_cmpeq_epi32(_mm_and_si128(vb, bits), bits);
+            const __m128i mf = _mm_cmpeq_epi32(_mm_and_si128(vf, bits), bits);
+            const __m128i low = _mm_or_si128(_mm_and_si128(mb, c1), _mm_andnot_si128(mb, c0));
+            const __m128i high = _mm_or_si128(_mm_and_si128(mb, c3), _mm_andnot_si128(mb, c2));
+            const __m128i result = _mm_or_si128(_mm_and_si128(mf, high), _mm_andnot_si128(mf, low));
+            _mm_storeu_si128((__m128i *)(out + byte * 32 + half * 16), result);
+        }
+    }
+}
+
+#elif defined(XOCHIP_PIXELS_NEON)
+
+static void xochip_pixels_row_16(const xochip_pixels_t *pixels, const uint8_t *back, const uint8_t *fore,
+                                 uint8_t *out)
+{
+    static const uint16_t lanes[8] = {0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01};
+
+    uint16_t colours[4];
+    for (uint8_t colour = 0; colour < 4; ++colour)
+    {
+        memcpy(&colours[colour], pixels->colours[colour], sizeof(uint16_t));
+    }
+
+    const uint16x8_t bits = vld1q_u16(lanes);
+    const uint16x8_t c0 = vdupq_n_u16(colours[0]);
+    const uint16x8_t c1 = vdupq_n_u16(colours[1]);
+    const uint16x8_t c2 = vdupq_n_u16(colours[2]);
+    const uint16x8_t c3 = vdupq_n_u16(colours[3]);
+
+    for (uint8_t byte = 0; byte < XOCHIP_DISPLAY_ROW_BYTES; ++byte)
+    {
+        const uint16x8_t mb = vtstq_u16(vdupq_n_u16(back[byte]), bits);
+        const uint16x8_t mf = vtstq_u16(vdupq_n_u16(fore[byte]), bits);
+        const uint16x8_t result = vbslq_u16(mf, vbslq_u16(mb, c3, c2), vbslq_u16(mb, c1, c0));
+        vst1q_u16((uint16_t *)(void *)(out + byte * 16), result);
+    }
+}
+
+static void xochip_pixels_row_32(const xochip_pixels_t *pixels, const uint8_t *back, const uint8_t *fore,
+                                 uint8_t *out)
+{
+    static const uint32_t lanes[8] = {0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01};
+
+    uint32_t colours[4];
+    for (uint8_t colour = 0; colour < 4; ++colour)
+    {
+        memcpy(&colours[colour], pixels->colours[colour], sizeof(uint32_t));
+    }
+
+    const uint32x4_t bits_left = vld1q_u32(lanes);
+    const uint32x4_t bits_right = vld1q_u32(lanes + 4);
+    const uint32x4_t c0 = vdupq_n_u32(colours[0]);
+    const uint32x4_t c1 = vdupq_n_u32(colours[1]);
+    const uint32x4_t c2 = vdupq_n_u32(colours[2]);
+    const uint32x4_t c3 = vdupq_n_u32(colours[3]);
+
+    for (uint8_t byte = 0; byte < XOCHIP_DISPLAY_ROW_BYTES; ++byte)
+    {
+        const uint32x4_t vb = vdupq_n_u32(back[byte]);
+        const uint32x4_t vf = vdupq_n_u32(fore[byte]);
+
+        for (uint8_t half = 0; half < 2; ++half)
+        {
+            const uint32x4_t bits = half ? bits_right : bits_left;
+            const uint32x4_t mb = vtstq_u32(vb, bits);
+            const uint32x4_t mf = vtstq_u32(vf, bits);
+            const uint32x4_t result = vbslq_u32(mf, vbslq_u32(mb, c3, c2), vbslq_u32(mb, c1, c0));
+            vst1q_u32((uint32_t *)(void *)(out + byte * 32 + half * 16), result);
+        }
+    }
+}
+
+#endif
+
+/**
+ * @brief Convert one display row at 1x. out must hold XOCHIP_DISPLAY_WIDTH pixels of the output format.
+ */
+static void xochip_pixels_row(const xochip_pixels_t *pixels, const uint8_t *back, const uint8_t *fore, uint8_t *out)
+{
+    switch (pixels->format)
+    {
+    case XOCHIP_PIXELS_RGB565:
+    case XOCHIP_PIXELS_RGB565_BE:
+#if defined(XOCHIP_PIXELS_SSE2) || defined(XOCHIP_PIXELS_NEON)
+        xochip_pixels_row_16(pixels, back, fore, out);
+#else
+        for (uint8_t byte = 0; byte < XOCHIP_DISPLAY_ROW_BYTES; ++byte, out += 16)
+        {
+            memcpy(out, pixels->table[(back[byte] & 0xF0) | (fore[byte] >> 4)], 8);
+            memcpy(out + 8, pixels->table[(back[byte] & 0x0F) << 4 | (fore[byte] & 0x0F)], 8);
+        }
+#endif
+        break;
+
+    case XOCHIP_PIXELS_RGB888:
+        for (uint8_t byte = 0; byte < XOCHIP_DISPLAY_ROW_BYTES; ++byte, out += 24)
+        {
+            memcpy(out, pixels->table[(back[byte] & 0xF0) | (fore[byte] >> 4)], 12);
+            memcpy(out + 12, pixels->table[(back[byte] & 0x0F) << 4 | (fore[byte] & 0x0F)], 12);
+        }
+        break;
+
+    case XOCHIP_PIXELS_RGBA8888:
+#if defined(XOCHIP_PIXELS_SSE2) || defined(XOCHIP_PIXELS_NEON)
+        xochip_pixels_row_32(pixels, back, fore, out);
+#else
+        for (uint8_t byte = 0; byte < XOCHIP_DISPLAY_ROW_BYTES; ++byte, out += 32)
+        {
+            memcpy(out, pixels->table[(back[byte] & 0xF0) | (fore[byte] >> 4)], 16);
+            memcpy(out + 16, pixels->table[(back[byte] & 0x0F) << 4 | (fore[byte] & 0x0F)], 16);
+        }
+#endif
+        break;
+
+    case XOCHIP_PIXELS_MONO:
+        for (uint8_t byte = 0; byte < XOCHIP_DISPLAY_ROW_BYTES; ++byte)
+        {
+            out[byte] = xochip_pixels_select(pixels->planes[0], back[byte], fore[byte]);
+        }
+        break;
+
+    case XOCHIP_PIXELS_GRAY2:
+        for (uint8_t byte = 0; byte < XOCHIP_DISPLAY_ROW_BYTES; ++byte, out += 2)
+        {
+            const uint8_t low = xochip_pixels_select(pixels->planes[0], back[byte], fore[byte]);
+            const uint8_t high = xochip_pixels_select(pixels->planes[1], back[byte], fore[byte]);
+            const uint16_t packed = (uint16_t)(pixels->spread[high] << 1 | pixels->spread[low]);
+            out[0] = (uint8_t)(packed >> 8);
+            out[1] = (uint8_t)packed;
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Widen a 1x row by the converter's scale. Whole-byte pixels are copied, packed ones are moved bit by bit.
+ */
+static void xochip_pixels_widen(const xochip_pixels_t *pixels, const uint8_t *row, uint8_t *out)
+{
+    const uint8_t scale = pixels->scale;
+    const uint8_t size = pixels->bytes_per_pixel;
+
+    if (size)
+    {
+        for (uint32_t pixel = 0; pixel < XOCHIP_DISPLAY_WIDTH; ++pixel)
+        {
+            for (uint8_t copy = 0; copy < scale; ++copy, out += size)
+            {
+                memcpy(out, row + pixel * size, size);
+            }
+        }
+        return;
+    }
+
+    const uint8_t bits = pixels->format == XOCHIP_PIXELS_MONO ? 1 : 2;
+    const uint8_t mask = (uint8_t)((1u << bits) - 1);
+    memset(out, 0, xochip_pixels_row_size(pixels));
+
+    uint32_t target = 0;
+    for (uint32_t pixel = 0; pixel < XOCHIP_DISPLAY_WIDTH; ++pixel)
+    {
+        const uint32_t source = pixel * bits;
+        const uint8_t value = (uint8_t)((row[source / 8] >> (8 - bits - source % 8)) & mask);
+
+        for (uint8_t copy = 0; copy < scale; ++copy, target += bits)
+        {
+            out[target / 8] |= (uint8_t)(value << (8 - bits - target % 8));
+        }
+    }
+}
+
+void xochip_pixels_convert(const xochip_pixels_t *pixels, const xochip_display_t *display, uint64_t rows,
+                           void *destination, const size_t pitch)
+{
+    if (!pixels || !display || !destination)
+    {
+        return;
+    }
+
+    uint8_t row[XOCHIP_DISPLAY_WIDTH * 4];
+    const size_t row_size = xochip_pixels_row_size(pixels);
+
+    while (rows)
+    {
+        // walk the set bits only, a typical frame dirties a handful of rows
+        uint8_t y = 0;
+        while (!((rows >> y) & 1))
+        {
+            y++;
+        }
+        rows &= rows - 1;
+
+        // low resolution pixels are doubled here, a row at a time, the emulator never does it
+        uint8_t scratch[2][XOCHIP_DISPLAY_ROW_BYTES];
+        const uint8_t *back = xochip_display_row(display, 0, y, scratch[0]);
+        const uint8_t *fore = xochip_display_row(display, 1, y, scratch[1]);
+        uint8_t *out = (uint8_t *)destination + (size_t)y * pixels->scale * pitch;
+
+        if (pixels->scale == 1)
+        {
+            xochip_pixels_row(pixels, back, fore, out);
+            continue;
+        }
+
+        xochip_pixels_row(pixels, back, fore, row);
+        xochip_pixels_widen(pixels, row, out);
+
+        for (uint8_t copy = 1; copy < pixels->scale; ++copy)
+        {
+            memcpy(out + copy * pitch, out, row_size);
+        }
+    }
+}
+
+#endif
+
+#endif // XOCHIP_PIXELS_H
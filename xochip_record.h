@@ -0,0 +1,509 @@
+//
+// Optional session recording. Every frame is stored as the XOR of both display planes against the frame before it,
+// run-length coded: most bytes don't change between frames, so an idle frame takes 6 bytes and a busy one a few
+// hundred, instead of 2 KB raw. Every keyframe_interval frames a keyframe is stored against a blank display instead,
+// which is where the decoder starts when seeking. The recorder buffers its output and hands it to a writer callback in
+// large chunks, so it's cheap enough to leave on.
+//
+// Like xochip.h, include this wherever you need it and define XOCHIP_IMPLEMENTATION in exactly one translation unit.
+//
+// The format, all numbers little endian:
+//
+//     header   "XOCR", version (1), 0, keyframe interval (u16), bytes per plane (u16)
+//     record   type (0 delta, 1 keyframe), payload size (u16), payload
+//     payload  pairs of varint skip, varint count, count XOR bytes, covering back_plane then fore_plane exactly
+//
+// A recording that was cut off (the host crashed) is still readable up to the last complete record.
+//
+
+#ifndef XOCHIP_RECORD_H
+#define XOCHIP_RECORD_H
+
+#include "xochip.h"
+
+// =====================================================================================================================
+//    DEFINES
+// =====================================================================================================================
+
+#define XOCHIP_RECORD_VERSION 1
+#define XOCHIP_RECORD_HEADER_SIZE 10
+#define XOCHIP_RECORD_PLANE_BYTES (XOCHIP_DISPLAY_PIXELS / 8)
+#define XOCHIP_RECORD_FRAME_BYTES (2 * XOCHIP_RECORD_PLANE_BYTES)
+
+// Worst case payload. Pairs only split literals at 3 or more unchanged bytes, which is more than the varints cost, so
+// this is comfortably above anything the encoder produces
+#define XOCHIP_RECORD_PAYLOAD_MAX (XOCHIP_RECORD_FRAME_BYTES + XOCHIP_RECORD_FRAME_BYTES / 2 + 8)
+#define XOCHIP_RECORD_RECORD_MAX (3 + XOCHIP_RECORD_PAYLOAD_MAX)
+
+// How much the recorder collects before calling the writer, at least one worst case record
+#ifndef XOCHIP_RECORD_BUFFER_SIZE
+#define XOCHIP_RECORD_BUFFER_SIZE 16384
+#endif
+
+// Keyframe every 10 seconds at 60 fps, seeking decodes at most this many frames
+#define XOCHIP_RECORD_KEYFRAME_INTERVAL 600
+
+// xochip_replay_t.frame before anything was decoded
+#define XOCHIP_REPLAY_NONE UINT32_MAX
+
+// =====================================================================================================================
+//    TYPES
+// =====================================================================================================================
+
+typedef enum xochip_record_type
+{
+    XOCHIP_RECORD_DELTA,    // XOR against the previous frame
+    XOCHIP_RECORD_KEYFRAME, // XOR against a blank display
+} xochip_record_type_t;
+
+/**
+ * Records frames. It's about 20 KB, mostly buffers, so it usually wants to be static or on the heap.
+ */
+typedef struct xochip_recorder
+{
+    xochip_writer_t writer;
+    void *context;
+    uint16_t keyframe_interval;
+    uint32_t frames;                                   // recorded so far
+    uint64_t written;                                  // bytes handed to the writer so far
+    uint8_t latest;                                    // which of planes holds the last recorded frame
+    uint8_t planes[2][XOCHIP_RECORD_FRAME_BYTES];      // back_plane then fore_plane, of the last 2 frames
+    size_t used;                                       // bytes waiting in buffer
+    uint8_t buffer[XOCHIP_RECORD_BUFFER_SIZE];
+} xochip_recorder_t;
+
+/**
+ * Plays a recording back from memory. The data has to stay around while the replay is in use.
+ */
+typedef struct xochip_replay
+{
+    const uint8_t *data;
+    size_t size;
+    uint16_t keyframe_interval;
+    uint32_t frame_count;     // complete frames in data
+    uint32_t frame;           // the frame display shows, or XOCHIP_REPLAY_NONE
+    size_t offset;            // where the record after frame starts
+    xochip_display_t display; // updated and dirty_rows work like the emulator's, they're up to you to clear
+} xochip_replay_t;
+
+// =====================================================================================================================
+//    API
+// =====================================================================================================================
+
+/**
+ * @brief Start a recording, the header goes out with the first flush.
+ * @param recorder The recorder to set up
+ * @param writer Where the recording goes
+ * @param context Passed to the writer
+ * @param keyframe_interval Frames between keyframes, XOCHIP_RECORD_KEYFRAME_INTERVAL is a good default
+ * @return Success or error:
+ * - XOCHIP_SUCCESS when ok
+ * - XOCHIP_ERR_NULL_POINTER when recorder or writer is null
+ * - XOCHIP_ERR_INVALID_ARGUMENT when keyframe_interval is 0
+ */
+xochip_result_t xochip_record_start(xochip_recorder_t *recorder, xochip_writer_t writer, void *context,
+                                    uint16_t keyframe_interval);
+
+/**
+ * @brief Record one frame. Call it once per frame whether the display changed or not, the frame number is the time.
+ * @param recorder A started recorder
+ * @param display The display to record
+ * @return Success or error:
+ * - XOCHIP_SUCCESS when ok
+ * - XOCHIP_ERR_NULL_POINTER when recorder or display is null
+ * - XOCHIP_ERR_WRITE when the buffer was full and the writer failed
+ */
+xochip_result_t xochip_record_frame(xochip_recorder_t *recorder, const xochip_display_t *display);
+
+/**
+ * @brief Hand everything buffered to the writer. Call it before closing whatever the writer writes to.
+ * @param recorder A started recorder
+ * @return Success or error:
+ * - XOCHIP_SUCCESS when ok
+ * - XOCHIP_ERR_NULL_POINTER when recorder is null
+ * - XOCHIP_ERR_WRITE when the writer failed
+ */
+xochip_result_t xochip_record_flush(xochip_recorder_t *recorder);
+
+/**
+ * @brief Open a recording for playback and count its frames. Nothing is decoded yet, seek to the first frame.
+ * @param replay The replay to set up
+ * @param data The recording
+ * @param size Size of the recording in bytes
+ * @return Success or error:
+ * - XOCHIP_SUCCESS when ok
+ * - XOCHIP_ERR_NULL_POINTER when replay or data is null
+ * - XOCHIP_ERR_INVALID_ARGUMENT when data isn't a recording this version can read
+ */
+xochip_result_t xochip_replay_open(xochip_replay_t *replay, const uint8_t *data, size_t size);
+
+/**
+ * @brief Decode a frame into replay->display. Going to the next frame decodes one record, anything else decodes from
+ * the closest keyframe before it.
+ * @param replay An open replay
+ * @param frame The frame to show, below replay->frame_count
+ * @return Success or error:
+ * - XOCHIP_SUCCESS when ok
+ * - XOCHIP_ERR_NULL_POINTER when replay is null
+ * - XOCHIP_ERR_INVALID_ARGUMENT when frame is out of range or the recording is corrupt
+ */
+xochip_result_t xochip_replay_seek(xochip_replay_t *replay, uint32_t frame);
+
+// =====================================================================================================================
+//    IMPLEMENTATION
+// =====================================================================================================================
+
+#ifdef XOCHIP_IMPLEMENTATION
+
+static uint8_t *xochip_record_varint(uint8_t *out, uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        *out++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = (uint8_t)value;
+    return out;
+}
+
+// Where the run of unchanged bytes starting at position ends, 8 bytes at a time while it can
+static uint32_t xochip_record_same(const uint8_t *previous, const uint8_t *current, uint32_t position)
+{
+    while (position + 8 <= XOCHIP_RECORD_FRAME_BYTES)
+    {
+        uint64_t a;
+        uint64_t b;
+        memcpy(&a, previous + position, sizeof(a));
+        memcpy(&b, current + position, sizeof(b));
+        if (a != b)
+        {
+            break;
+        }
+        position += 8;
+    }
+
+    while (position < XOCHIP_RECORD_FRAME_BYTES && previous[position] == current[position])
+    {
+        position++;
+    }
+
+    return position;
+}
+
+// XOR of current against previous as skip/count pairs. Short runs of unchanged bytes stay in the literals, a pair
+// costs more than they do.
+static size_t xochip_record_encode(const uint8_t *previous, const uint8_t *current, uint8_t *out)
+{
+    uint8_t *cursor = out;
+    uint32_t position = 0;
+
+    while (position < XOCHIP_RECORD_FRAME_BYTES)
+    {
+        const uint32_t start = position;
+        position = xochip_record_same(previous, current, position);
+        const uint32_t skip = position - start;
+
+        const uint32_t literal = position;
+        while (position < XOCHIP_RECORD_FRAME_BYTES)
+        {
+            if (previous[position] != current[position])
+            {
+                position++;
+                continue;
+            }
+
+            const uint32_t same = xochip_record_same(previous, current, position);
+            if (same - position >= 3 || same == XOCHIP_RECORD_FRAME_BYTES)
+            {
+                break;
+            }
+            position = same;
+        }
+
+        cursor = xochip_record_varint(cursor, skip);
+        cursor = xochip_record_varint(cursor, position - literal);
+        for (uint32_t index = literal; index < position; ++index)
+        {
+            *cursor++ = previous[index] ^ current[index];
+        }
+    }
+
+    return (size_t)(cursor - out);
+}
+
+xochip_result_t xochip_record_flush(xochip_recorder_t *recorder)
+{
+    if (!recorder)
+    {
+        return XOCHIP_ERR_NULL_POINTER;
+    }
+
+    if (recorder->used > 0 && !recorder->writer(recorder->context, recorder->buffer, recorder->used))
+    {
+        return XOCHIP_ERR_WRITE;
+    }
+
+    recorder->written += recorder->used;
+    recorder->used = 0;
+    return XOCHIP_SUCCESS;
+}
+
+xochip_result_t xochip_record_start(xochip_recorder_t *recorder, const xochip_writer_t writer, void *context,
+                                    const uint16_t keyframe_interval)
+{
+    if (!recorder || !writer)
+    {
+        return XOCHIP_ERR_NULL_POINTER;
+    }
+
+    if (keyframe_interval == 0)
+    {
+        return XOCHIP_ERR_INVALID_ARGUMENT;
+    }
+
+    recorder->writer = writer;
+    recorder->context = context;
+    recorder->keyframe_interval = keyframe_interval;
+    recorder->frames = 0;
+    recorder->written = 0;
+    recorder->latest = 0;
+
+    const uint8_t header[XOCHIP_RECORD_HEADER_SIZE] = {
+        'X',
+        'O',
+        'C',
+        'R',
+        XOCHIP_RECORD_VERSION,
+        0,
+        (uint8_t)keyframe_interval,
+        (uint8_t)(keyframe_interval >> 8),
+        (uint8_t)XOCHIP_RECORD_PLANE_BYTES,
+        (uint8_t)(XOCHIP_RECORD_PLANE_BYTES >> 8),
+    };
+    memcpy(recorder->buffer, header, sizeof(header));
+    recorder->used = sizeof(header);
+    return XOCHIP_SUCCESS;
+}
+
+xochip_result_t xochip_record_frame(xochip_recorder_t *recorder, const xochip_display_t *display)
+{
+    if (!recorder || !display)
+    {
+        return XOCHIP_ERR_NULL_POINTER;
+    }
+
+    if (recorder->used + XOCHIP_RECORD_RECORD_MAX > sizeof(recorder->buffer))
+    {
+        const xochip_result_t result = xochip_record_flush(recorder);
+        if (result != XOCHIP_SUCCESS)
+        {
+            return result;
+        }
+    }
+
+    // frames are kept as the 128x64 picture, whatever resolution the display is in
+    uint8_t *current = recorder->planes[recorder->latest ^ 1];
+    xochip_display_expand(display, current, current + XOCHIP_RECORD_PLANE_BYTES);
+
+    // a keyframe is the frame against a blank display, so both kinds decode the same way
+    static const uint8_t blank[XOCHIP_RECORD_FRAME_BYTES];
+    const bool keyframe = recorder->frames % recorder->keyframe_interval == 0;
+    const uint8_t *previous = keyframe ? blank : recorder->planes[recorder->latest];
+
+    uint8_t *record = recorder->buffer + recorder->used;
+    const size_t size = xochip_record_encode(previous, current, record + 3);
+    record[0] = keyframe ? XOCHIP_RECORD_KEYFRAME : XOCHIP_RECORD_DELTA;
+    record[1] = (uint8_t)size;
+    record[2] = (uint8_t)(size >> 8);
+
+    recorder->used += 3 + size;
+    recorder->latest ^= 1;
+    recorder->frames++;
+    return XOCHIP_SUCCESS;
+}
+
+static bool xochip_replay_varint(const uint8_t **cursor, const uint8_t *end, uint32_t *value)
+{
+    *value = 0;
+    for (uint8_t shift = 0; shift < 32 && *cursor < end; shift += 7)
+    {
+        const uint8_t byte = *(*cursor)++;
+        *value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Size of the record at offset including its header, or 0 when it's cut off
+static size_t xochip_replay_record_size(const xochip_replay_t *replay, const size_t offset)
+{
+    if (replay->size - offset < 3)
+    {
+        return 0;
+    }
+
+    const size_t size = 3 + (replay->data[offset + 1] | (size_t)replay->data[offset + 2] << 8);
+    return size <= replay->size - offset ? size : 0;
+}
+
+// XORs the record at offset into the display
+static bool xochip_replay_apply(xochip_replay_t *replay, const size_t offset)
+{
+    const uint8_t *cursor = replay->data + offset + 3;
+    const uint8_t *end = replay->data + offset + xochip_replay_record_size(replay, offset);
+    xochip_display_t *display = &replay->display;
+
+    if (replay->data[offset] == XOCHIP_RECORD_KEYFRAME)
+    {
+        memset(display->back_plane, 0, sizeof(display->back_plane));
+        memset(display->fore_plane, 0, sizeof(display->fore_plane));
+        display->updated = true;
+        display->dirty_rows = UINT64_MAX;
+    }
+
+    uint32_t position = 0;
+    while (cursor < end)
+    {
+        uint32_t skip;
+        uint32_t count;
+        if (!xochip_replay_varint(&cursor, end, &skip) || !xochip_replay_varint(&cursor, end, &count) ||
+            skip > XOCHIP_RECORD_FRAME_BYTES - position || count > XOCHIP_RECORD_FRAME_BYTES - position - skip ||
+            count > (size_t)(end - cursor))
+        {
+            return false;
+        }
+
+        position += skip;
+        for (uint32_t index = 0; index < count; ++index, ++position)
+        {
+            const uint32_t plane_index = position % XOCHIP_RECORD_PLANE_BYTES;
+            uint8_t *plane = position < XOCHIP_RECORD_PLANE_BYTES ? display->back_plane : display->fore_plane;
+            const uint8_t change = *cursor++;
+
+            if (change)
+            {
+                plane[plane_index] ^= change;
+                display->updated = true;
+                display->dirty_rows |= 1ULL << (plane_index / XOCHIP_DISPLAY_ROW_BYTES);
+            }
+        }
+    }
+
+    return position == XOCHIP_RECORD_FRAME_BYTES;
+}
+
+xochip_result_t xochip_replay_open(xochip_replay_t *replay, const uint8_t *data, const size_t size)
+{
+    if (!replay || !data)
+    {
+        return XOCHIP_ERR_NULL_POINTER;
+    }
+
+    if (size < XOCHIP_RECORD_HEADER_SIZE || memcmp(data, "XOCR", 4) != 0 || data[4] != XOCHIP_RECORD_VERSION ||
+        (data[8] | data[9] << 8) != XOCHIP_RECORD_PLANE_BYTES)
+    {
+        return XOCHIP_ERR_INVALID_ARGUMENT;
+    }
+
+    memset(replay, 0, sizeof(*replay));
+    replay->data = data;
+    replay->size = size;
+    replay->keyframe_interval = (uint16_t)(data[6] | data[7] << 8);
+    replay->frame = XOCHIP_REPLAY_NONE;
+    replay->offset = XOCHIP_RECORD_HEADER_SIZE;
+    replay->display.hires = true; // frames were recorded as the 128x64 picture
+
+    // the first frame has to be a keyframe, otherwise there's nothing to decode against
+    size_t offset = XOCHIP_RECORD_HEADER_SIZE;
+    if (size > offset && data[offset] != XOCHIP_RECORD_KEYFRAME)
+    {
+        return XOCHIP_ERR_INVALID_ARGUMENT;
+    }
+
+    size_t record = xochip_replay_record_size(replay, offset);
+    while (record > 0 && replay->frame_count < XOCHIP_REPLAY_NONE)
+    {
+        if (data[offset] > XOCHIP_RECORD_KEYFRAME)
+        {
+            return XOCHIP_ERR_INVALID_ARGUMENT;
+        }
+        offset += record;
+        replay->frame_count++;
+        record = xochip_replay_record_size(replay, offset);
+    }
+
+    return XOCHIP_SUCCESS;
+}
+
+xochip_result_t xochip_replay_seek(xochip_replay_t *replay, const uint32_t frame)
+{
+    if (!replay)
+    {
+        return XOCHIP_ERR_NULL_POINTER;
+    }
+
+    if (frame >= replay->frame_count)
+    {
+        return XOCHIP_ERR_INVALID_ARGUMENT;
+    }
+
+    if (frame == replay->frame)
+    {
+        return XOCHIP_SUCCESS;
+    }
+
+    // walk the record headers from the frame we're on if the target is ahead, otherwise from the start, and remember
+    // the last keyframe on the way. Only decode from the current frame when there's no keyframe in between.
+    const bool ahead = replay->frame != XOCHIP_REPLAY_NONE && frame > replay->frame;
+    uint32_t index = ahead ? replay->frame + 1 : 0;
+    size_t offset = ahead ? replay->offset : XOCHIP_RECORD_HEADER_SIZE;
+    uint32_t start_index = index;
+    size_t start = offset;
+    bool keyframe = false;
+
+    for (;;)
+    {
+        if (replay->data[offset] == XOCHIP_RECORD_KEYFRAME)
+        {
+            start_index = index;
+            start = offset;
+            keyframe = true;
+        }
+
+        if (index == frame)
+        {
+            break;
+        }
+
+        offset += xochip_replay_record_size(replay, offset);
+        index++;
+    }
+
+    // a recording that doesn't start with one is refused by xochip_replay_open, so this only happens when going ahead
+    if (!keyframe && !ahead)
+    {
+        return XOCHIP_ERR_INVALID_ARGUMENT;
+    }
+
+    for (index = start_index, offset = start; index <= frame; ++index)
+    {
+        if (!xochip_replay_apply(replay, offset))
+        {
+            replay->frame = XOCHIP_REPLAY_NONE;
+            replay->offset = XOCHIP_RECORD_HEADER_SIZE;
+            return XOCHIP_ERR_INVALID_ARGUMENT;
+        }
+        offset += xochip_replay_record_size(replay, offset);
+    }
+
+    replay->frame = frame;
+    replay->offset = offset;
+    return XOCHIP_SUCCESS;
+}
+
+#endif
+
+#endif // XOCHIP_RECORD_H
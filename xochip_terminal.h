@@ -0,0 +1,480 @@
+//
+// Optional ANSI terminal renderer, for looking at a machine running on a remote host over SSH. The display is drawn
+// with Unicode block characters in 4 colours, either as half blocks (one cell per 1x2 pixels, 128x32 cells, every
+// colour exact) or as quadrants (one cell per 2x2 pixels, 64x32 cells, for narrow terminals, a cell holding 3 or 4
+// colours shows the 2 most common ones). Colours are 24-bit, or the nearest of the 16 standard ANSI colours for
+// terminals without.
+//
+// Only what changed is sent. Rows of cells whose bytes in back_plane and fore_plane are the same as last time are
+// skipped outright, the others are compared cell by cell, and the cursor is moved and the colours set only where the
+// next changed cell needs it. An idle frame costs nothing and a moving sprite a few dozen bytes, so it's fine at
+// 60 fps over a slow link. The output goes through a buffer to a writer callback, there's no dependency on anything.
+//
+// Like xochip.h, include this wherever you need it and define XOCHIP_IMPLEMENTATION in exactly one translation unit.
+//
+
+#ifndef XOCHIP_TERMINAL_H
+#define XOCHIP_TERMINAL_H
+
+#include "xochip.h"
+
+// =====================================================================================================================
+//    DEFINES
+// =====================================================================================================================
+
+// Every cell covers 2 display rows, in both modes
+#define XOCHIP_TERMINAL_ROWS (XOCHIP_DISPLAY_HEIGHT / 2)
+#define XOCHIP_TERMINAL_COLUMNS_MAX XOCHIP_DISPLAY_WIDTH
+
+// How much the renderer collects before calling the writer
+#ifndef XOCHIP_TERMINAL_BUFFER_SIZE
+#define XOCHIP_TERMINAL_BUFFER_SIZE 4096
+#endif
+
+// =====================================================================================================================
+//    TYPES
+// =====================================================================================================================
+
+typedef enum xochip_terminal_mode
+{
+    XOCHIP_TERMINAL_HALF_BLOCKS, // ▀ with the top pixel in front and the bottom one behind, 128x32 cells
+    XOCHIP_TERMINAL_QUADRANTS,   // ▖▗▘▝ and friends, 64x32 cells
+    XOCHIP_TERMINAL_MODE_COUNT,
+} xochip_terminal_mode_t;
+
+typedef enum xochip_terminal_colours
+{
+    XOCHIP_TERMINAL_TRUECOLOUR, // the palette as is, needs a terminal with 24-bit colour
+    XOCHIP_TERMINAL_ANSI16,     // the nearest of the 16 standard colours, a different one for every palette entry
+    XOCHIP_TERMINAL_COLOURS_COUNT,
+} xochip_terminal_colours_t;
+
+/**
+ * A renderer and what it believes is on the terminal. About 10 KB, mostly the copy of the last frame.
+ */
+typedef struct xochip_terminal
+{
+    xochip_writer_t writer;
+    void *context;
+    xochip_terminal_mode_t mode;
+    uint8_t columns;        // cells per row
+    uint8_t cells[256];     // 2 bit colours of top left, top right, bottom left, bottom right from the low end -> cell
+    char colours[2][4][20]; // SGR parameters for [background, foreground][colour], e.g. "38;2;255;204;0"
+
+    bool valid;                                    // false until everything was drawn once, or after an invalidate
+    uint8_t back_plane[XOCHIP_DISPLAY_PIXELS / 8]; // the planes that were last drawn
+    uint8_t fore_plane[XOCHIP_DISPLAY_PIXELS / 8];
+    bool hires;                                    // and their resolution
+    uint8_t shown[XOCHIP_TERMINAL_ROWS][XOCHIP_TERMINAL_COLUMNS_MAX]; // the cells on the terminal
+    uint8_t row;                                                      // where the cursor is, row 0xFF is unknown
+    uint8_t column;
+    uint8_t background; // colours set on the terminal, 0xFF is unknown
+    uint8_t foreground;
+
+    xochip_result_t result; // the first write error, it sticks
+    uint64_t written;       // bytes handed to the writer in total
+    size_t used;            // bytes waiting in buffer
+    uint8_t buffer[XOCHIP_TERMINAL_BUFFER_SIZE];
+} xochip_terminal_t;
+
+// =====================================================================================================================
+//    API
+// =====================================================================================================================
+
+/**
+ * @brief Set up a renderer. Nothing is written until the first xochip_terminal_draw, which clears the terminal.
+ * @param terminal The renderer to set up
+ * @param mode How pixels are packed into cells
+ * @param colours How colours are sent
+ * @param palette 4 colours as 0xRRGGBB, indexed by (fore_plane bit << 1 | back_plane bit)
+ * @param writer Takes the output, e.g. to stdout
+ * @param context Passed to the writer
+ * @return Success or error:
+ * - XOCHIP_SUCCESS when ok
+ * - XOCHIP_ERR_NULL_POINTER when terminal, palette or writer is null
+ * - XOCHIP_ERR_INVALID_ARGUMENT when mode or colours is out of range
+ */
+xochip_result_t xochip_terminal_init(xochip_terminal_t *terminal, xochip_terminal_mode_t mode,
+                                     xochip_terminal_colours_t colours, const uint32_t palette[4],
+                                     xochip_writer_t writer, void *context);
+
+/**
+ * @brief Bring the terminal up to date with the display and hand the output to the writer. The picture sits in the
+ * top left corner of the terminal.
+ * @param terminal A renderer
+ * @param display The display to draw
+ * @return Success or error:
+ * - XOCHIP_SUCCESS when ok
+ * - XOCHIP_ERR_NULL_POINTER when terminal or display is null
+ * - XOCHIP_ERR_WRITE when the writer failed, now or before
+ */
+xochip_result_t xochip_terminal_draw(xochip_terminal_t *terminal, const xochip_display_t *display);
+
+/**
+ * @brief Forget what's on the terminal, the next draw clears it and draws everything. Call it when something else
+ * wrote to the terminal, or it was resized.
+ * @param terminal A renderer
+ */
+void xochip_terminal_invalidate(xochip_terminal_t *terminal);
+
+/**
+ * @brief Leave the terminal usable: default colours, the cursor visible and on the line below the picture.
+ * @param terminal A renderer
+ * @return Success or error, like xochip_terminal_draw
+ */
+xochip_result_t xochip_terminal_finish(xochip_terminal_t *terminal);
+
+// =====================================================================================================================
+//    IMPLEMENTATION
+// =====================================================================================================================
+
+#ifdef XOCHIP_IMPLEMENTATION
+
+#include <stdio.h>
+
+// What the 16 standard colours usually look like, VGA's take on them
+static const uint32_t xochip_terminal_ansi[16] = {
+    0x000000, 0xAA0000, 0x00AA00, 0xAA5500, 0x0000AA, 0xAA00AA, 0x00AAAA, 0xAAAAAA,
+    0x555555, 0xFF5555, 0x55FF55, 0xFFFF55, 0x5555FF, 0xFF55FF, 0x55FFFF, 0xFFFFFF,
+};
+
+// Block characters by which quarters are in the foreground colour: bit 0 top left, 1 top right, 2 bottom left,
+// 3 bottom right. In UTF-8, so the source stays ASCII: " ▘▝▀▖▌▞▛▗▚▐▜▄▙▟█"
+static const char *const xochip_terminal_glyphs[16] = {
+    " ",           "\xE2\x96\x98", "\xE2\x96\x9D", "\xE2\x96\x80", "\xE2\x96\x96", "\xE2\x96\x8C",
+    "\xE2\x96\x9E", "\xE2\x96\x9B", "\xE2\x96\x97", "\xE2\x96\x9A", "\xE2\x96\x90", "\xE2\x96\x9C",
+    "\xE2\x96\x84", "\xE2\x96\x99", "\xE2\x96\x9F", "\xE2\x96\x88",
+};
+
+// A cell is which quarters are in the foreground (low nibble), the foreground colour and the background colour
+#define XOCHIP_TERMINAL_CELL(mask, foreground, background)                                                            \
+    ((uint8_t)((mask) | (foreground) << 4 | (background) << 6))
+#define XOCHIP_TERMINAL_MASK(cell) ((cell) & 0xF)
+#define XOCHIP_TERMINAL_FOREGROUND(cell) (((cell) >> 4) & 0x3)
+#define XOCHIP_TERMINAL_BACKGROUND(cell) ((cell) >> 6)
+
+static uint32_t xochip_terminal_distance(const uint32_t a, const uint32_t b)
+{
+    uint32_t distance = 0;
+    for (uint8_t shift = 0; shift < 24; shift += 8)
+    {
+        const int32_t difference = (int32_t)((a >> shift) & 0xFF) - (int32_t)((b >> shift) & 0xFF);
+        distance += (uint32_t)(difference * difference);
+    }
+    return distance;
+}
+
+// The cell for 4 pixels: the 2 most common colours, the first one seen on a tie, and every other pixel drawn in
+// whichever of them is closer. The top left pixel is always in the foreground and a single colour is a blank cell,
+// so there's one way to write each picture and equal pictures compare equal.
+static uint8_t xochip_terminal_cell(const uint8_t pixels, const uint32_t palette[4])
+{
+    uint8_t counts[4] = {0};
+    uint8_t order[4];
+    uint8_t seen = 0;
+    for (uint8_t pixel = 0; pixel < 4; ++pixel)
+    {
+        const uint8_t colour = (pixels >> (pixel * 2)) & 0x3;
+        if (counts[colour]++ == 0)
+        {
+            order[seen++] = colour;
+        }
+    }
+
+    uint8_t first = order[0];
+    uint8_t second = 0xFF;
+    for (uint8_t index = 1; index < seen; ++index)
+    {
+        const uint8_t colour = order[index];
+        if (counts[colour] > counts[first])
+        {
+            second = first;
+            first = colour;
+        }
+        else if (second == 0xFF || counts[colour] > counts[second])
+        {
+            second = colour;
+        }
+    }
+
+    if (second == 0xFF)
+    {
+        return XOCHIP_TERMINAL_CELL(0, first, first);
+    }
+
+    uint8_t mask = 0;
+    for (uint8_t pixel = 0; pixel < 4; ++pixel)
+    {
+        const uint8_t colour = (pixels >> (pixel * 2)) & 0x3;
+        const bool is_first = colour == first ||
+                              (colour != second && xochip_terminal_distance(palette[colour], palette[first]) <=
+                                                       xochip_terminal_distance(palette[colour], palette[second]));
+        mask |= (uint8_t)(is_first << pixel);
+    }
+
+    if (mask == 0xF || mask == 0)
+    {
+        return XOCHIP_TERMINAL_CELL(0, mask ? first : second, mask ? first : second);
+    }
+    return mask & 1 ? XOCHIP_TERMINAL_CELL(mask, first, second) : XOCHIP_TERMINAL_CELL(mask ^ 0xF, second, first);
+}
+
+xochip_result_t xochip_terminal_init(xochip_terminal_t *terminal, const xochip_terminal_mode_t mode,
+                                     const xochip_terminal_colours_t colours, const uint32_t palette[4],
+                                     const xochip_writer_t writer, void *context)
+{
+    if (!terminal || !palette || !writer)
+    {
+        return XOCHIP_ERR_NULL_POINTER;
+    }
+
+    if ((unsigned)mode >= XOCHIP_TERMINAL_MODE_COUNT || (unsigned)colours >= XOCHIP_TERMINAL_COLOURS_COUNT)
+    {
+        return XOCHIP_ERR_INVALID_ARGUMENT;
+    }
+
+    terminal->writer = writer;
+    terminal->context = context;
+    terminal->mode = mode;
+    terminal->columns = mode == XOCHIP_TERMINAL_QUADRANTS ? XOCHIP_DISPLAY_WIDTH / 2 : XOCHIP_DISPLAY_WIDTH;
+    terminal->result = XOCHIP_SUCCESS;
+    terminal->written = 0;
+    terminal->used = 0;
+    terminal->hires = false;
+    xochip_terminal_invalidate(terminal);
+
+    for (uint32_t pixels = 0; pixels < 256; ++pixels)
+    {
+        terminal->cells[pixels] = xochip_terminal_cell((uint8_t)pixels, palette);
+    }
+
+    // every palette entry takes the nearest standard colour nobody else took, so no two of them look the same
+    uint16_t taken = 0;
+    for (uint8_t colour = 0; colour < 4; ++colour)
+    {
+        if (colours == XOCHIP_TERMINAL_TRUECOLOUR)
+        {
+            const unsigned r = (palette[colour] >> 16) & 0xFF;
+            const unsigned g = (palette[colour] >> 8) & 0xFF;
+            const unsigned b = palette[colour] & 0xFF;
+            snprintf(terminal->colours[0][colour], sizeof(terminal->colours[0][colour]), "48;2;%u;%u;%u", r, g, b);
+            snprintf(terminal->colours[1][colour], sizeof(terminal->colours[1][colour]), "38;2;%u;%u;%u", r, g, b);
+            continue;
+        }
+
+        uint8_t nearest = 0;
+        uint32_t best = UINT32_MAX;
+        for (uint8_t ansi = 0; ansi < 16; ++ansi)
+        {
+            const uint32_t distance = xochip_terminal_distance(palette[colour], xochip_terminal_ansi[ansi]);
+            if (!(taken & (1u << ansi)) && distance < best)
+            {
+                nearest = ansi;
+                best = distance;
+            }
+        }
+        taken |= (uint16_t)(1u << nearest);
+        snprintf(terminal->colours[0][colour], sizeof(terminal->colours[0][colour]), "%u",
+                 nearest < 8 ? 40u + nearest : 100u + nearest - 8);
+        snprintf(terminal->colours[1][colour], sizeof(terminal->colours[1][colour]), "%u",
+                 nearest < 8 ? 30u + nearest : 90u + nearest - 8);
+    }
+
+    return XOCHIP_SUCCESS;
+}
+
+void xochip_terminal_invalidate(xochip_terminal_t *terminal)
+{
+    if (terminal)
+    {
+        terminal->valid = false;
+        terminal->row = 0xFF;
+        terminal->background = 0xFF;
+        terminal->foreground = 0xFF;
+    }
+}
+
+static void xochip_terminal_flush(xochip_terminal_t *terminal)
+{
+    if (terminal->used > 0 && terminal->result == XOCHIP_SUCCESS &&
+        !terminal->writer(terminal->context, terminal->buffer, terminal->used))
+    {
+        terminal->result = XOCHIP_ERR_WRITE;
+    }
+
+    terminal->written += terminal->used;
+    terminal->used = 0;
+}
+
+static void xochip_terminal_write(xochip_terminal_t *terminal, const char *text)
+{
+    const size_t length = strlen(text);
+    if (terminal->used + length > sizeof(terminal->buffer))
+    {
+        xochip_terminal_flush(terminal);
+    }
+    memcpy(terminal->buffer + terminal->used, text, length);
+    terminal->used += length;
+}
+
+// Appends a number in decimal, it's called for nearly every cell and snprintf is slow
+static char *xochip_terminal_number(char *out, unsigned number)
+{
+    char digits[8];
+    uint8_t count = 0;
+    do
+    {
+        digits[count++] = (char)('0' + number % 10);
+        number /= 10;
+    } while (number);
+
+    while (count)
+    {
+        *out++ = digits[--count];
+    }
+    return out;
+}
+
+static char *xochip_terminal_text(char *out, const char *text)
+{
+    while (*text)
+    {
+        *out++ = *text++;
+    }
+    return out;
+}
+
+// Moves the cursor to a cell, forward along the row when that's shorter, and sets the colours the cell needs
+static void xochip_terminal_put(xochip_terminal_t *terminal, const uint8_t row, const uint8_t column,
+                                const uint8_t cell)
+{
+    char sequence[64];
+    char *cursor = sequence;
+
+    if (terminal->row != row || terminal->column > column)
+    {
+        cursor = xochip_terminal_text(cursor, "\x1b[");
+        cursor = xochip_terminal_number(cursor, row + 1u);
+        *cursor++ = ';';
+        cursor = xochip_terminal_number(cursor, column + 1u);
+        *cursor++ = 'H';
+    }
+    else if (terminal->column < column)
+    {
+        cursor = xochip_terminal_text(cursor, "\x1b[");
+        cursor = xochip_terminal_number(cursor, (unsigned)(column - terminal->column));
+        *cursor++ = 'C';
+    }
+
+    // a blank cell only shows the background, whatever the foreground is
+    const uint8_t mask = XOCHIP_TERMINAL_MASK(cell);
+    const uint8_t background = XOCHIP_TERMINAL_BACKGROUND(cell);
+    const uint8_t foreground = XOCHIP_TERMINAL_FOREGROUND(cell);
+    const bool set_background = terminal->background != background;
+    const bool set_foreground = mask && terminal->foreground != foreground;
+    if (set_background || set_foreground)
+    {
+        cursor = xochip_terminal_text(cursor, "\x1b[");
+        cursor = xochip_terminal_text(cursor, set_background ? terminal->colours[0][background] : "");
+        cursor = xochip_terminal_text(cursor, set_background && set_foreground ? ";" : "");
+        cursor = xochip_terminal_text(cursor, set_foreground ? terminal->colours[1][foreground] : "");
+        *cursor++ = 'm';
+        terminal->background = background;
+        terminal->foreground = set_foreground ? foreground : terminal->foreground;
+    }
+
+    cursor = xochip_terminal_text(cursor, xochip_terminal_glyphs[mask]);
+    *cursor = '\0';
+    xochip_terminal_write(terminal, sequence);
+    terminal->shown[row][column] = cell;
+
+    // past the last column the cursor waits to wrap, where exactly depends on the terminal
+    terminal->row = column + 1 < terminal->columns ? row : 0xFF;
+    terminal->column = (uint8_t)(column + 1);
+}
+
+xochip_result_t xochip_terminal_draw(xochip_terminal_t *terminal, const xochip_display_t *display)
+{
+    if (!terminal || !display)
+    {
+        return XOCHIP_ERR_NULL_POINTER;
+    }
+
+    const bool everything = !terminal->valid;
+    if (everything)
+    {
+        xochip_terminal_write(terminal, "\x1b[0m\x1b[?25l\x1b[2J");
+        terminal->valid = true;
+        terminal->row = 0xFF;
+        terminal->background = 0xFF;
+        terminal->foreground = 0xFF;
+    }
+
+    // the planes hold 2 lines per row of cells in high resolution and 1 in low resolution, whose pixels are doubled
+    // when they're read below, so after a switch every row is compared cell by cell
+    const bool switched = terminal->hires != display->hires;
+    terminal->hires = display->hires;
+    const size_t row_bytes = display->hires ? 2 * XOCHIP_DISPLAY_ROW_BYTES : XOCHIP_DISPLAY_ROW_BYTES;
+    for (uint8_t row = 0; row < XOCHIP_TERMINAL_ROWS; ++row)
+    {
+        const size_t offset = row * row_bytes;
+        const bool same = memcmp(terminal->back_plane + offset, display->back_plane + offset, row_bytes) == 0 &&
+                          memcmp(terminal->fore_plane + offset, display->fore_plane + offset, row_bytes) == 0;
+        if (!everything && !switched && same)
+        {
+            continue;
+        }
+        memcpy(terminal->back_plane + offset, display->back_plane + offset, row_bytes);
+        memcpy(terminal->fore_plane + offset, display->fore_plane + offset, row_bytes);
+
+        // 2 bit colours of the top and the bottom line, 8 pixels from a byte of each plane at a time
+        uint8_t colours[2][XOCHIP_DISPLAY_WIDTH];
+        for (uint8_t line = 0; line < 2; ++line)
+        {
+            uint8_t scratch[2][XOCHIP_DISPLAY_ROW_BYTES];
+            const uint8_t *back = xochip_display_row(display, 0, (uint8_t)(row * 2 + line), scratch[0]);
+            const uint8_t *fore = xochip_display_row(display, 1, (uint8_t)(row * 2 + line), scratch[1]);
+            for (uint32_t x = 0; x < XOCHIP_DISPLAY_WIDTH; ++x)
+            {
+                const uint8_t shift = (uint8_t)(7 - x % 8);
+                colours[line][x] = (uint8_t)(((fore[x / 8] >> shift) & 1) << 1 | ((back[x / 8] >> shift) & 1));
+            }
+        }
+
+        for (uint8_t column = 0; column < terminal->columns; ++column)
+        {
+            // a half block is a quadrant cell with both pixels of a line the same
+            const uint8_t left = terminal->mode == XOCHIP_TERMINAL_QUADRANTS ? (uint8_t)(column * 2) : column;
+            const uint8_t right = terminal->mode == XOCHIP_TERMINAL_QUADRANTS ? (uint8_t)(left + 1) : column;
+            const uint8_t pixels = (uint8_t)(colours[0][left] | colours[0][right] << 2 | colours[1][left] << 4 |
+                                             colours[1][right] << 6);
+            const uint8_t cell = terminal->cells[pixels];
+            if (everything || terminal->shown[row][column] != cell)
+            {
+                xochip_terminal_put(terminal, row, column, cell);
+            }
+        }
+    }
+
+    xochip_terminal_flush(terminal);
+    return terminal->result;
+}
+
+xochip_result_t xochip_terminal_finish(xochip_terminal_t *terminal)
+{
+    if (!terminal)
+    {
+        return XOCHIP_ERR_NULL_POINTER;
+    }
+
+    char sequence[32];
+    snprintf(sequence, sizeof(sequence), "\x1b[0m\x1b[%u;1H\x1b[?25h", XOCHIP_TERMINAL_ROWS + 1u);
+    xochip_terminal_write(terminal, sequence);
+    xochip_terminal_invalidate(terminal);
+    xochip_terminal_flush(terminal);
+    return terminal->result;
+}
+
+#endif
+
+#endif // XOCHIP_TERMINAL_H